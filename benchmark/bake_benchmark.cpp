@@ -0,0 +1,367 @@
+// Bake benchmark
+//
+// Times every stage of a bake on its own, over the open-license fonts in benchmark/fonts (see OFL.txt) at
+// 12, 48, 72 and 200pt, r8, the default glyphs, one thread:
+//
+//   parse     'ttf_loadfont' on the mapped truetype file.
+//   raster    every glyph's outline ('ttf_glyphoutline') rasterized into the glyph surface ('raster_outline').
+//   trim      the bounds of every rasterized surface and the copy of the glyph ('bake_loadglyph').
+//   assemble  packing the atlas ('bake_packatlas') and copying every glyph into it ('bake_writeglyph').
+//   uv        the uvs of every glyph ('bake_glyphuv').
+//   output    the .font and .bmp ('bake_writefont'), written by the output thread (not flushed).
+//   bake      the whole bake the command line does ('bake_font'), from the settings to the files written.
+//
+// Then every font at every size as one manifest ('bake_manifest'), on every thread (or 'threads'):
+//
+//   batch     the jobs spread over the threads, the files written.
+//
+// Every stage runs once to warm up, then 'iterations' times ('parse' and 'uv' 'BENCHMARK_REPEATS' times
+// per iteration, they're too short to time alone). Prints the median and the 95th percentile of a run,
+// glyphs per second and MB per second (of the truetype file, the surfaces, the atlas, the glyph headers
+// and the files). Compare runs on the same machine only.
+//
+// build (linux):
+// g++ -O2 -I<path to Handmade> benchmark/bake_benchmark.cpp -o "build/bake_benchmark" -lm -pthread
+//
+// usage (from the repository):
+// bake_benchmark [iterations] [fonts directory] [output directory] [threads]
+//
+
+#define ATLAS_BAKED_NO_MAIN
+#include "../source/atlas_baked_linux.cpp"
+
+#include <chrono>
+
+#define BENCHMARK_FONTS  3
+#define BENCHMARK_SIZES  4
+#define BENCHMARK_STAGES 8
+#define BENCHMARK_REPEATS 100 // runs of the stages that take about as long as reading the clock.
+
+global const s8* benchmark_fonts[BENCHMARK_FONTS] = { "Lato-Regular.ttf", "Lato-LightItalic.ttf", "SourceCodePro-Regular.ttf" };
+global r32       benchmark_points[BENCHMARK_SIZES] = { 12.0f, 48.0f, 72.0f, 200.0f };
+
+#define BENCHMARK_PARSE    0
+#define BENCHMARK_RASTER   1
+#define BENCHMARK_TRIM     2
+#define BENCHMARK_ASSEMBLE 3
+#define BENCHMARK_UV       4
+#define BENCHMARK_OUTPUT   5
+#define BENCHMARK_BAKE     6
+#define BENCHMARK_BATCH    7
+global const s8* benchmark_stages[BENCHMARK_STAGES] = { "parse", "raster", "trim", "assemble", "uv", "output", "bake", "batch" };
+
+internal r64
+benchmark_seconds()
+{
+    return(std::chrono::duration<r64>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+internal s32
+benchmark_compare(const void* a, const void* b)
+{
+    r64 x = *(const r64*)a;
+    r64 y = *(const r64*)b;
+    return((x > y) - (x < y));
+}
+// median, 95th percentile and throughput of one stage ('times' is sorted).
+internal void
+benchmark_report(const s8* font, const s8* size, s32 stage, r64* times, s32 iterations, s32 glyphs, u64 bytes)
+{
+    qsort(times, iterations, sizeof(r64), benchmark_compare);
+    r64 median = times[(iterations - 1) / 2];
+    r64 p95    = times[((iterations * 95) + 99) / 100 - 1];
+    if(median <= 0.0) { median = 1e-9; } // under the clock's resolution.
+
+    s8 glyph_rate[32] = "-"; // 'parse' doesn't touch glyphs.
+    if(glyphs) { snprintf(glyph_rate, sizeof(glyph_rate), "%.0f", glyphs / median); }
+
+    printf("%-26s %5s %-9s %12.3f %12.3f %14s %11.1f\n", font, size, benchmark_stages[stage],
+	   median * 1e6, p95 * 1e6, glyph_rate, (bytes / median) / (1024.0 * 1024.0));
+}
+
+s32
+main(s32 argument_count, s8** arguments)
+{
+    s32 iterations = (argument_count > 1) ? atoi(arguments[1]) : 20;
+    s8* fonts      = (argument_count > 2) ? arguments[2] : (s8*)"benchmark/fonts";
+    s8* output_dir = (argument_count > 3) ? arguments[3] : (s8*)"build";
+    if(iterations < 1) { iterations = 1; }
+    bake_threads = (argument_count > 4) ? atoi(arguments[4]) : 0; // the batch's, 0 = one per core.
+
+    simd_startup(SIMD_BEST);
+    work_startup(1);
+    platform_makedirectory(output_dir);
+
+    printf("simd: %s, 1 thread, %d iterations\n\n", simd.name, iterations);
+    printf("%-26s %5s %-9s %12s %12s %14s %11s\n", "font", "pt", "stage", "median us", "p95 us", "glyphs/s", "MB/s");
+
+    bake_job* job = (bake_job*)calloc(1, sizeof(bake_job));
+    job->format = FONT_FORMAT_R8;
+    snprintf(job->font_file,   MAX_PATH, "%s/bake_benchmark.font", output_dir);
+    snprintf(job->bitmap_file, MAX_PATH, "%s/bake_benchmark.bmp",  output_dir);
+
+    r64*  times   = (r64*)malloc(iterations * sizeof(r64));
+    arena memory  = {}; // one size of one font.
+    arena scratch = {}; // one run of a stage.
+
+    // the batch has every font that opened, at every size.
+    s8  manifest[BENCHMARK_FONTS * (MAX_PATH * 2 + 64)];
+    s32 manifest_size = 0;
+    s32 batch_glyphs  = 0;
+    u64 batch_bytes   = 0;
+
+    b32 success = true;
+    for(s32 f = 0; f < BENCHMARK_FONTS; f++)
+    {
+	s8 path[MAX_PATH];
+	snprintf(path, MAX_PATH, "%s/%s", fonts, benchmark_fonts[f]);
+
+	bake_source source = {};
+	if(!bake_opensource(&source, path))
+	{
+	    printf("%-26s missing or malformed, skipped\n", benchmark_fonts[f]);
+	    success = false;
+	    continue;
+	}
+	manifest_size += snprintf(manifest + manifest_size, sizeof(manifest) - manifest_size, "\"%s\" %.0f,%.0f,%.0f,%.0f \"%s/bake_benchmark_%d_{size}.font\"\n",
+				  path, benchmark_points[0], benchmark_points[1], benchmark_points[2], benchmark_points[3], output_dir, f);
+	for(s32 i = -1; i < iterations; i++)
+	{
+	    b32 loaded = true;
+	    r64 start  = benchmark_seconds();
+	    for(s32 repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+	    {
+		ttf_font font = {};
+		loaded = ttf_loadfont(&font, source.file.data, source.file.size) && loaded;
+	    }
+	    r64 elapsed = (benchmark_seconds() - start) / BENCHMARK_REPEATS;
+	    if(!loaded) { success = false; }
+	    if(i >= 0) { times[i] = elapsed; }
+	}
+	benchmark_report(benchmark_fonts[f], "-", BENCHMARK_PARSE, times, iterations, 0, source.file.size);
+
+	for(s32 s = 0; s < BENCHMARK_SIZES; s++)
+	{
+	    r32 points = benchmark_points[s];
+	    s32 pixels = (s32)((points/72)*96*(DPI/96.0f));
+	    s8  size[16];
+	    snprintf(size, sizeof(size), "%.0f", points);
+
+	    // the glyphs as a bake has them, for the stages after rasterizing.
+	    bake_atlas* atlas = (bake_atlas*)arena_pushzero(&memory, sizeof(bake_atlas));
+	    atlas->glyph_width  = pixels;
+	    atlas->glyph_height = pixels;
+	    atlas->format       = FONT_FORMAT_R8;
+	    atlas->glyph_count  = bake_defaultset(&memory, &atlas->codepoints);
+	    s32 glyph_count = atlas->glyph_count;
+
+	    u8**       glyphs  = (u8**)         arena_pushzero(&memory, glyph_count * sizeof(u8*));
+	    pack_rect* rects   = (pack_rect*)   arena_push    (&memory, glyph_count * sizeof(pack_rect));
+	    s32*       pending = (s32*)         arena_push    (&memory, glyph_count * sizeof(s32));
+	    atlas->glyphs      = (glyph_header*)arena_pushzero(&memory, glyph_count * sizeof(glyph_header));
+	    for(s32 g = 0; g < glyph_count; g++) { pending[g] = g; }
+
+	    if(!bake_loadfont(atlas, &source.font, points/2.0f, pixels/2, glyphs, pending, glyph_count))
+	    {
+		printf("%-26s %5s 'bake_loadfont' failed, skipped\n", benchmark_fonts[f], size);
+		success = false;
+		bake_resetmemory();
+		arena_reset(&memory);
+		continue;
+	    }
+	    s32 ascent = (s32)((source.font.ascent * atlas->scale) + 0.5f);
+
+	    // raster, the same surface 'bake_rasterglyph' draws into. the last run's surfaces are kept for 'trim'.
+	    raster_surface surface = {};
+	    surface.width        = (pixels/2) * 2;
+	    surface.height       = (pixels/2) * 2;
+	    surface.pixels       = (u8*) arena_push(&memory, surface.width * surface.height);
+	    surface.accumulation = (r32*)arena_push(&memory, ((surface.width * surface.height) + 1) * sizeof(r32));
+
+	    ttf_outline outline = {};
+	    outline.point_capacity   = source.font.max_points;
+	    outline.contour_capacity = source.font.max_contours;
+	    outline.points           = (ttf_point*)arena_push(&memory, outline.point_capacity * sizeof(ttf_point));
+	    outline.contour_ends     = (s32*)      arena_push(&memory, outline.contour_capacity * sizeof(s32));
+
+	    u64 surface_bytes = (u64)surface.width * surface.height;
+	    u8* surfaces      = (u8*)arena_push(&memory, surface_bytes * glyph_count);
+
+	    for(s32 i = -1; i < iterations; i++)
+	    {
+		r64 start = benchmark_seconds();
+		for(s32 g = 0; g < glyph_count; g++)
+		{
+		    s32 glyph = ttf_glyphindex(&source.font, atlas->codepoints[g]);
+		    if(!ttf_glyphoutline(&source.font, glyph, &outline)) { outline.contour_count = 0; }
+
+		    s32 left     = (s32)floorf(outline.x_min * atlas->scale);
+		    r32 origin_x = (left < 0) ? (r32)-left : 0.0f;
+		    r32 origin_y = (r32)(surface.height - ascent);
+		    raster_outline(&surface, &outline, atlas->scale, origin_x, origin_y);
+
+		    if(i == (iterations - 1))
+		    {
+			r64 paused = benchmark_seconds();
+			mem_copy(surface.pixels, surfaces + (g * surface_bytes), surface_bytes);
+			start += benchmark_seconds() - paused;
+		    }
+		}
+		if(i >= 0) { times[i] = benchmark_seconds() - start; }
+	    }
+	    benchmark_report(benchmark_fonts[f], size, BENCHMARK_RASTER, times, iterations, glyph_count, surface_bytes * glyph_count);
+
+	    // trim.
+	    for(s32 i = -1; i < iterations; i++)
+	    {
+		r64 start = benchmark_seconds();
+		for(s32 g = 0; g < glyph_count; g++)
+		{
+		    s32 offset, width, height;
+		    bake_loadglyph(surfaces + (g * surface_bytes), &scratch, pixels/2, ascent, &offset, &width, &height);
+		}
+		if(i >= 0) { times[i] = benchmark_seconds() - start; }
+		arena_reset(&scratch);
+	    }
+	    benchmark_report(benchmark_fonts[f], size, BENCHMARK_TRIM, times, iterations, glyph_count, surface_bytes * glyph_count);
+
+	    // assemble, like 'bake_blitglyph' without bleed or uvs.
+	    s32 padding = 1;
+	    u64 atlas_bytes = 0;
+	    for(s32 i = -1; i < iterations; i++)
+	    {
+		r64 start = benchmark_seconds();
+		if(!bake_packatlas(atlas, rects, padding, 1, 0, &scratch)) { success = false; }
+
+		atlas_bytes = (u64)atlas->width * atlas->height;
+		u8* atlas_pixels = (u8*)arena_pushzero(&scratch, atlas_bytes);
+		for(s32 g = 0; atlas_pixels && g < glyph_count; g++)
+		{
+		    if(!rects[g].packed) { continue; }
+
+		    glyph_header* header = &atlas->glyphs[g];
+		    u8* target = atlas_pixels + ((rects[g].y + padding) * atlas->width) + (rects[g].x + padding);
+		    bake_writeglyph(glyphs[g], header->width, header->height, header->width, target, atlas->width);
+		}
+		if(i >= 0) { times[i] = benchmark_seconds() - start; }
+		arena_reset(&scratch);
+	    }
+	    benchmark_report(benchmark_fonts[f], size, BENCHMARK_ASSEMBLE, times, iterations, glyph_count, atlas_bytes);
+
+	    // uv.
+	    for(s32 i = -1; i < iterations; i++)
+	    {
+		r64 start = benchmark_seconds();
+		for(s32 repeat = 0; repeat < BENCHMARK_REPEATS; repeat++)
+		{
+		    for(s32 g = 0; g < glyph_count; g++)
+		    {
+			if(rects[g].packed) { bake_glyphuv(atlas, &atlas->glyphs[g], rects[g].x + padding, rects[g].y + padding); }
+		    }
+		}
+		if(i >= 0) { times[i] = (benchmark_seconds() - start) / BENCHMARK_REPEATS; }
+	    }
+	    benchmark_report(benchmark_fonts[f], size, BENCHMARK_UV, times, iterations, glyph_count, glyph_count * sizeof(glyph_header));
+
+	    // output, from the atlas the bake itself would have built.
+	    bake_alignglyphs(atlas);
+	    if(!bake_kerning(atlas, &source.font, &memory))
+	    {
+		atlas->kerning    = 0;
+		atlas->pair_count = 0;
+	    }
+	    atlas->level_count = 1;
+
+	    bake_blitjob blit = {};
+	    blit.atlas   = atlas;
+	    blit.pixels  = (u8*)arena_pushzero(&memory, atlas_bytes);
+	    blit.glyphs  = glyphs;
+	    blit.rects   = rects;
+	    blit.padding = padding;
+	    if(blit.pixels) { work_run(glyph_count, bake_blitglyph, &blit); }
+	    else            { success = false; }
+
+	    output_startup();
+	    u64 file_bytes = 0;
+	    for(s32 i = -1; blit.pixels && i < iterations; i++)
+	    {
+		r64 start = benchmark_seconds();
+		output_request* request = output_begin();
+		if(bake_writefont(job, atlas, blit.pixels, request))
+		{
+		    file_bytes = 0;
+		    for(s32 file = 0; file < request->file_count; file++)
+		    {
+			for(s32 b = 0; b < request->files[file].buffer_count; b++)
+			{
+			    file_bytes += request->files[file].buffers[b].size;
+			}
+		    }
+		    request->written = &job->written;
+		    output_submit(request);
+		    output_wait();
+		    success = success && job->written;
+		}
+		else
+		{
+		    output_cancel(request);
+		    success = false;
+		}
+		if(i >= 0) { times[i] = benchmark_seconds() - start; }
+	    }
+	    benchmark_report(benchmark_fonts[f], size, BENCHMARK_OUTPUT, times, iterations, glyph_count, file_bytes);
+	    output_shutdown();
+
+	    // bake, the command line's settings for this font and size (it starts its own output thread).
+	    snprintf(open_file, MAX_PATH, "%s", path);
+	    snprintf(save_file, MAX_PATH, "%s/bake_benchmark.font", output_dir);
+	    bitmap_path(save_file, bitmap_file);
+	    snprintf(fontheight_field, sizeof(fontheight_field), "%s", size);
+	    for(s32 i = -1; i < iterations; i++)
+	    {
+		r64 start = benchmark_seconds();
+		if(!bake_font()) { success = false; }
+		if(i >= 0) { times[i] = benchmark_seconds() - start; }
+	    }
+	    benchmark_report(benchmark_fonts[f], size, BENCHMARK_BAKE, times, iterations, glyph_count, file_bytes);
+	    batch_glyphs += glyph_count;
+	    batch_bytes  += file_bytes;
+
+	    bake_resetmemory();
+	    arena_reset(&memory);
+	}
+	printf("\n");
+	bake_closesource(&source);
+    }
+
+    // batch.
+    work_shutdown();
+    work_startup(bake_threads);
+    snprintf(manifest_file, MAX_PATH, "%s/bake_benchmark.txt", output_dir);
+    if(manifest_size && platform_writefile(manifest_file, manifest_size, manifest))
+    {
+	printf("%d threads\n", work.thread_count);
+	for(s32 i = -1; i < iterations; i++)
+	{
+	    s32 baked = 0;
+	    s32 jobs  = 0;
+	    r64 start = benchmark_seconds();
+	    if(!bake_manifest(manifest_file, &baked, &jobs)) { success = false; }
+	    if(i >= 0) { times[i] = benchmark_seconds() - start; }
+	}
+	benchmark_report("every font", "all", BENCHMARK_BATCH, times, iterations, batch_glyphs, batch_bytes);
+    }
+    else
+    {
+	success = false;
+    }
+
+    work_shutdown();
+    bake_releasememory();
+    arena_release(&memory);
+    arena_release(&scratch);
+    free(times);
+    free(job);
+
+    if(!success) { fputs("failed!\n", stderr); }
+    return(success ? 0 : 1);
+}
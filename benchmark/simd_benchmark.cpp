@@ -0,0 +1,164 @@
+// SIMD benchmark
+//
+// Times every kernel of atlas_baked_simd.cpp at every level the CPU supports, on glyph sized
+// surfaces (2 * pixels square, like 'bake_loadglyph' sees them), and checks the output against scalar.
+//
+// build:
+// g++ -O2 -I<path to Handmade> benchmark/simd_benchmark.cpp -o "build/simd_benchmark"
+//
+// usage:
+// simd_benchmark [iterations]
+//
+
+#include "handmade.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#include "../source/atlas_baked_simd.cpp"
+
+#define BENCHMARK_SIZES 4
+
+internal r64
+benchmark_seconds()
+{
+    return(std::chrono::duration<r64>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+// a filled, anti-aliased ring in the middle of the surface, roughly where a glyph lands.
+internal void
+benchmark_surface(r32* accumulation, u8* coverage, s32 size)
+{
+    r32 centre = size * 0.4f;
+    r32 outer  = size * 0.25f;
+    r32 inner  = size * 0.12f;
+    for(s32 y = 0; y < size; y++)
+    {
+	for(s32 x = 0; x < size; x++)
+	{
+	    r32 dx = x - centre;
+	    r32 dy = y - centre;
+	    r32 d  = sqrtf((dx * dx) + (dy * dy));
+	    r32 c  = fminf(outer - d, d - inner) + 0.5f;
+	    c = (c < 0.0f) ? 0.0f : ((c > 1.0f) ? 1.0f : c);
+	    accumulation[(y * size) + x] = ((x + y) & 1) ? c : -c; // the sign shouldn't matter.
+	    coverage[(y * size) + x]     = (u8)((c * 255.0f) + 0.5f);
+	}
+    }
+}
+
+s32
+main(s32 argument_count, s8** arguments)
+{
+    s32 iterations = (argument_count > 1) ? atoi(arguments[1]) : 200;
+    if(iterations < 1) { iterations = 1; }
+
+    // pixels = (points/72)*96, at 12pt, 48pt, 72pt and 200pt.
+    s32 pixel_sizes[BENCHMARK_SIZES] = { 16, 64, 96, 266 };
+
+    s32 best = simd_startup(SIMD_BEST);
+    printf("best level: %s, %d iterations\n\n", simd.name, iterations);
+    printf("%-8s %-9s %6s %12s %10s\n", "kernel", "level", "size", "ns/glyph", "speedup");
+
+    b32 matched = true;
+    for(s32 s = 0; s < BENCHMARK_SIZES; s++)
+    {
+	s32 size  = pixel_sizes[s] * 2;
+	s32 count = size * size;
+
+	r32* accumulation = (r32*)malloc(count * sizeof(r32));
+	u8*  coverage     = (u8*) malloc(count);
+	u8*  target       = (u8*) malloc(count * 4);
+	u8*  reference    = (u8*) malloc(count * 4);
+	u8*  expanded     = (u8*) malloc(count * 4);
+	benchmark_surface(accumulation, coverage, size);
+
+	const s8* kernels[6] = { "bounds", "coverage", "expand", "copy", "halve", "halve4" };
+	for(s32 k = 0; k < 6; k++)
+	{
+	    r64 scalar_time = 0.0;
+	    for(s32 level = SIMD_SCALAR; level <= best; level++)
+	    {
+		simd_startup(level);
+
+		s32 bounds[4] = {};
+		r64 start = benchmark_seconds();
+		for(s32 i = 0; i < iterations; i++)
+		{
+		    switch(k)
+		    {
+		    case 0:
+		    {
+			bounds[0] = size; bounds[1] = 0; bounds[2] = size; bounds[3] = 0;
+			simd.bounds(coverage, size, size, size, &bounds[0], &bounds[1], &bounds[2], &bounds[3]);
+		    }break;
+		    case 1:
+		    {
+			simd.coverage(accumulation, target, count);
+		    }break;
+		    case 2:
+		    {
+			simd.expand(coverage, (u32*)expanded, count);
+		    }break;
+		    case 3:
+		    {
+			// one glyph's worth of row copies (what 'bake_writeglyph' does), half the surface wide.
+			for(s32 row = 0; row < (size / 2); row++)
+			{
+			    simd.copy(coverage + (row * size) + 3, target + (row * (size / 2)), size / 2);
+			}
+		    }break;
+		    case 4:
+		    {
+			// one mip level of the surface (r8), 'target' is a quarter of it.
+			for(s32 row = 0; row < (size / 2); row++)
+			{
+			    simd.halve(coverage + (row * 2 * size), size, target + (row * (size / 2)), size / 2, 1);
+			}
+		    }break;
+		    case 5:
+		    {
+			// the same for four bytes per pixel (msdf), 'expanded' holds the surface.
+			for(s32 row = 0; row < (size / 2); row++)
+			{
+			    simd.halve(expanded + (row * 2 * size * 4), size * 4, target + (row * (size / 2) * 4), size / 2, 4);
+			}
+		    }break;
+		    }
+		}
+		r64 elapsed = (benchmark_seconds() - start) / iterations;
+		if(level == SIMD_SCALAR) { scalar_time = elapsed; }
+
+		// every level has to agree with scalar.
+		u8* output = (k == 2) ? expanded : target;
+		s32 output_size = (k == 2) ? (count * 4) : ((k == 1) ? count : ((size / 2) * (size / 2)));
+		if(k == 5) { output_size *= 4; }
+		if(k == 0)
+		{
+		    output = (u8*)bounds;
+		    output_size = sizeof(bounds);
+		}
+		if(level == SIMD_SCALAR)
+		{
+		    memcpy(reference, output, output_size);
+		}
+		else if(memcmp(reference, output, output_size) != 0)
+		{
+		    printf("mismatch: %s (%s, %d)\n", kernels[k], simd.name, size);
+		    matched = false;
+		}
+
+		printf("%-8s %-9s %6d %12.0f %9.2fx\n", kernels[k], simd.name, size, elapsed * 1e9, scalar_time / elapsed);
+	    }
+	}
+	printf("\n");
+
+	free(accumulation);
+	free(coverage);
+	free(target);
+	free(reference);
+	free(expanded);
+    }
+
+    return(matched ? 0 : 1);
+}
@@ -0,0 +1,2780 @@
+// Tedious Typography
+//
+// Font sizes can be specified in points (pt), 1 pt = 1/72 inch (0.35 mm).
+//
+// The font size (height) is broken up into the ascent and descent.
+// Ascent is the space above the baseline.
+// Descent is the space below the baseline.
+//
+// Font size = Ascent + Descent
+// e.g A 72pt font may have an ascent of 56pt and descent of 16pt, thus 72pt = (56pt + 16pt)
+//
+// Font sizes can also be specified in logical units,
+// 1 logical unit = 72pt (1 inch, 2.54 cm).
+// 1 logical unit = DPI (px) (historically 96 px, but can be set on a user by user basis)
+// e.g DPI setting of 100% (96 px), DPI setting of 125% (120 px), DPI setting of 150% (144 px)
+//
+// Font sizes can also be specified in device independent pixels (DIPs), 1 DIP = 1/96 logical unit.
+// Therefore,
+// 1 inch = 72 pt = 1 logical unit = 96 px (DPI, 100%)  = 1 DIP
+// 1 inch = 72 pt = 1 logical unit = 144 px (DPI, 150%) = 1.5 DIP
+//
+// to get the font size in pixels given points:
+// pixels = (points/72)*96*(DPI/96)
+//
+// Atlas Baked (platform independent)
+//
+// Everything from the truetype file to the .font/.bmp output lives here, the platform layers
+// (atlas_baked_windows.cpp, atlas_baked_linux.cpp) provide the 'platform_' functions below
+// and include this file.
+//
+
+#include "atlas_baked_simd.cpp"
+#include "atlas_baked_ttf.cpp"
+#include "atlas_baked_sdf.cpp"
+#include "atlas_baked_bc4.cpp"
+#include "atlas_baked_lz.cpp"
+#include "atlas_baked_work.cpp"
+#include "atlas_baked_pack.cpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <chrono>
+
+global s8   open_file[MAX_PATH] = { };
+global s8   save_file[MAX_PATH] = { };
+global s8 bitmap_file[MAX_PATH] = { };
+
+global s8  manifest_file[MAX_PATH] = { }; // -m, batch mode.
+global s8     bake_cache[MAX_PATH] = { }; // -c, cache directory (empty = no cache).
+global s8    bake_report[MAX_PATH] = { }; // -o, json report of every bake ("-" = standard output, empty = none).
+#ifndef ATLAS_BAKED_NO_MAIN
+global s8 server_address[MAX_PATH] = { }; // -w, serve bake requests there ("-" = standard input), see atlas_baked_server.cpp.
+#endif
+
+#define BAKE_MAX_RANGES 512
+global s8 bake_ranges[BAKE_MAX_RANGES] = { }; // -u, unicode ranges (empty = ' ' -> 'y diaeresis' of the ansi code page).
+
+// -h"12+24+48", sizes joined by '+' share one atlas.
+#define BAKE_MAX_SIZES 8
+global s8 fontheight_field[BAKE_MAX_SIZES * 4] = { };
+
+global u32 DPI = 96;
+
+global s32 bake_threads;     // -j, 0 = one per core.
+global s32 bake_padding = 1; // -p, empty pixels around every glyph (each side).
+global s32 bake_bleed;       // -b, edge pixels repeated into the padding (<= padding).
+global s32 bake_spread = 4;  // -r, pixels a distance field reaches out from the edge (sdf, msdf).
+global s32 bake_levels = 1;  // -l, mip levels including the atlas itself (1 = no mips).
+global s32 bake_quality = 1; // -q, bc4 encoder, 0 (fastest) -> 2 (best).
+global s32 bake_chunk;       // -z, KiB per compressed chunk of the payload (0 = uncompressed).
+global b32 bake_flush;       // -y, the outputs are flushed to the disk before a bake is done.
+global b32 bake_embed;       // -e, every .font is also written as a c++ header (.h), see atlas_baked_embed.cpp.
+global s32 bake_maxtexture;  // -x, most pixels on either side of a texture, glyphs that don't fit go on the next (0 = one texture).
+
+// platform.
+struct platform_file
+{
+    void* data;
+    u32   size;
+};
+struct platform_buffer
+{
+    void* data;
+    u64   size;
+};
+internal void*         platform_allocate(u64 size); // zeroed.
+internal void          platform_deallocate(void* memory);
+internal platform_file platform_readfile(s8* path);
+internal void          platform_freefile(platform_file file);
+internal platform_file platform_mapfile(s8* path); // read-only, writing to it faults.
+internal void          platform_unmapfile(platform_file file);
+internal b32           platform_writefile(s8* path, u64 size, void* data);
+internal b32           platform_writebuffers(s8* path, platform_buffer* buffers, s32 count, b32 flush); // in order, not copied.
+internal b32           platform_fileexists(s8* path);
+#ifndef ATLAS_BAKED_NO_MAIN
+internal u64           platform_filetime(s8* path); // last write, 0 = no such file.
+#endif
+internal b32           platform_makedirectory(s8* path); // true if it already exists.
+internal void          platform_debugprint(const s8* message);
+internal b32           platform_print(const s8* text, u64 size); // standard output.
+
+#include "atlas_baked_arena.cpp"
+#include "atlas_baked_cache.cpp"
+#include "atlas_baked_output.cpp"
+
+// one arena per worker (thread 0 is also the caller of 'bake_font'), reset after every bake.
+global arena bake_arenas[WORK_MAX_THREADS];
+
+struct bake_memory
+{
+    u64 peak;        // bytes in use at the busiest point of the last bake.
+    u64 reserved;    // bytes held from the os at the end of it.
+    u32 allocations; // os allocations it made.
+};
+global bake_memory bake_lastmemory;
+global s32         bake_lastcached; // jobs of the last bake that came from the cache.
+
+// a truetype file read and parsed once, shared (read only) by every size baked from it.
+struct bake_source
+{
+    platform_file file;
+    ttf_font      font;
+    u64           hash; // of the file, with a cache only.
+    s8*           path; // not copied.
+};
+// where a bake spent its time, for the report (-o).
+#define BAKE_STAGE_CACHE   0 // looking up the bake and the glyphs, storing new glyphs.
+#define BAKE_STAGE_RASTER  1 // outlines, rasterizing, trimming ('bake_loadfont').
+#define BAKE_STAGE_PACK    2
+#define BAKE_STAGE_KERNING 3
+#define BAKE_STAGE_WAIT    4 // for an output request, all of them still being written.
+#define BAKE_STAGE_BLIT    5 // glyphs into the atlas, mips.
+#define BAKE_STAGE_ENCODE  6 // bc4, compression, headers ('bake_writefont').
+#define BAKE_STAGE_WRITE   7 // the files, on the output thread.
+#define BAKE_STAGE_COUNT   8
+struct bake_stats
+{
+    r64 seconds[BAKE_STAGE_COUNT];
+    r64 total; // 'bake_run' from start to end, the write happens after it.
+
+    s32 glyph_count;
+    s32 rasterized; // the rest came from the glyph cache.
+    s32 pair_count;
+    s32 width;
+    s32 height;
+    s32 texture_count;
+    u64 glyph_area; // pixels of the glyphs themselves.
+    u64 rect_area;  // the same with padding and alignment.
+
+    u64 font_bytes;
+    u64 bitmap_bytes;
+};
+// one size of one font.
+struct bake_job
+{
+    bake_source* source;
+
+    s8   font_file[MAX_PATH];
+    s8 bitmap_file[MAX_PATH];
+    s8 header_file[MAX_PATH]; // -e, empty = no header.
+
+    r32 points[BAKE_MAX_SIZES]; // every size is in the one atlas.
+    s32 size_count;
+    u32 format;
+    s32 padding;
+    s32 bleed;
+    s32 spread;
+    s32 levels;
+    s32 quality;
+    s32 chunk_size; // bytes, 0 = uncompressed.
+    b32 flush;
+    s32 max_texture; // pixels, 0 = no limit.
+    s8  ranges[BAKE_MAX_RANGES];
+    s8  cache[MAX_PATH]; // directory, empty = no cache.
+
+    s32         thread; // the one it was baked from.
+    b32         success; // baked, the files are written in the background.
+    b32         written; // the files are written, only known after 'output_wait' or 'output_shutdown'.
+    b32         cached;  // copied from the cache, nothing was baked.
+    bake_memory memory;
+    bake_stats  stats;
+};
+
+#pragma pack(push, 1)
+// bitmap.
+struct bitmap_header
+{
+    u16   signature; // must be 'BM' (0x4d42)
+    u32   file_size;
+    u16  reserved_0; // must be 0
+    u16  reserved_1; // must be 0
+    u32 byte_offset; // offset into the file the actual pixel array begins (after the palette, if any)
+
+    u32 header_size; // sizeof(BITMAPINFOHEADER)
+    s32       width;
+    s32      height; // positive (bottom-up DIB)
+
+    u16 planes;              // must be 1
+    u16 bits_per_pixel;      // 8 (palettized) or 32
+    u32 compression;         // BI_RGB
+    u32 image_size;          // may be 0 for BI_RGB
+    s32 x_pixels_per_meter;  // must be 0 (no preference)
+    s32 y_pixels_per_meter;  // must be 0 (no preference)
+    u32        used_colours; // must be 0
+    u32 significant_colours; // must be 0
+};
+// font.
+#define GLYPH_COUNT   233 // the original layout, ' '(32) -> 'y diaeresis'(255) and 9 empty ones.
+struct glyph_header
+{
+    s8  character; // ansi code page (1252), 0 when the codepoint isn't in it (see 'codepoint_offset').
+    s32 offset;
+
+    s32     spacing;
+    s32 pre_spacing;
+
+    s32  width;
+    s32 height;
+
+    r32 u0;
+    r32 u1;
+    r32 v0;
+    r32 v1;
+};
+struct font_header
+{
+    s32   size;
+    s32  width;
+    s32 height;
+    s32 glyph_count;
+
+    s32 glyph_height;
+    s32 glyph_width;
+
+    s32 line_spacing;
+
+    s32 glyph_offset;
+    s32  byte_offset;
+
+    glyph_header glyphs[GLYPH_COUNT];
+};
+// versioned .font (version 2 ->), readers check 'magic' first.
+// files without it are the original layout above (font_header + rgba32 pixels), still written for older readers.
+#define FONT_MAGIC   0x534c5441 // 'ATLS'
+#define FONT_VERSION 9
+
+#define FONT_FORMAT_RGBA32 0 // a | a << 8 | a << 16 | a << 24, only ever in the original layout.
+#define FONT_FORMAT_R8     1 // coverage only.
+#define FONT_FORMAT_SDF    2 // signed distance, one byte (0.5 is the edge, see 'spread').
+#define FONT_FORMAT_MSDF   3 // rgb multi-channel signed distance (median), a = 'FONT_FORMAT_SDF'.
+#define FONT_FORMAT_BC4    4 // coverage in 4x4 blocks of 8 bytes (bc4 unorm), see atlas_baked_bc4.cpp.
+
+#define FONT_MAX_LEVELS 16
+
+#define FONT_COMPRESSION_NONE 0
+#define FONT_COMPRESSION_LZ4  1 // chunks in the lz4 block format, see atlas_baked_lz.cpp.
+
+struct font_fileheader
+{
+    u32 magic;
+    u16 version;
+    u16 format;
+    u32 header_size; // sizeof(font_fileheader), newer versions only ever append fields.
+
+    s32   size;
+    s32  width;
+    s32 height;
+    s32 glyph_count;
+
+    s32 glyph_height;
+    s32 glyph_width;
+
+    s32 line_spacing;
+
+    s32 glyph_offset; // glyph_header[glyph_count]
+    s32  byte_offset; // width * height pixels, rows bottom-up (mip level 0).
+
+    // version 3 ->
+    s32 codepoint_offset; // u32[glyph_count], unicode.
+    s32    lookup_offset; // codepoint -> glyph, see 'bake_buildlookup'.
+    s32    lookup_size;
+    s32      page_count;  // codepoints below 'page_count * 256' may have a glyph.
+
+    // version 4 ->
+    s32 spread; // sdf, msdf: pixels from the edge to 0 (outside) and 255 (inside), glyphs are that much bigger on every side.
+
+    // version 5 ->
+    s32 level_count;                   // mip levels, 1 = just the atlas.
+    s32 level_offsets[FONT_MAX_LEVELS]; // level n is (width >> n) * (height >> n) pixels (or their blocks), [0] = 'byte_offset'.
+
+    // version 6 ->
+    // compressed, the levels (the payload) are only in the chunks: 'byte_offset' is 0 and 'level_offsets' are
+    // offsets into the payload once it's decompressed. every chunk is 'chunk_size' bytes of it (the last one
+    // what's left) and decompresses on its own.
+    u32 compression;  // FONT_COMPRESSION_
+    s32 payload_size; // every level, uncompressed.
+    s32 chunk_size;
+    s32 chunk_count;
+    s32 chunk_offset; // u32[chunk_count + 1], where every chunk starts in the file, the last one is the end.
+
+    // version 7 ->
+    // the kerning pairs of glyph n are 'pairs[kerning[n]]' -> 'pairs[kerning[n + 1]]', sorted by the second
+    // glyph. both offsets are 0 when the font has no kerning (between the baked glyphs).
+    s32 kerning_offset; // u32[glyph_count + 1]
+    s32    pair_offset; // font_kernpair[pair_count]
+    s32    pair_count;
+
+    // version 8 ->
+    // more than one size in the atlas: the glyphs, codepoints and kerning are every size's, one size after another.
+    // the header's own metrics and lookup are the first size's, 'font_size' has every size's.
+    s32 size_count;  // 1 = one size, no table.
+    s32 size_offset; // font_size[size_count], 0 with one size.
+
+    // version 9 ->
+    // more than one texture (-x): every one is 'width' x 'height' with mips of its own, one texture after another in
+    // the payload, so texture t's level n is at 'level_offsets[n] + (t * texture_size)'. compressed, every texture
+    // is cut into chunks of its own (no chunk straddles two), 'chunk_count / texture_count' each.
+    s32 texture_count;  // 1 = one texture, no table.
+    s32 texture_size;   // payload bytes of one texture, every level.
+    s32 texture_offset; // u16[glyph_count], the texture of every glyph. 0 with one texture.
+};
+struct font_size
+{
+    r32 points;
+    s32 glyph_first;   // its glyphs are 'glyph_first' -> 'glyph_first + glyph_count'.
+    s32 glyph_count;
+    s32 glyph_height;
+    s32 glyph_width;
+    s32 line_spacing;
+    s32 lookup_offset; // like the header's, to glyphs of the whole atlas.
+    s32 lookup_size;
+    s32 page_count;
+};
+struct font_kernpair
+{
+    u16 second; // glyph.
+    s16 value;  // pixels * 64, added to the advance of the first glyph.
+};
+#pragma pack(pop)
+
+#define FONT_PAGE_SIZE 256    // codepoints per page.
+#define FONT_NO_GLYPH  0xffff
+
+// the atlas while it's baked, written out at the end in whichever layout was asked for.
+struct bake_atlas
+{
+    s32  width;
+    s32 height;
+    s32 glyph_count;
+
+    s32 glyph_height;
+    s32 glyph_width;
+
+    s32 line_spacing;
+
+    u32 format; // FONT_FORMAT_
+    s32 spread;
+    s32 level_count;
+
+    glyph_header* glyphs;     // glyph_count.
+    u32*          codepoints; // glyph_count, unicode.
+
+    r32            scale;      // pixels per font unit.
+    u32*           kerning;    // glyph_count + 1, see 'font_fileheader'. 0 = no kerning.
+    font_kernpair* kern_pairs;
+    s32            pair_count;
+
+    // more than one size: every size is a view of the atlas, its 'glyphs' and 'codepoints' point at its own.
+    bake_atlas* sizes; // 0 = the atlas is its only size.
+    s32         size_count;
+    s32         glyph_first; // a size's first glyph in the atlas.
+    r32         points;
+
+    // more than one texture: every texture is 'width' x 'height'.
+    s32  texture_count;
+    u16* textures; // glyph_count, the texture of every glyph. 0 with one texture.
+};
+
+global u32 bake_format = FONT_FORMAT_R8; // -f
+
+internal s32 bake_bytesperpixel(u32 format) { return((format == FONT_FORMAT_R8 || format == FONT_FORMAT_SDF || format == FONT_FORMAT_BC4) ? 1 : 4); }
+internal b32 bake_isdistance(u32 format)   { return(format == FONT_FORMAT_SDF || format == FONT_FORMAT_MSDF); }
+// what the glyphs are rasterized in, rgba32 is expanded and bc4 encoded when written.
+internal u32 bake_rasterformat(u32 format) { return((format == FONT_FORMAT_RGBA32 || format == FONT_FORMAT_BC4) ? FONT_FORMAT_R8 : format); }
+
+#define BITMAP_INFOHEADER_SIZE 40 // sizeof(BITMAPINFOHEADER)
+#define BITMAP_RGB             0  // BI_RGB
+
+// bitmap.
+// only the header and palette are new, the rows are written from 'bitmap_data' as they are.
+// 'image_count' images of 'bitmap_height' rows each ('image_stride' bytes apart) are stacked, the first at the bottom.
+internal b32
+bitmap_saveas(output_request* request, s8* bitmap_file, s32 bitmap_width, s32 bitmap_height, s32 bits_per_pixel, s8* bitmap_data,
+	      s32 image_count, u64 image_stride)
+{
+    // 8-bit bitmaps are palettized (a grey ramp), rows are padded to 4 bytes.
+    s32 image_height = bitmap_height;
+    bitmap_height   *= image_count;
+    s32 palette_size = (bits_per_pixel == 8) ? (256 * 4) : 0;
+    s32 row_size     = (bitmap_width * (bits_per_pixel / 8));
+    s32 stride       = (row_size + 3) & ~3;
+    s32 bitmap_size  = stride * bitmap_height;
+
+    bitmap_header header = {};
+    header.signature      = 0x4D42;
+    header.file_size      = sizeof(bitmap_header) + palette_size + bitmap_size;
+    header.byte_offset    = sizeof(bitmap_header) + palette_size;
+    header.header_size    = BITMAP_INFOHEADER_SIZE;
+    header.width          = bitmap_width;
+    header.height         = bitmap_height;
+    header.planes         = 1;
+    header.bits_per_pixel = bits_per_pixel;
+    header.compression    = BITMAP_RGB;
+    header.image_size     = bitmap_size;
+
+    // rows that aren't a multiple of 4 bytes need padding, every row is two buffers then.
+    b32 padded       = (stride != row_size);
+    s32 buffer_count = padded ? (1 + (bitmap_height * 2)) : (1 + image_count);
+
+    s8*              save    = (s8*)arena_pushzero(&request->memory, header.byte_offset + 4);
+    platform_buffer* buffers = (platform_buffer*)arena_push(&request->memory, buffer_count * sizeof(platform_buffer));
+    if(!save || !buffers) { return(false); }
+
+    mem_copy(&header, save, sizeof(bitmap_header));
+
+    // the palette starts right after the packed header (not aligned), an entry at a time.
+    s8* palette = save + sizeof(bitmap_header);
+    for(s32 entry = 0; entry < (palette_size / 4); entry++)
+    {
+	u32 colour = entry | (entry << 8) | (entry << 16);
+	mem_copy(&colour, palette + (entry * 4), sizeof(u32));
+    }
+
+    buffers[0] = { save, header.byte_offset };
+    if(padded)
+    {
+	for(s32 row = 0; row < bitmap_height; row++)
+	{
+	    s8* image = bitmap_data + ((row / image_height) * image_stride);
+	    buffers[1 + (row * 2)] = { image + ((row % image_height) * row_size), (u64)row_size };
+	    buffers[2 + (row * 2)] = { save + header.byte_offset, (u64)(stride - row_size) }; // 4 zero bytes after the palette.
+	}
+    }
+    else
+    {
+	for(s32 image = 0; image < image_count; image++)
+	{
+	    buffers[1 + image] = { bitmap_data + (image * image_stride), (u64)stride * image_height };
+	}
+    }
+    return(output_addfile(request, bitmap_file, buffers, buffer_count, "bmp"));
+}
+// replaces the extension of 'font_file' (.font) with .bmp
+internal void
+bitmap_path(s8* font_file, s8* bitmap_file)
+{
+    mem_copy(font_file, bitmap_file, MAX_PATH);
+    s32 len = (s32)strlen(bitmap_file);
+    if(len > 4)
+    {
+	bitmap_file[len - 1] = '\0';
+	bitmap_file[len - 2] = 'p';
+	bitmap_file[len - 3] = 'm';
+	bitmap_file[len - 4] = 'b';
+    }
+}
+// replaces the extension of 'font_file' (.font) with .h
+internal void
+header_path(s8* font_file, s8* header_file)
+{
+    mem_copy(font_file, header_file, MAX_PATH);
+    s32 len = (s32)strlen(header_file);
+    if(len > 4)
+    {
+	header_file[len - 3] = '\0';
+	header_file[len - 4] = 'h';
+    }
+}
+// the c++ identifier a header's arrays are named after, its file name ('fonts/Lato_24.h' -> 'Lato_24').
+internal void
+header_name(s8* header_file, s8* name)
+{
+    s8* start = header_file;
+    for(s8* c = header_file; *c; c++)
+    {
+	if(*c == '/' || *c == '\\') { start = c + 1; }
+    }
+
+    s32 length = 0;
+    if(*start >= '0' && *start <= '9') { name[length++] = '_'; }
+    for(s8* c = start; *c && *c != '.' && length < (MAX_PATH - 1); c++)
+    {
+	b32 valid = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9');
+	name[length++] = valid ? *c : '_';
+    }
+    if(length == 0) { name[length++] = '_'; }
+    name[length] = '\0';
+}
+// bake.
+
+// characters 128 -> 159 of the ansi code page (1252) are not latin-1, 'TextOutA' used to map them for us.
+global u16 bake_codepage[32] =
+{
+    0x20ac, 0x0081, 0x201a, 0x0192, 0x201e, 0x2026, 0x2020, 0x2021,
+    0x02c6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008d, 0x017d, 0x008f,
+    0x0090, 0x2018, 0x2019, 0x201c, 0x201d, 0x2022, 0x2013, 0x2014,
+    0x02dc, 0x2122, 0x0161, 0x203a, 0x0153, 0x009d, 0x017e, 0x0178,
+};
+internal u32
+bake_codepoint(s32 character)
+{
+    if(character >= 128 && character < 160)
+    {
+	return(bake_codepage[character - 128]);
+    }
+    return((u32)character);
+}
+// the other way, 0 when the ansi code page doesn't have it.
+internal s8
+bake_character(u32 codepoint)
+{
+    for(s32 c = 0; c < 32; c++)
+    {
+	if(bake_codepage[c] == codepoint) { return((s8)(128 + c)); }
+    }
+    if(codepoint >= 32 && codepoint < 256 && !(codepoint >= 128 && codepoint < 160))
+    {
+	return((s8)codepoint);
+    }
+    return(0);
+}
+// ' '(32) -> 'y diaeresis'(255) of the ansi code page, what every bake used to be.
+internal s32
+bake_defaultset(arena* memory, u32** codepoints)
+{
+    s32 count = 256 - 32;
+    *codepoints = (u32*)arena_push(memory, count * sizeof(u32));
+    if(!*codepoints) { return(0); }
+
+    for(s32 c = 0; c < count; c++)
+    {
+	(*codepoints)[c] = bake_codepoint(32 + c);
+    }
+    return(count);
+}
+// 'ranges' is a comma separated list of hex codepoints and ranges ("20-7e,a0-17f,400-4ff,U+20ac").
+// codepoints the font has no glyph for are left out, the result is sorted. 0 when it's malformed.
+internal s32
+bake_parseranges(s8* ranges, ttf_font* font, arena* memory, u32** codepoints)
+{
+    // one bit per codepoint (136 KiB), overlapping ranges and sorting come for free.
+    u32  word_count = (0x10ffff / 32) + 1;
+    u32* set        = (u32*)arena_pushzero(memory, word_count * sizeof(u32));
+    if(!set) { return(0); }
+
+    s8* c = ranges;
+    while(*c)
+    {
+	while(*c == ' ' || *c == ',') { c++; }
+	if(!*c) { break; }
+
+	if((c[0] == 'U' || c[0] == 'u') && c[1] == '+') { c += 2; }
+	s8* end   = 0;
+	u32 first = (u32)strtoul(c, &end, 16);
+	u32 last  = first;
+	if(end == c) { return(0); }
+	c = end;
+
+	if(*c == '-')
+	{
+	    c++;
+	    if((c[0] == 'U' || c[0] == 'u') && c[1] == '+') { c += 2; }
+	    last = (u32)strtoul(c, &end, 16);
+	    if(end == c) { return(0); }
+	    c = end;
+	}
+	if(*c != ',' && *c != ' ' && *c != '\0') { return(0); }
+	if(first > last || last > 0x10ffff)      { return(0); }
+
+	for(u32 codepoint = first; codepoint <= last; codepoint++)
+	{
+	    set[codepoint / 32] |= (1u << (codepoint % 32));
+	}
+    }
+
+    s32 count = 0;
+    for(u32 word = 0; word < word_count; word++)
+    {
+	for(u32 bits = set[word]; bits; bits &= bits - 1)
+	{
+	    u32 codepoint = (word * 32) + simd_lowbit(bits);
+	    if(ttf_glyphindex(font, codepoint)) { count++; }
+	    else                                { set[word] &= ~(1u << (codepoint % 32)); }
+	}
+    }
+    if(count == 0 || count >= FONT_NO_GLYPH) { return(0); }
+
+    *codepoints = (u32*)arena_push(memory, count * sizeof(u32));
+    if(!*codepoints) { return(0); }
+
+    s32 glyph = 0;
+    for(u32 word = 0; word < word_count; word++)
+    {
+	for(u32 bits = set[word]; bits; bits &= bits - 1)
+	{
+	    (*codepoints)[glyph++] = (word * 32) + simd_lowbit(bits);
+	}
+    }
+    return(count);
+}
+// "12+24+48" -> 'points', returns how many. 0 when it's malformed or there are more than BAKE_MAX_SIZES.
+internal s32
+bake_parsesizes(s8* sizes, r32* points)
+{
+    s32 count = 0;
+    for(s8* c = sizes;; c++)
+    {
+	s8* end   = c;
+	r32 value = strtof(c, &end);
+	if(end == c || value <= 0.0f || count >= BAKE_MAX_SIZES) { return(0); }
+
+	points[count++] = value;
+	c = end;
+	if(*c == '\0') { return(count); }
+	if(*c != '+')  { return(0); }
+    }
+}
+// codepoint -> glyph, two levels so a lookup touches at most two cache lines:
+//
+//   u16 first[page_count]              page of 'codepoint / 256' (0 = none of them have a glyph)
+//   u16 pages[page][FONT_PAGE_SIZE]    glyph of 'codepoint % 256' (FONT_NO_GLYPH = none), page 0 is empty
+//
+// only pages with at least one glyph are stored, 512 bytes each. the glyphs of a size are its atlas's.
+internal u16*
+bake_buildlookup(bake_atlas* atlas, arena* memory, s32* page_count, s32* lookup_size)
+{
+    u32 highest = 0;
+    for(s32 g = 0; g < atlas->glyph_count; g++)
+    {
+	if(atlas->codepoints[g] > highest) { highest = atlas->codepoints[g]; }
+    }
+    *page_count = (s32)(highest / FONT_PAGE_SIZE) + 1;
+
+    u16* first = (u16*)arena_pushzero(memory, *page_count * sizeof(u16));
+    if(!first) { return(0); }
+
+    s32 pages = 1;
+    for(s32 g = 0; g < atlas->glyph_count; g++)
+    {
+	u32 page = atlas->codepoints[g] / FONT_PAGE_SIZE;
+	if(!first[page]) { first[page] = (u16)pages++; }
+    }
+
+    *lookup_size = (*page_count + (pages * FONT_PAGE_SIZE)) * sizeof(u16);
+    u16* lookup = (u16*)arena_push(memory, *lookup_size);
+    if(!lookup) { return(0); }
+
+    mem_copy(first, lookup, *page_count * sizeof(u16));
+    u16* table = lookup + *page_count;
+    memset(table, 0xff, pages * FONT_PAGE_SIZE * sizeof(u16));
+    for(s32 g = 0; g < atlas->glyph_count; g++)
+    {
+	u32 codepoint = atlas->codepoints[g];
+	table[(first[codepoint / FONT_PAGE_SIZE] * FONT_PAGE_SIZE) + (codepoint % FONT_PAGE_SIZE)] = (u16)(atlas->glyph_first + g);
+    }
+    return(lookup);
+}
+// the font's kerning between the baked glyphs, in pixels (see 'font_fileheader'). codepoints that share a
+// glyph of the font share its pairs too.
+internal b32
+bake_kerning(bake_atlas* atlas, ttf_font* font, arena* memory)
+{
+    u16* slots       = (u16*)arena_push    (memory, font->glyph_count * sizeof(u16)); // font glyph -> first atlas glyph.
+    u8*  wanted      = (u8*) arena_pushzero(memory, font->glyph_count);
+    u16* next        = (u16*)arena_push    (memory, atlas->glyph_count * sizeof(u16)); // atlas glyph -> next one of the same font glyph.
+    u16* glyphs      = (u16*)arena_push    (memory, atlas->glyph_count * sizeof(u16));
+    u16* scratch     = (u16*)arena_push    (memory, atlas->glyph_count * 3 * sizeof(u16));
+    if(!slots || !wanted || !next || !glyphs || !scratch) { return(false); }
+
+    s32 glyph_count = 0;
+    for(s32 g = 0; g < atlas->glyph_count; g++)
+    {
+	s32 glyph = ttf_glyphindex(font, atlas->codepoints[g]);
+	next[g] = FONT_NO_GLYPH;
+	if(glyph == 0) { continue; } // missing.
+
+	if(!wanted[glyph])
+	{
+	    wanted[glyph]         = 1;
+	    slots[glyph]          = FONT_NO_GLYPH;
+	    glyphs[glyph_count++] = (u16)glyph;
+	}
+	next[g]      = slots[glyph];
+	slots[glyph] = (u16)g;
+    }
+
+    s32 found = ttf_kerning(font, wanted, glyphs, glyph_count, scratch, 0, 0);
+    if(found == 0) { return(true); }
+
+    ttf_kernpair* pairs = (ttf_kernpair*)arena_push(memory, found * sizeof(ttf_kernpair));
+    u64*          order = (u64*)         arena_push(memory, found * sizeof(u64));
+    if(!pairs || !order) { return(false); }
+    ttf_kerning(font, wanted, glyphs, glyph_count, scratch, pairs, found);
+
+    // (first, second) in the order they were found, the first of every lookup counts.
+    for(s32 p = 0; p < found; p++)
+    {
+	order[p] = ((u64)pairs[p].first << 48) | ((u64)pairs[p].second << 32) | (u32)p;
+    }
+    qsort(order, found, sizeof(u64), pack_compare);
+
+    // merged, in font units (into 'order', it's only read ahead of where it's written), then counted in atlas glyphs.
+    s32 merged_count = 0;
+    s32 pair_count   = 0;
+    for(s32 o = 0; o < found;)
+    {
+	ttf_kernpair* pair  = &pairs[(u32)order[o]];
+	s32           value = 0;
+	s32           table = -1;
+	for(; o < found && (order[o] >> 32) == ((u64)pair->first << 16 | pair->second); o++)
+	{
+	    ttf_kernpair* next_pair = &pairs[(u32)order[o]];
+	    if(next_pair->table != table)
+	    {
+		value += next_pair->value;
+		table  = next_pair->table;
+	    }
+	}
+
+	r32 pixels = value * atlas->scale * 64.0f;
+	s32 fixed  = (s32)((pixels < 0.0f) ? (pixels - 0.5f) : (pixels + 0.5f));
+	fixed      = (fixed < -32768) ? -32768 : ((fixed > 32767) ? 32767 : fixed);
+	if(fixed == 0) { continue; }
+
+	order[merged_count++] = ((u64)pair->first << 48) | ((u64)pair->second << 32) | (u16)fixed;
+	for(s32 f = slots[pair->first]; f != FONT_NO_GLYPH; f = next[f])
+	{
+	    for(s32 s = slots[pair->second]; s != FONT_NO_GLYPH; s = next[s])
+	    {
+		pair_count++;
+	    }
+	}
+    }
+    if(pair_count == 0) { return(true); }
+
+    // by atlas glyphs.
+    u64* sorted = (u64*)arena_push(memory, pair_count * sizeof(u64));
+    atlas->kerning    = (u32*)          arena_pushzero(memory, (atlas->glyph_count + 1) * sizeof(u32));
+    atlas->kern_pairs = (font_kernpair*)arena_push    (memory, pair_count * sizeof(font_kernpair));
+    if(!sorted || !atlas->kerning || !atlas->kern_pairs) { return(false); }
+
+    s32 sorted_count = 0;
+    for(s32 m = 0; m < merged_count; m++)
+    {
+	u16 first  = (u16)(order[m] >> 48);
+	u16 second = (u16)(order[m] >> 32);
+	for(s32 f = slots[first]; f != FONT_NO_GLYPH; f = next[f])
+	{
+	    for(s32 s = slots[second]; s != FONT_NO_GLYPH; s = next[s])
+	    {
+		sorted[sorted_count++] = ((u64)f << 48) | ((u64)s << 32) | (u16)order[m];
+	    }
+	}
+    }
+    qsort(sorted, pair_count, sizeof(u64), pack_compare);
+
+    for(s32 p = 0; p < pair_count; p++)
+    {
+	atlas->kern_pairs[p].second = (u16)(sorted[p] >> 32);
+	atlas->kern_pairs[p].value  = (s16)(u16)sorted[p];
+	atlas->kerning[(sorted[p] >> 48) + 1]++;
+    }
+    for(s32 g = 0; g < atlas->glyph_count; g++)
+    {
+	atlas->kerning[g + 1] += atlas->kerning[g];
+    }
+    atlas->pair_count = pair_count;
+    return(true);
+}
+// the kerning of every size (see 'bake_kerning') as one table of the atlas's glyphs, no pair crosses two sizes.
+internal b32
+bake_mergekerning(bake_atlas* atlas, arena* memory)
+{
+    if(atlas->size_count == 1)
+    {
+	atlas->kerning    = atlas->sizes[0].kerning;
+	atlas->kern_pairs = atlas->sizes[0].kern_pairs;
+	atlas->pair_count = atlas->sizes[0].pair_count;
+	return(true);
+    }
+
+    s32 pair_count = 0;
+    for(s32 s = 0; s < atlas->size_count; s++)
+    {
+	pair_count += atlas->sizes[s].kerning ? atlas->sizes[s].pair_count : 0;
+    }
+    if(pair_count == 0) { return(true); }
+
+    atlas->kerning    = (u32*)          arena_push(memory, (atlas->glyph_count + 1) * sizeof(u32));
+    atlas->kern_pairs = (font_kernpair*)arena_push(memory, pair_count * sizeof(font_kernpair));
+    if(!atlas->kerning || !atlas->kern_pairs) { return(false); }
+
+    u32 first_pair = 0;
+    for(s32 s = 0; s < atlas->size_count; s++)
+    {
+	bake_atlas* size  = &atlas->sizes[s];
+	s32         pairs = size->kerning ? size->pair_count : 0;
+	for(s32 g = 0; g < size->glyph_count; g++)
+	{
+	    atlas->kerning[size->glyph_first + g] = first_pair + (pairs ? size->kerning[g] : 0);
+	}
+	for(s32 p = 0; p < pairs; p++)
+	{
+	    atlas->kern_pairs[first_pair + p].second = (u16)(size->glyph_first + size->kern_pairs[p].second);
+	    atlas->kern_pairs[first_pair + p].value  = size->kern_pairs[p].value;
+	}
+	first_pair += pairs;
+    }
+    atlas->kerning[atlas->glyph_count] = first_pair;
+    atlas->pair_count = pair_count;
+    return(true);
+}
+internal void
+bake_writeglyph(void* source, u32 source_size_x, u32 source_size_y, u32 source_width,
+		void* target, u32 target_width)
+{
+    for(u32 sy = 0; sy < source_size_y; sy++)
+    {
+	simd.copy(source, target, source_size_x);
+	target = (u8*)target + target_width;
+	source = (u8*)source + source_width;
+    }
+}
+internal u8*
+bake_loadglyph(u8* coverage, arena* memory,
+	       s32 font_height, // in pixels.
+	       s32 ascent,      // in pixels.
+	       s32* offset,
+	       s32* glyph_width,
+	       s32* glyph_height)
+{
+    ASSERT(coverage);
+
+    // text extent?
+    s32  subsection_width  = font_height * 2;
+    s32  subsection_height = font_height * 2;
+
+    // calculate bounds.
+    s32 max_column = 0;
+    s32 min_column = subsection_width;
+    s32 max_row    = 0;
+    s32 min_row    = subsection_height;
+
+    simd.bounds(coverage, subsection_width, subsection_height, subsection_width,
+		&min_column, &max_column, &min_row, &max_row);
+
+    *glyph_width  = (max_column != 0) ? ((max_column - min_column) + 1) : 0;
+    *glyph_height = (max_row    != 0) ? ((max_row    - min_row   ) + 1) : 0;
+
+    // this is a save guard, shouldn't actually happen in practice! change to 'ASSERT'
+    *glyph_width  = (*glyph_width  > font_height) ? font_height : *glyph_width;
+    *glyph_height = (*glyph_height > font_height) ? font_height : *glyph_height;
+
+    // smallest possible glyph (coverage, one byte per pixel), empty glyphs take no memory.
+    u8* glyph = (u8*)arena_push(memory, *glyph_width * *glyph_height);
+    if(glyph)
+    {
+	u8* subsection_ptr = coverage + (min_row * subsection_width) + min_column;
+
+	bake_writeglyph(subsection_ptr, *glyph_width, *glyph_height, subsection_width, glyph, *glyph_width);
+    }
+    // freed with the arena.
+
+    *offset = max_row - (subsection_height - ascent);
+
+    return(glyph);
+}
+// the same trimmed glyph as 'bake_loadglyph', 'spread' pixels bigger on every side and as a distance field.
+internal u8*
+bake_loaddistance(raster_surface* surface, sdf_scratch* scratch, arena* memory, bake_atlas* atlas,
+		  ttf_outline* outline, r32 scale, r32 origin_x, r32 origin_y,
+		  s32 font_height, // in pixels.
+		  s32 ascent,      // in pixels.
+		  s32* offset,
+		  s32* glyph_width,
+		  s32* glyph_height)
+{
+    s32 max_column = 0;
+    s32 min_column = surface->width;
+    s32 max_row    = 0;
+    s32 min_row    = surface->height;
+
+    simd.bounds(surface->pixels, surface->width, surface->height, surface->width,
+		&min_column, &max_column, &min_row, &max_row);
+
+    s32 width  = (max_column != 0) ? ((max_column - min_column) + 1) : 0;
+    s32 height = (max_row    != 0) ? ((max_row    - min_row   ) + 1) : 0;
+    width  = (width  > font_height) ? font_height : width;
+    height = (height > font_height) ? font_height : height;
+
+    u8* glyph = 0;
+    *glyph_width  = 0;
+    *glyph_height = 0;
+    *offset       = max_row - (surface->height - ascent);
+    if(width && height)
+    {
+	s32 spread = atlas->spread;
+	s32 x = min_column - spread;
+	s32 y = min_row    - spread;
+	width  += spread * 2;
+	height += spread * 2;
+
+	sdf_distance(surface->pixels, surface->width, surface->height, x, y, width, height, scratch);
+
+	s32 bytes = bake_bytesperpixel(atlas->format);
+	glyph = (u8*)arena_push(memory, width * height * bytes);
+	if(glyph)
+	{
+	    if(atlas->format == FONT_FORMAT_MSDF)
+	    {
+		s32 edge_count = msdf_edges(scratch, outline, scale, origin_x, origin_y);
+		msdf_generate(scratch, edge_count, x, y, width, height, (r32)spread, scratch->inner, glyph);
+	    }
+	    else
+	    {
+		for(s32 pixel = 0; pixel < (width * height); pixel++)
+		{
+		    glyph[pixel] = sdf_encode(scratch->inner[pixel], (r32)spread);
+		}
+	    }
+	}
+
+	*glyph_width  = width;
+	*glyph_height = height;
+	*offset       = (max_row + spread) - (surface->height - ascent);
+    }
+    return(glyph);
+}
+// per thread, reused for every glyph the thread rasterizes.
+struct bake_scratch
+{
+    raster_surface surface;
+    ttf_outline    outline;
+    sdf_scratch    sdf; // sdf, msdf only.
+};
+struct bake_rasterjob
+{
+    bake_atlas*   atlas;
+    u8**          glyphs;
+    s32*          pending; // the glyphs to rasterize, the rest came from the cache.
+    ttf_font*     font;
+    bake_scratch* scratch;
+
+    r32 scale;
+    s32 pixels;
+    s32 ascent;
+};
+// the scratch of one thread, 'bake_pushscratch' pushes it.
+internal u64
+bake_scratchbytes(bake_atlas* atlas, ttf_font* font, s32 pixels)
+{
+    u64 surface_size = (u64)(pixels * 2) * (pixels * 2);
+    u64 scratch_size = surface_size + ((surface_size + 1) * sizeof(r32)) +
+		       (font->max_points * sizeof(ttf_point)) + (font->max_contours * sizeof(s32)) + (4 * ARENA_ALIGNMENT);
+
+    // distance fields: the region around the biggest glyph, one row or column, the outline's edges.
+    s32 region        = pixels + (atlas->spread * 2);
+    s32 edge_capacity = (font->max_points * 3) + (font->max_contours * 6);
+    if(bake_isdistance(atlas->format))
+    {
+	scratch_size += ((u64)region * region * 2 * sizeof(r32)) + ((region + 1) * 3 * sizeof(r32)) + (3 * ARENA_ALIGNMENT);
+	if(atlas->format == FONT_FORMAT_MSDF)
+	{
+	    scratch_size += (edge_capacity * sizeof(msdf_edge)) + ARENA_ALIGNMENT;
+	}
+    }
+    return(scratch_size);
+}
+// a surface of 'pixels' * 2 square, room for the font's biggest outline (and the distance field's).
+internal b32
+bake_pushscratch(bake_scratch* scratch, bake_atlas* atlas, ttf_font* font, s32 pixels, arena* memory)
+{
+    raster_surface* surface = &scratch->surface;
+    surface->width        = pixels * 2;
+    surface->height       = pixels * 2;
+    surface->pixels       = (u8*) arena_push(memory, surface->width * surface->height);
+    surface->accumulation = (r32*)arena_push(memory, ((surface->width * surface->height) + 1) * sizeof(r32));
+
+    ttf_outline* outline      = &scratch->outline;
+    outline->point_capacity   = font->max_points;
+    outline->contour_capacity = font->max_contours;
+    outline->points           = (ttf_point*)arena_push(memory, outline->point_capacity * sizeof(ttf_point));
+    outline->contour_ends     = (s32*)arena_push(memory, outline->contour_capacity * sizeof(s32));
+
+    b32 allocated = surface->pixels && surface->accumulation && outline->points && outline->contour_ends;
+
+    if(bake_isdistance(atlas->format))
+    {
+	s32 region = pixels + (atlas->spread * 2);
+
+	sdf_scratch* sdf = &scratch->sdf;
+	sdf->outer    = (r32*)arena_push(memory, (u64)region * region * sizeof(r32));
+	sdf->inner    = (r32*)arena_push(memory, (u64)region * region * sizeof(r32));
+	sdf->line     = (r32*)arena_push(memory, (region + 1) * sizeof(r32));
+	sdf->boundary = (r32*)arena_push(memory, (region + 1) * sizeof(r32));
+	sdf->parabola = (s32*)arena_push(memory, (region + 1) * sizeof(s32));
+	allocated = allocated && sdf->outer && sdf->inner && sdf->line && sdf->boundary && sdf->parabola;
+
+	if(atlas->format == FONT_FORMAT_MSDF)
+	{
+	    sdf->edge_capacity = (font->max_points * 3) + (font->max_contours * 6);
+	    sdf->edges         = (msdf_edge*)arena_push(memory, sdf->edge_capacity * sizeof(msdf_edge));
+	    allocated = allocated && sdf->edges;
+	}
+    }
+    return(allocated);
+}
+// rasterizes and trims one codepoint (in the atlas' format) onto 'memory' and fills in its header, the offset
+// is still from the top of the surface. 0 for an empty glyph.
+internal u8*
+bake_rasterize(bake_atlas* atlas, ttf_font* font, bake_scratch* scratch, arena* memory, u32 codepoint,
+	       r32 scale, s32 pixels, s32 ascent, glyph_header* header)
+{
+    ttf_outline* outline = &scratch->outline;
+    s32          glyph   = ttf_glyphindex(font, codepoint);
+
+    if(!ttf_glyphoutline(font, glyph, outline))
+    {
+	outline->contour_count = 0; // malformed, bake it empty.
+	platform_debugprint("'ttf_glyphoutline' failed!\n");
+    }
+
+    // the pen starts at the left of the surface (like 'TextOutA(0, 0)'),
+    // glyphs that hang to the left are moved in rather than clipped.
+    s32 left  = (s32)floorf(outline->x_min * scale);
+    s32 right = (s32) ceilf(outline->x_max * scale);
+
+    r32 origin_x = (left < 0) ? (r32)-left : 0.0f;
+    r32 origin_y = (r32)(scratch->surface.height - ascent); // baseline (bottom-up).
+
+    raster_outline(&scratch->surface, outline, scale, origin_x, origin_y);
+
+    // 'glyph_header' is packed, its fields can't be written through an s32*.
+    u8* trimmed = 0;
+    s32 offset  = 0;
+    s32 width   = 0;
+    s32 height  = 0;
+    if(bake_isdistance(atlas->format))
+    {
+	trimmed = bake_loaddistance(&scratch->surface, &scratch->sdf, memory, atlas,
+				       outline, scale, origin_x, origin_y, pixels, ascent,
+				       &offset,
+				       &width,
+				       &height);
+    }
+    else
+    {
+	trimmed = bake_loadglyph(scratch->surface.pixels, memory, pixels, ascent,
+				    &offset,
+				    &width,
+				    &height);
+    }
+    header->offset = offset;
+    header->width  = width;
+    header->height = height;
+
+    // abc widths ('GetCharABCWidthsA'), a = left bearing, b = ink, c = advance - a - b.
+    ttf_hmetrics metrics = ttf_glyphhmetrics(font, glyph);
+    s32 advance = (s32)((metrics.advance * scale) + 0.5f);
+    s32 a = 0;
+    s32 b = 0;
+    if(outline->contour_count)
+    {
+	a = left;
+	b = right - left;
+    }
+    header->character   = bake_character(codepoint);
+    header->    spacing = advance - a - b;
+    header->pre_spacing = a;
+    if(header->width)
+    {
+	// distance fields reach 'spread' past the ink, the advance stays the same.
+	header->    spacing -= atlas->spread;
+	header->pre_spacing -= atlas->spread;
+    }
+    return(trimmed);
+}
+internal void
+bake_rasterglyph(void* data, s32 thread, s32 p)
+{
+    bake_rasterjob* job = (bake_rasterjob*)data;
+    s32             c   = job->pending[p];
+
+    job->glyphs[c] = bake_rasterize(job->atlas, job->font, &job->scratch[thread], &bake_arenas[thread], job->atlas->codepoints[c],
+				    job->scale, job->pixels, job->ascent, &job->atlas->glyphs[c]);
+}
+// pixels per font unit at 'points', the ascent and the line spacing (tmInternalLeading) in pixels.
+internal r32
+bake_fontmetrics(ttf_font* font, r32 points, s32* ascent, s32* line_spacing)
+{
+    // same as the gdi renderer's 'CreateFontA(-MulDiv(points/2.0, LOGPIXELSY, 72))', a negative height is the
+    // em height. it halved 'points' again (the callers pass half the size already), so the em is a quarter of
+    // the -h points. rounded like MulDiv, fractional points aren't truncated first.
+    s32 em_pixels = (s32)((((points / 2.0f) * DPI) / 72.0f) + 0.5f);
+    r32 scale     = em_pixels / (r32)font->units_per_em;
+
+    s32 descent   = (s32)((font->descent * scale) + 0.5f); // tmDescent
+    *ascent       = (s32)((font->ascent  * scale) + 0.5f); // tmAscent
+    *line_spacing = (*ascent + descent) - em_pixels;       // tmInternalLeading
+    return(scale);
+}
+// rasterizes the 'pending' glyphs, their offsets are still from the top of the surface (see 'bake_alignglyphs').
+internal b32
+bake_loadfont(bake_atlas* atlas, ttf_font* font, r32 points, s32 pixels, u8** glyphs, s32* pending, s32 pending_count)
+{
+    b32 success = false;
+
+    s32 ascent       = 0;
+    s32 line_spacing = 0;
+    r32 scale        = bake_fontmetrics(font, points, &ascent, &line_spacing);
+    atlas->scale     = scale;
+
+    bake_scratch scratch[WORK_MAX_THREADS] = {};
+    s32 first_thread = 0;
+    s32 thread_count = work_span(&first_thread);
+
+    // one block per worker: its scratch plus its share of the trimmed glyphs (about half a square each).
+    u64 scratch_size = bake_scratchbytes(atlas, font, pixels);
+    u64 glyphs_size  = (((pending_count + thread_count - 1) / thread_count) * (u64)pixels * pixels) / 2;
+    if(bake_isdistance(atlas->format))
+    {
+	s32 region  = pixels + (atlas->spread * 2);
+	glyphs_size = (((pending_count + thread_count - 1) / thread_count) * (u64)region * region *
+		       bake_bytesperpixel(atlas->format)) / 2;
+    }
+
+    b32 allocated = true;
+    for(s32 thread = first_thread; thread < (first_thread + thread_count); thread++)
+    {
+	arena* memory = &bake_arenas[thread];
+	arena_reserve(memory, scratch_size + glyphs_size);
+
+	allocated = bake_pushscratch(&scratch[thread], atlas, font, pixels, memory) && allocated;
+    }
+
+    if(allocated)
+    {
+	bake_rasterjob job = {};
+	job.atlas   = atlas;
+	job.glyphs  = glyphs;
+	job.pending = pending;
+	job.font    = font;
+	job.scratch = scratch;
+	job.scale   = scale;
+	job.pixels  = pixels;
+	job.ascent  = ascent;
+
+	work_run(pending_count, bake_rasterglyph, &job);
+
+	atlas->line_spacing = line_spacing;
+
+	success = true;
+    }
+    else
+    {
+	platform_debugprint("'arena_push' failed!\n");
+    }
+
+    return(success);
+};
+// 'bake_loadfont' for every size of the atlas, 'pending' and 'pending_counts' are per size (from its first glyph).
+internal b32
+bake_loadsizes(bake_atlas* atlas, ttf_font* font, u8** glyphs, s32* pending, s32* pending_counts)
+{
+    for(s32 s = 0; s < atlas->size_count; s++)
+    {
+	bake_atlas* size = &atlas->sizes[s];
+	if(!bake_loadfont(size, font, size->points/2.0, size->glyph_height/2, glyphs + size->glyph_first,
+			  pending + size->glyph_first, pending_counts[s]))
+	{
+	    return(false);
+	}
+    }
+    // the atlas itself is the first size.
+    atlas->scale        = atlas->sizes[0].scale;
+    atlas->line_spacing = atlas->sizes[0].line_spacing;
+    return(true);
+}
+// offsets from the top of the surface -> from the top of the tallest glyph.
+internal void
+bake_alignglyphs(bake_atlas* atlas)
+{
+    s32 max_offset = 0;
+    for(s32 i = 0; i < atlas->glyph_count; i++)
+    {
+	if(atlas->glyphs[i].offset > max_offset) { max_offset = atlas->glyphs[i].offset; }
+    }
+    for(s32 i = 0; i < atlas->glyph_count; i++)
+    {
+	atlas->glyphs[i].offset = max_offset - atlas->glyphs[i].offset;
+    }
+}
+// frees everything a bake pushed (to the arenas of the threads it ran on) and returns how much it needed.
+internal bake_memory
+bake_resetmemory()
+{
+    bake_memory memory = {};
+
+    s32 first_thread = 0;
+    s32 thread_count = work_span(&first_thread);
+    for(s32 thread = first_thread; thread < (first_thread + thread_count); thread++)
+    {
+	// nothing is freed during a bake, so the peaks all happen at once.
+	arena* bake_arena = &bake_arenas[thread];
+	memory.peak        += bake_arena->peak;
+	memory.reserved    += bake_arena->reserved;
+	memory.allocations += bake_arena->allocations;
+
+	arena_reset(bake_arena);
+	bake_arena->peak        = 0;
+	bake_arena->allocations = 0;
+    }
+    return(memory);
+}
+internal void
+bake_releasememory()
+{
+    for(s32 thread = 0; thread < WORK_MAX_THREADS; thread++)
+    {
+	arena_release(&bake_arenas[thread]);
+    }
+    output_releasememory();
+}
+struct bake_blitjob
+{
+    bake_atlas*  atlas;
+    u8*          pixels; // atlas->width * atlas->height, 'bake_bytesperpixel' each.
+    u8**         glyphs;
+    pack_rect*   rects;
+
+    s32 padding;
+    s32 bleed;
+    u64 texture_bytes; // apart, every texture is its own mip chain.
+};
+// uvs of the glyph at 'x', 'y' (its first pixel, past the padding) in the atlas, 'v0' is the top.
+internal void
+bake_glyphuv(bake_atlas* atlas, glyph_header* header, s32 x, s32 y)
+{
+    header->u0 = x/(r32)atlas->width;
+    header->v0 = (y + header->height)/(r32)atlas->height;
+    header->u1 = (x + header->width)/(r32)atlas->width;
+    header->v1 = y/(r32)atlas->height;
+}
+// every glyph owns its own rectangle (padding included), the blits never overlap.
+internal void
+bake_blitglyph(void* data, s32 thread, s32 g)
+{
+    bake_blitjob* job    = (bake_blitjob*)data;
+    bake_atlas*   atlas  = job->atlas;
+    glyph_header* header = &atlas->glyphs[g];
+    pack_rect*    rect   = &job->rects[g];
+
+    if(!rect->packed)
+    {
+	// empty glyph (space), nothing to sample.
+	header->u0 = header->u1 = header->v0 = header->v1 = 0.0f;
+	return;
+    }
+
+    // first (bottom) row of the glyph, rows go up in memory just like the glyph. (bottom-up)
+    s32 bytes  = bake_bytesperpixel(atlas->format);
+    s32 stride = atlas->width * bytes;
+    s32 size   = header->width * bytes;
+    s32 x      = rect->x + job->padding;
+    s32 y      = rect->y + job->padding;
+    u8* target = job->pixels + (rect->page * job->texture_bytes) + (y * stride) + (x * bytes);
+
+    bake_writeglyph(job->glyphs[g], size, header->height, size, target, stride);
+
+    // bleed, the outermost rows and columns are repeated into the padding (so filtering never reads past the edge).
+    for(s32 b = 1; b <= job->bleed; b++)
+    {
+	bake_writeglyph(target, size, 1, 0, target - (b * stride), stride);
+	bake_writeglyph(target + ((header->height - 1) * stride), size, 1, 0,
+			target + ((header->height - 1 + b) * stride), stride);
+    }
+    for(s32 row = -job->bleed; row < (header->height + job->bleed); row++)
+    {
+	u8* line = target + (row * stride);
+	for(s32 b = 1; b <= job->bleed; b++)
+	{
+	    for(s32 i = 0; i < bytes; i++)
+	    {
+		line[(-b * bytes) + i]  = line[i];
+		line[size - bytes + (b * bytes) + i] = line[size - bytes + i];
+	    }
+	}
+    }
+
+    bake_glyphuv(atlas, header, x, y);
+}
+// sizes every glyph rectangle (glyph + padding on every side) and picks the atlas width with the smallest area.
+// rectangles (and the atlas) are a multiple of 'align', a power of two, so with mips every texel of every
+// level comes from one glyph only.
+// when that is more than 'max_texture' (pixels, 0 = no limit) on either side the glyphs go on as many textures
+// of at most 'max_texture' as they need, all the same size. false if a glyph doesn't fit on one.
+internal b32
+bake_packatlas(bake_atlas* header, pack_rect* rects, s32 padding, s32 align, s32 max_texture, arena* memory)
+{
+    s64 area   = 0;
+    s32 widest = align; // even when every glyph is empty.
+    for(s32 g = 0; g < header->glyph_count; g++)
+    {
+	b32 empty = (header->glyphs[g].width == 0 || header->glyphs[g].height == 0);
+	rects[g] = {};
+	rects[g].width  = empty ? 0 : (header->glyphs[g].width  + (padding * 2) + (align - 1)) & ~(align - 1);
+	rects[g].height = empty ? 0 : (header->glyphs[g].height + (padding * 2) + (align - 1)) & ~(align - 1);
+
+	area += rects[g].width * rects[g].height;
+	if(rects[g].width > widest) { widest = rects[g].width; }
+    }
+
+    s32 width = 1;
+    while(((s64)width * width) < area || width < widest)
+    {
+	width *= 2;
+    }
+
+    // the widest power of two a texture can be, and its height.
+    s32 texture_width  = align;
+    s32 texture_height = max_texture & ~(align - 1);
+    while(max_texture > 0 && (texture_width * 2) <= max_texture) { texture_width *= 2; }
+
+    s32        node_count = ((width * 2) > texture_width) ? (width * 2) : texture_width;
+    u64*       order = (u64*)arena_push(memory, header->glyph_count * sizeof(u64));
+    pack_node* nodes = (pack_node*)arena_push(memory, (node_count + 1) * sizeof(pack_node));
+    if(!order || !nodes) { return(false); }
+
+    // a power of two wide, as low as the glyphs need. one step either side of the square is enough.
+    s32 best_width  = 0;
+    s64 best_area   = 0;
+    s32 candidates[3] = { width / 2, width, width * 2 };
+    for(s32 c = 0; c < 3; c++)
+    {
+	if(candidates[c] < widest) { continue; }
+
+	s32 height = pack_rects(rects, header->glyph_count, candidates[c], 0x7fffffff, order, nodes);
+	if(best_width == 0 || ((s64)candidates[c] * height) < best_area)
+	{
+	    best_width = candidates[c];
+	    best_area  = (s64)candidates[c] * height;
+	}
+    }
+    header->width         = best_width;
+    header->height        = pack_rects(rects, header->glyph_count, best_width, 0x7fffffff, order, nodes);
+    header->texture_count = 1;
+    header->textures      = 0;
+
+    if(max_texture > 0 && (header->width > max_texture || header->height > max_texture))
+    {
+	header->width         = texture_width;
+	header->texture_count = (texture_height >= align) ? pack_pages(rects, header->glyph_count, texture_width, texture_height,
+									       order, nodes, &header->height) : 0;
+	header->textures      = (u16*)arena_pushzero(memory, header->glyph_count * sizeof(u16));
+	if(header->texture_count == 0 || header->texture_count > FONT_NO_GLYPH)
+	{
+	    platform_debugprint("'pack_pages' failed! (a glyph is bigger than a texture (-x))\n");
+	    return(false);
+	}
+	if(!header->textures) { return(false); }
+
+	for(s32 g = 0; g < header->glyph_count; g++)
+	{
+	    header->textures[g] = (u16)rects[g].page;
+	}
+    }
+    if(header->height < 1) { header->height = 1; }
+    header->height = (header->height + (align - 1)) & ~(align - 1);
+
+    return(true);
+}
+// mips.
+//
+// Level n is the atlas at 1/2^n, every texel the average of a 2x2 block of the level above. Coverage and
+// distances are both linear already (coverage is the covered area, not a colour), so averaging the bytes
+// as they are is the gamma-correct filter, a decode to linear light would only darken thin strokes.
+// 'bake_packatlas' aligns the glyphs so no block ever straddles two of them.
+//
+internal u64
+bake_levelbytes(bake_atlas* atlas, s32 level)
+{
+    return((u64)(atlas->width >> level) * (atlas->height >> level) * bake_bytesperpixel(atlas->format));
+}
+// every level, in order, right after the atlas.
+internal u64
+bake_chainbytes(bake_atlas* atlas)
+{
+    u64 bytes = 0;
+    for(s32 level = 0; level < atlas->level_count; level++)
+    {
+	bytes += bake_levelbytes(atlas, level);
+    }
+    return(bytes);
+}
+internal void
+bake_buildlevels(bake_atlas* atlas, u8* pixels)
+{
+    s32 bytes = bake_bytesperpixel(atlas->format);
+    for(s32 level = 1; level < atlas->level_count; level++)
+    {
+	u8* source = pixels;
+	u8* target = pixels + bake_levelbytes(atlas, level - 1);
+
+	s32 source_stride = (atlas->width >> (level - 1)) * bytes;
+	s32 target_stride = (atlas->width >>  level     ) * bytes;
+	for(s32 row = 0; row < (atlas->height >> level); row++)
+	{
+	    simd.halve(source + (row * 2 * source_stride), source_stride, target + (row * target_stride),
+		       atlas->width >> level, bytes);
+	}
+	pixels = target;
+    }
+}
+// bc4.
+//
+// The atlas (and every mip) is encoded a row of blocks per job, the .bmp preview is decoded from the
+// blocks so it shows what ends up on the gpu.
+//
+struct bake_encodejob
+{
+    u8* pixels;
+    s32 width;
+    s32 height;
+    s32 quality;
+    u8* blocks;
+};
+
+internal void
+bake_encoderow(void* data, s32 thread, s32 row)
+{
+    bake_encodejob* encode = (bake_encodejob*)data;
+    bc4_encoderow(encode->pixels, encode->width, encode->height, row, encode->quality, encode->blocks);
+}
+// compression.
+//
+// The payload is cut into 'chunk_size' pieces that are compressed on their own (and on every thread),
+// each into a slot big enough for the worst case, then packed one after another in the file. With more
+// than one texture every texture is cut on its own, so one of them decompresses without the others.
+//
+struct bake_compressjob
+{
+    u8* payload;
+    u64 texture_size;
+    u64 chunk_size;
+    s32 texture_chunks; // per texture.
+
+    u8*  slots;     // 'slot_size' per chunk.
+    u64  slot_size;
+    u64* sizes;     // compressed, per chunk.
+};
+
+internal void
+bake_compresschunk(void* data, s32 thread, s32 chunk)
+{
+    bake_compressjob* compress = (bake_compressjob*)data;
+
+    u64 start = (u64)(chunk % compress->texture_chunks) * compress->chunk_size;
+    u64 size  = compress->texture_size - start;
+    size      = (size > compress->chunk_size) ? compress->chunk_size : size;
+    start    += (u64)(chunk / compress->texture_chunks) * compress->texture_size;
+    compress->sizes[chunk] = lz_compress(compress->payload + start, size, compress->slots + (chunk * compress->slot_size));
+}
+// bytes of a 'width' x 'height' level in the file.
+internal u64
+bake_filebytes(u32 format, s32 width, s32 height)
+{
+    return((format == FONT_FORMAT_BC4) ? bc4_size(width, height) : (u64)width * height * bake_bytesperpixel(format));
+}
+internal b32 bake_writeheader(bake_job* job, bake_atlas* atlas, font_fileheader* file, u8* payload, u16** lookups, s32* lookup_sizes,
+			      s32* page_counts, output_request* request); // atlas_baked_embed.cpp
+
+// hands the .font and its .bmp preview (in the job's format) to 'request', 'pixels' has to be on its arena.
+// the blocks of a bc4 atlas are decoded back into 'pixels' for the preview, with -e the header gets the payload.
+// 'pixels' has a mip chain ('bake_chainbytes') per texture, the preview stacks their first levels.
+internal b32
+bake_writefont(bake_job* job, bake_atlas* atlas, u8* pixels, output_request* request)
+{
+    arena* memory = &request->memory;
+
+    s32 pixel_count = atlas->width * atlas->height;
+    if(job->format != FONT_FORMAT_RGBA32)
+    {
+	// a lookup per size, one after another. the header has the first one.
+	s32         size_count = atlas->sizes ? atlas->size_count : 1;
+	bake_atlas* sizes      = atlas->sizes ? atlas->sizes : atlas;
+	u16* lookups[BAKE_MAX_SIZES];
+	s32  page_counts[BAKE_MAX_SIZES];
+	s32  lookup_sizes[BAKE_MAX_SIZES];
+	s32  lookup_total = 0;
+	for(s32 s = 0; s < size_count; s++)
+	{
+	    lookups[s] = bake_buildlookup(&sizes[s], memory, &page_counts[s], &lookup_sizes[s]);
+	    if(!lookups[s]) { return(false); }
+	    lookup_total += lookup_sizes[s];
+	}
+
+	u32 format = (job->format == FONT_FORMAT_BC4) ? job->format : atlas->format;
+
+	u64 level_sizes[FONT_MAX_LEVELS];
+	u64 texture_size = 0;
+	for(s32 level = 0; level < atlas->level_count; level++)
+	{
+	    level_sizes[level] = bake_filebytes(format, atlas->width >> level, atlas->height >> level);
+	    texture_size      += level_sizes[level];
+	}
+	u64 chain_bytes  = bake_chainbytes(atlas);
+	u64 payload_size = texture_size * atlas->texture_count;
+
+	font_fileheader file = {};
+	file.magic            = FONT_MAGIC;
+	file.version          = FONT_VERSION;
+	file.format           = (u16)format;
+	file.header_size      = sizeof(font_fileheader);
+	file.width            = atlas->width;
+	file.height           = atlas->height;
+	file.glyph_count      = atlas->glyph_count;
+	file.glyph_height     = atlas->glyph_height;
+	file.glyph_width      = atlas->glyph_width;
+	file.line_spacing     = atlas->line_spacing;
+	file.glyph_offset     = sizeof(font_fileheader);
+	file.codepoint_offset = (file.glyph_offset + (file.glyph_count * sizeof(glyph_header)) + 3) & ~3;
+	file.lookup_offset    = file.codepoint_offset + (file.glyph_count * sizeof(u32));
+	file.lookup_size      = lookup_sizes[0];
+	file.page_count       = page_counts[0];
+	file.size_count       = size_count;
+	file.byte_offset      = (file.lookup_offset + lookup_total + 3) & ~3;
+	if(size_count > 1)
+	{
+	    file.size_offset = file.byte_offset;
+	    file.byte_offset = file.size_offset + (size_count * sizeof(font_size));
+	}
+	if(atlas->pair_count)
+	{
+	    file.kerning_offset = file.byte_offset;
+	    file.pair_offset    = file.kerning_offset + ((file.glyph_count + 1) * sizeof(u32));
+	    file.pair_count     = atlas->pair_count;
+	    file.byte_offset    = file.pair_offset + (file.pair_count * sizeof(font_kernpair));
+	}
+	file.texture_count    = atlas->texture_count;
+	file.texture_size     = (s32)texture_size;
+	if(atlas->texture_count > 1)
+	{
+	    file.texture_offset = file.byte_offset;
+	    file.byte_offset    = (file.texture_offset + (file.glyph_count * sizeof(u16)) + 3) & ~3;
+	}
+	file.spread           = bake_isdistance(atlas->format) ? atlas->spread : 0;
+	file.level_count      = atlas->level_count;
+	file.payload_size     = (s32)payload_size;
+
+	// the payload, the levels as they are or their blocks.
+	u8* payload = pixels;
+	if(format == FONT_FORMAT_BC4)
+	{
+	    payload = (u8*)arena_push(memory, payload_size);
+	    if(!payload) { return(false); }
+
+	    for(s32 t = 0; t < atlas->texture_count; t++)
+	    {
+		u8* level_pixels = pixels  + (t * chain_bytes);
+		u8* level_blocks = payload + (t * texture_size);
+		for(s32 level = 0; level < atlas->level_count; level++)
+		{
+		    bake_encodejob encode = {};
+		    encode.pixels  = level_pixels;
+		    encode.width   = atlas->width  >> level;
+		    encode.height  = atlas->height >> level;
+		    encode.quality = job->quality;
+		    encode.blocks  = level_blocks;
+		    work_run((encode.height + 3) / 4, bake_encoderow, &encode);
+
+		    level_pixels += bake_levelbytes(atlas, level);
+		    level_blocks += level_sizes[level];
+		}
+		bc4_decode(payload + (t * texture_size), atlas->width, atlas->height, pixels + (t * chain_bytes));
+	    }
+	}
+
+	// everything in front of the payload (header, tables) is one buffer, then the payload or its chunks.
+	s32 head_size    = file.byte_offset;
+	s32 buffer_count = 2;
+
+	bake_compressjob compress = {};
+	if(job->chunk_size > 0)
+	{
+	    compress.payload        = payload;
+	    compress.texture_size   = texture_size;
+	    compress.chunk_size     = job->chunk_size;
+	    compress.texture_chunks = (s32)((texture_size + job->chunk_size - 1) / job->chunk_size);
+	    compress.slot_size      = lz_bound(job->chunk_size);
+	    s32 chunk_count         = compress.texture_chunks * atlas->texture_count;
+	    compress.slots        = (u8*) arena_push(memory, chunk_count * compress.slot_size);
+	    compress.sizes        = (u64*)arena_push(memory, chunk_count * sizeof(u64));
+	    if(!compress.slots || !compress.sizes) { return(false); }
+
+	    work_run(chunk_count, bake_compresschunk, &compress);
+
+	    // the chunk table goes where the levels would have been, the chunks right after it.
+	    file.compression  = FONT_COMPRESSION_LZ4;
+	    file.chunk_size   = job->chunk_size;
+	    file.chunk_count  = chunk_count;
+	    file.chunk_offset = file.byte_offset;
+	    file.byte_offset  = 0;
+	    head_size         = file.chunk_offset + ((chunk_count + 1) * sizeof(u32));
+	    buffer_count      = 1 + chunk_count;
+	    file.size         = head_size;
+	    for(s32 chunk = 0; chunk < chunk_count; chunk++)
+	    {
+		file.size += (s32)compress.sizes[chunk];
+	    }
+	}
+	else
+	{
+	    file.size = file.byte_offset + (s32)payload_size;
+	}
+
+	s32 level_offset = file.byte_offset;
+	for(s32 level = 0; level < atlas->level_count; level++)
+	{
+	    file.level_offsets[level] = level_offset;
+	    level_offset += (s32)level_sizes[level];
+	}
+
+	s8*              save    = (s8*)arena_pushzero(memory, head_size);
+	platform_buffer* buffers = (platform_buffer*)arena_push(memory, buffer_count * sizeof(platform_buffer));
+	if(!save || !buffers) { return(false); }
+
+	mem_copy(&file, save, sizeof(font_fileheader));
+	mem_copy(atlas->glyphs,     save + file.glyph_offset,     file.glyph_count * sizeof(glyph_header));
+	mem_copy(atlas->codepoints, save + file.codepoint_offset, file.glyph_count * sizeof(u32));
+	s32 lookup_offset = file.lookup_offset;
+	for(s32 s = 0; s < size_count; s++)
+	{
+	    mem_copy(lookups[s], save + lookup_offset, lookup_sizes[s]);
+	    if(file.size_offset)
+	    {
+		font_size* size = (font_size*)(save + file.size_offset) + s;
+		size->points        = sizes[s].points;
+		size->glyph_first   = sizes[s].glyph_first;
+		size->glyph_count   = sizes[s].glyph_count;
+		size->glyph_height  = sizes[s].glyph_height;
+		size->glyph_width   = sizes[s].glyph_width;
+		size->line_spacing  = sizes[s].line_spacing;
+		size->lookup_offset = lookup_offset;
+		size->lookup_size   = lookup_sizes[s];
+		size->page_count    = page_counts[s];
+	    }
+	    lookup_offset += lookup_sizes[s];
+	}
+	if(file.pair_count)
+	{
+	    mem_copy(atlas->kerning,    save + file.kerning_offset, (file.glyph_count + 1) * sizeof(u32));
+	    mem_copy(atlas->kern_pairs, save + file.pair_offset,    file.pair_count * sizeof(font_kernpair));
+	}
+	if(file.texture_offset)
+	{
+	    mem_copy(atlas->textures, save + file.texture_offset, file.glyph_count * sizeof(u16));
+	}
+
+	buffers[0] = { save, (u64)head_size };
+	if(file.compression == FONT_COMPRESSION_LZ4)
+	{
+	    u32* chunks = (u32*)(save + file.chunk_offset);
+	    u32  offset = head_size;
+	    for(s32 chunk = 0; chunk < file.chunk_count; chunk++)
+	    {
+		chunks[chunk]      = offset;
+		buffers[1 + chunk] = { compress.slots + (chunk * compress.slot_size), compress.sizes[chunk] };
+		offset += (u32)compress.sizes[chunk];
+	    }
+	    chunks[file.chunk_count] = offset;
+	}
+	else
+	{
+	    buffers[1] = { payload, payload_size };
+	}
+
+	// font (.font), c++ header (.h), bitmap (.bmp)
+	return(output_addfile(request, job->font_file, buffers, buffer_count, "font") &&
+	       (!job->header_file[0] || bake_writeheader(job, atlas, &file, payload, lookups, lookup_sizes, page_counts, request)) &&
+	       bitmap_saveas(request, job->bitmap_file, file.width, file.height, bake_bytesperpixel(atlas->format) * 8, (s8*)pixels,
+			     atlas->texture_count, chain_bytes));
+    }
+    else
+    {
+	// the original layout only knows the ansi code page, 'bake_run' makes sure that's all there is.
+	font_header* header = (font_header*)arena_pushzero(memory, sizeof(font_header));
+	u32*         expand = (u32*)arena_push(memory, (u64)pixel_count * 4);
+	platform_buffer* buffers = (platform_buffer*)arena_push(memory, 2 * sizeof(platform_buffer));
+	if(!header || !expand || !buffers) { return(false); }
+
+	header->width        = atlas->width;
+	header->height       = atlas->height;
+	header->glyph_count  = GLYPH_COUNT;
+	header->glyph_height = atlas->glyph_height;
+	header->glyph_width  = atlas->glyph_width;
+	header->line_spacing = atlas->line_spacing;
+	header->glyph_offset = 9 * sizeof(u32);
+	header->byte_offset  = sizeof(font_header);
+	header->size         = sizeof(font_header) + (pixel_count * 4);
+	mem_copy(atlas->glyphs, header->glyphs, atlas->glyph_count * sizeof(glyph_header));
+
+	// coverage -> rgba32.
+	simd.expand(pixels, expand, pixel_count);
+
+	buffers[0] = { header, sizeof(font_header) };
+	buffers[1] = { expand, (u64)pixel_count * 4 };
+
+	// font (.font), bitmap (.bmp)
+	return(output_addfile(request, job->font_file, buffers, 2, "font") &&
+	       bitmap_saveas(request, job->bitmap_file, atlas->width, atlas->height, 32, (s8*)expand, 1, 0));
+    }
+}
+// cache.
+
+// 'glyph_keys' (one per size) cover what the glyphs look like, 'bake_key' everything else that ends up in the files.
+internal void
+bake_cachekeys(bake_job* job, u64* bake_key, u64* glyph_keys)
+{
+    u64 sizes_key = 0;
+    for(s32 s = 0; s < job->size_count; s++)
+    {
+	u32 glyph[5] = { CACHE_VERSION, DPI, 0, bake_rasterformat(job->format),
+			 bake_isdistance(job->format) ? (u32)job->spread : 0 };
+	mem_copy(&job->points[s], &glyph[2], sizeof(r32));
+	glyph_keys[s] = cache_hash(glyph, sizeof(glyph), job->source->hash);
+	sizes_key     = s ? cache_hash(&glyph_keys[s], sizeof(u64), sizes_key) : glyph_keys[s];
+    }
+
+    u32 bake[8] = { FONT_VERSION, job->format, (u32)job->padding, (u32)job->bleed, (u32)job->levels,
+		    (job->format == FONT_FORMAT_BC4) ? (u32)job->quality : 0, (u32)job->chunk_size, (u32)job->max_texture };
+    *bake_key = cache_hash(job->ranges, strlen(job->ranges), cache_hash(bake, sizeof(bake), sizes_key));
+
+    // the header's arrays are named after its file.
+    if(job->header_file[0])
+    {
+	s8 name[MAX_PATH];
+	header_name(job->header_file, name);
+	*bake_key = cache_hash(name, strlen(name) + 1, *bake_key);
+    }
+}
+// every file or none.
+internal b32
+bake_fetchcache(bake_job* job, u64 bake_key)
+{
+    return(cache_fetch(job->cache, bake_key, "font", job->  font_file) &&
+	   (!job->header_file[0] || cache_fetch(job->cache, bake_key, "h", job->header_file)) &&
+	   cache_fetch(job->cache, bake_key, "bmp",  job->bitmap_file));
+}
+// takes every glyph the cache has, returns how many are left to rasterize (in 'pending').
+internal s32
+bake_cachedglyphs(bake_atlas* atlas, cache_glyphs* cached, u8** glyphs, s32* pending)
+{
+    s32 pending_count = 0;
+    for(s32 g = 0; g < atlas->glyph_count; g++)
+    {
+	cache_glyph* glyph = cache_findglyph(cached, atlas->codepoints[g]);
+	if(!glyph)
+	{
+	    pending[pending_count++] = g;
+	    continue;
+	}
+
+	glyph_header* header = &atlas->glyphs[g];
+	header->character   = bake_character(glyph->codepoint);
+	header->offset      = glyph->offset;
+	header->    spacing = glyph->spacing;
+	header->pre_spacing = glyph->pre_spacing;
+	header->width       = glyph->width;
+	header->height      = glyph->height;
+	glyphs[g] = cached->pixels + glyph->pixel_offset;
+    }
+    return(pending_count);
+}
+// the cached glyphs plus the 'pending' ones just rasterized, as the new entry.
+internal void
+bake_storeglyphs(bake_job* job, u64 glyph_key, bake_atlas* atlas, u8** glyphs, s32* pending, s32 pending_count,
+		 cache_glyphs* cached, arena* memory)
+{
+    s32 count = cached->glyph_count + pending_count;
+    u64*         order  = (u64*)        arena_push(memory, count * sizeof(u64));
+    cache_glyph* merged = (cache_glyph*)arena_push(memory, count * sizeof(cache_glyph));
+    u8**         pixels = (u8**)        arena_push(memory, count * sizeof(u8*));
+
+    b32 success = order && merged && pixels;
+    if(success)
+    {
+	// codepoint, then where it came from (the top bit is the cache).
+	for(s32 g = 0; g < cached->glyph_count; g++)
+	{
+	    order[g] = ((u64)cached->glyphs[g].codepoint << 32) | 0x80000000 | (u32)g;
+	}
+	for(s32 p = 0; p < pending_count; p++)
+	{
+	    order[cached->glyph_count + p] = ((u64)atlas->codepoints[pending[p]] << 32) | (u32)pending[p];
+	}
+	qsort(order, count, sizeof(u64), pack_compare);
+
+	for(s32 o = 0; o < count; o++)
+	{
+	    u32 index = (u32)order[o] & 0x7fffffff;
+	    if(order[o] & 0x80000000)
+	    {
+		merged[o] = cached->glyphs[index];
+		pixels[o] = cached->pixels + merged[o].pixel_offset;
+	    }
+	    else
+	    {
+		glyph_header* header = &atlas->glyphs[index];
+		merged[o] = {};
+		merged[o].codepoint   = atlas->codepoints[index];
+		merged[o].offset      = header->offset;
+		merged[o].spacing     = header->spacing;
+		merged[o].pre_spacing = header->pre_spacing;
+		merged[o].width       = header->width;
+		merged[o].height      = header->height;
+		pixels[o] = glyphs[index];
+	    }
+	}
+	success = cache_writeglyphs(job->cache, glyph_key, bake_bytesperpixel(atlas->format), merged, pixels, count, memory);
+    }
+    if(!success)
+    {
+	platform_debugprint("'cache_writeglyphs' failed!\n");
+    }
+}
+internal r64
+bake_seconds()
+{
+    return(std::chrono::duration<r64>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+// the time since '*lap' goes to 'stage', the next one starts now. always true, so it can go between two steps of a condition.
+internal b32
+bake_lap(bake_job* job, s32 stage, r64* lap)
+{
+    r64 now = bake_seconds();
+    job->stats.seconds[stage] += now - *lap;
+    *lap = now;
+    return(true);
+}
+// what every job reports, baked or not.
+internal b32
+bake_endjob(bake_job* job, b32 success)
+{
+    // glyphs, scratch, atlas and header in one go.
+    job->memory = bake_resetmemory();
+    job->memory.peak        += job->source->file.size;
+    job->memory.allocations += 1; // the truetype file, shared by every job of the source.
+    job->success = success;
+
+    return(success);
+}
+// bakes one size of an opened truetype file, every thread it runs on ('work_span') uses its own arena.
+internal b32
+bake_run(bake_job* job)
+{
+    b32 success = false;
+
+    s32 owner = 0;
+    work_span(&owner);
+    arena* memory = &bake_arenas[owner];
+    job->thread = owner;
+
+    r64 start = bake_seconds();
+    r64 lap   = start;
+
+    bake_memory output_memory = {}; // the output request's arena, reset once the files are written.
+
+    u64 bake_key = 0;
+    u64 glyph_keys[BAKE_MAX_SIZES] = {};
+    if(job->cache[0] && job->size_count >= 1 && job->size_count <= BAKE_MAX_SIZES)
+    {
+	bake_cachekeys(job, &bake_key, glyph_keys);
+	if(bake_fetchcache(job, bake_key))
+	{
+	    job->cached  = true;
+	    job->written = true;
+	    bake_lap(job, BAKE_STAGE_CACHE, &lap);
+	    job->stats.total = bake_seconds() - start;
+	    return(bake_endjob(job, true));
+	}
+    }
+
+    s32 size_count = (job->size_count < 0) ? 0 : ((job->size_count > BAKE_MAX_SIZES) ? BAKE_MAX_SIZES : job->size_count);
+    s32 pixels[BAKE_MAX_SIZES] = {};
+    s32 smallest = 0;
+    for(s32 s = 0; s < size_count; s++)
+    {
+	pixels[s] = (job->points[s]/72)*96*(DPI/96.0f);
+	smallest  = (s == 0 || pixels[s] < smallest) ? pixels[s] : smallest;
+    }
+
+    u32* codepoints = 0;
+    s32  set_count  = job->ranges[0] ? bake_parseranges(job->ranges, &job->source->font, memory, &codepoints)
+				     : bake_defaultset(memory, &codepoints);
+
+    // every size is the same glyphs, one size after another.
+    bake_atlas* atlas = (bake_atlas*)arena_pushzero(memory, sizeof(bake_atlas));
+    bake_atlas* sizes = (bake_atlas*)arena_pushzero(memory, BAKE_MAX_SIZES * sizeof(bake_atlas));
+    atlas->glyph_width  = pixels[0];
+    atlas->glyph_height = pixels[0];
+    atlas->format       = bake_rasterformat(job->format);
+    atlas->spread       = bake_isdistance(job->format) ? job->spread : 0;
+    atlas->glyph_count  = set_count * size_count;
+    atlas->sizes        = sizes;
+    atlas->size_count   = size_count;
+    atlas->points       = job->points[0];
+
+    // with mips every glyph is aligned to the last level's texels and keeps at least half of one as padding,
+    // so bilinear filtering at the edge of its uvs never reaches a neighbour.
+    s32 levels  = (job->levels < 1) ? 1 : job->levels;
+    s32 align   = (levels <= FONT_MAX_LEVELS) ? (1 << (levels - 1)) : 1;
+    s32 padding = (job->padding < 0) ? 0 : job->padding;
+    padding     = (padding < (align / 2)) ? (align / 2) : padding;
+    // bc4: whole blocks, no block (of the atlas) shared by two glyphs.
+    align       = (job->format == FONT_FORMAT_BC4 && align < 4) ? 4 : align;
+    s32 bleed   = (job->bleed > padding) ? padding : ((job->bleed < 0) ? 0 : job->bleed);
+
+    u8**       glyphs  = (u8**)     arena_pushzero(memory, atlas->glyph_count * sizeof(u8*));
+    pack_rect* rects   = (pack_rect*)arena_push   (memory, atlas->glyph_count * sizeof(pack_rect));
+    s32*       pending = (s32*)      arena_push   (memory, atlas->glyph_count * sizeof(s32));
+    atlas->glyphs      = (glyph_header*)arena_pushzero(memory, atlas->glyph_count * sizeof(glyph_header));
+    atlas->codepoints  = (u32*)         arena_push    (memory, atlas->glyph_count * sizeof(u32));
+
+    // glyphs baked before (at this size, in this format) are taken from the cache, the rest is rasterized.
+    cache_glyphs cached[BAKE_MAX_SIZES] = {};
+    s32 pending_counts[BAKE_MAX_SIZES] = {};
+    s32 pending_count = 0;
+    if(pending && atlas->glyphs && atlas->codepoints)
+    {
+	for(s32 s = 0; s < size_count; s++)
+	{
+	    bake_atlas* size = &sizes[s];
+	    size->glyph_first  = s * set_count;
+	    size->glyph_count  = set_count;
+	    size->glyph_width  = pixels[s];
+	    size->glyph_height = pixels[s];
+	    size->format       = atlas->format;
+	    size->spread       = atlas->spread;
+	    size->points       = job->points[s];
+	    size->glyphs       = atlas->glyphs     + size->glyph_first;
+	    size->codepoints   = atlas->codepoints + size->glyph_first;
+	    mem_copy(codepoints, size->codepoints, set_count * sizeof(u32));
+
+	    if(job->cache[0])
+	    {
+		cache_openglyphs(&cached[s], job->cache, glyph_keys[s], bake_bytesperpixel(atlas->format));
+	    }
+	    pending_counts[s] = bake_cachedglyphs(size, &cached[s], glyphs + size->glyph_first, pending + size->glyph_first);
+	    pending_count    += pending_counts[s];
+	}
+    }
+    job->stats.glyph_count = atlas->glyph_count;
+    job->stats.rasterized  = pending_count;
+    bake_lap(job, BAKE_STAGE_CACHE, &lap);
+
+    if(job->size_count < 1 || job->size_count > BAKE_MAX_SIZES)
+    {
+	platform_debugprint("'bake_run' failed! (1 -> 8 sizes, joined by '+')\n");
+    }
+    else if(set_count == 0)
+    {
+	platform_debugprint("'bake_parseranges' failed! (no glyphs, or malformed ranges)\n");
+    }
+    else if(atlas->glyph_count >= FONT_NO_GLYPH)
+    {
+	platform_debugprint("'bake_run' failed! (at most 65534 glyphs, every size's together)\n");
+    }
+    else if(bake_isdistance(job->format) && (job->spread < 1 || job->spread > smallest))
+    {
+	platform_debugprint("'bake_run' failed! (the spread has to be between 1 and the glyph height in pixels)\n");
+    }
+    else if(job->format == FONT_FORMAT_RGBA32 && (job->ranges[0] || size_count > 1))
+    {
+	platform_debugprint("'bake_run' failed! (rgba32 is the original layout, it only holds the ansi code page at one size)\n");
+    }
+    else if(levels > FONT_MAX_LEVELS || (job->format == FONT_FORMAT_RGBA32 && levels > 1))
+    {
+	platform_debugprint("'bake_run' failed! (at most 16 mip levels, and none in the original layout (rgba32))\n");
+    }
+    else if(job->chunk_size < 0 || (job->format == FONT_FORMAT_RGBA32 && job->chunk_size > 0))
+    {
+	platform_debugprint("'bake_run' failed! (no compression in the original layout (rgba32))\n");
+    }
+    else if(job->max_texture < 0 || (job->format == FONT_FORMAT_RGBA32 && job->max_texture > 0))
+    {
+	platform_debugprint("'bake_run' failed! (the original layout (rgba32) is always one texture)\n");
+    }
+    else if(job->format == FONT_FORMAT_RGBA32 && job->header_file[0])
+    {
+	platform_debugprint("'bake_run' failed! (no c++ header of the original layout (rgba32))\n");
+    }
+    else if(!glyphs || !rects || !pending || !atlas->glyphs || !atlas->codepoints)
+    {
+	platform_debugprint("'arena_push' failed!\n");
+    }
+    else if(bake_loadsizes(atlas, &job->source->font, glyphs, pending, pending_counts) &&
+	    bake_lap(job, BAKE_STAGE_RASTER, &lap) && bake_packatlas(atlas, rects, padding, align, job->max_texture, memory))
+    {
+	bake_lap(job, BAKE_STAGE_PACK, &lap);
+	if(job->cache[0] && pending_count)
+	{
+	    for(s32 s = 0; s < size_count; s++)
+	    {
+		if(!pending_counts[s]) { continue; }
+
+		bake_atlas* size = &sizes[s];
+		bake_storeglyphs(job, glyph_keys[s], size, glyphs + size->glyph_first, pending + size->glyph_first,
+				 pending_counts[s], &cached[s], memory);
+	    }
+	    bake_lap(job, BAKE_STAGE_CACHE, &lap);
+	}
+	for(s32 s = 0; s < size_count; s++)
+	{
+	    bake_alignglyphs(&sizes[s]);
+	    if(job->format != FONT_FORMAT_RGBA32 && !bake_kerning(&sizes[s], &job->source->font, memory))
+	    {
+		platform_debugprint("'bake_kerning' failed!\n"); // baked without.
+		sizes[s].kerning    = 0;
+		sizes[s].pair_count = 0;
+	    }
+	}
+	if(!bake_mergekerning(atlas, memory))
+	{
+	    platform_debugprint("'bake_mergekerning' failed!\n"); // baked without.
+	    atlas->kerning    = 0;
+	    atlas->pair_count = 0;
+	}
+	bake_lap(job, BAKE_STAGE_KERNING, &lap);
+
+	job->stats.pair_count    = atlas->pair_count;
+	job->stats.width         = atlas->width;
+	job->stats.height        = atlas->height;
+	job->stats.texture_count = atlas->texture_count;
+	for(s32 g = 0; g < atlas->glyph_count; g++)
+	{
+	    if(!rects[g].packed) { continue; }
+	    job->stats.glyph_area += (u64)atlas->glyphs[g].width * atlas->glyphs[g].height;
+	    job->stats.rect_area  += (u64)rects[g].width * rects[g].height;
+	}
+
+	// an empty atlas can be smaller than the alignment.
+	atlas->level_count = levels;
+	while(atlas->level_count > 1 && ((atlas->width >> (atlas->level_count - 1)) == 0 ||
+					 (atlas->height >> (atlas->level_count - 1)) == 0))
+	{
+	    atlas->level_count--;
+	}
+
+	// everything the files are made of lives on the output request until they're written: the atlas
+	// (and its mips), the blocks, the compressed chunks, the expanded rgba32 pixels and the headers.
+	output_request* request = output_begin();
+
+	// every texture is a whole mip chain, one after another.
+	u64 pixel_count   = (u64)atlas->width * atlas->height;
+	u64 texture_bytes = bake_chainbytes(atlas);
+	u64 chain_bytes   = texture_bytes * atlas->texture_count;
+	u64 block_bytes   = (job->format == FONT_FORMAT_BC4) ? (chain_bytes / 2) + (8 * FONT_MAX_LEVELS * atlas->texture_count) : 0;
+	u64 chunk_bytes   = (job->chunk_size > 0) ? lz_bound(chain_bytes) + (atlas->texture_count * (lz_bound(job->chunk_size) + 8)) : 0;
+	u64 rgba_bytes    = (job->format == FONT_FORMAT_RGBA32) ? (pixel_count * 4) + sizeof(font_header) : 0;
+	arena_reserve(&request->memory, chain_bytes + block_bytes + chunk_bytes + rgba_bytes + sizeof(font_fileheader) +
+		      (atlas->glyph_count * (sizeof(glyph_header) + (2 * sizeof(u32)) + sizeof(u16))) + (atlas->pair_count * sizeof(font_kernpair)) +
+		      (size_count * (ARENA_MINIMUM_BLOCK + sizeof(font_size))) + // the lookups.
+		      sizeof(bitmap_header) + (256 * 4) + ((2 * atlas->height * atlas->texture_count) + 2) * sizeof(platform_buffer) +
+		      (8 * ARENA_ALIGNMENT));
+
+	bake_lap(job, BAKE_STAGE_WAIT, &lap);
+
+	u8* atlas_pixels = (u8*)arena_pushzero(&request->memory, chain_bytes);
+	if(atlas_pixels)
+	{
+	    bake_blitjob blit = {};
+	    blit.atlas         = atlas;
+	    blit.pixels        = atlas_pixels;
+	    blit.glyphs        = glyphs;
+	    blit.rects         = rects;
+	    blit.padding       = padding;
+	    blit.bleed         = bleed;
+	    blit.texture_bytes = texture_bytes;
+
+	    work_run(atlas->glyph_count, bake_blitglyph, &blit);
+	    for(s32 t = 0; t < atlas->texture_count; t++)
+	    {
+		bake_buildlevels(atlas, atlas_pixels + (t * texture_bytes));
+	    }
+	    bake_lap(job, BAKE_STAGE_BLIT, &lap);
+
+	    success = bake_writefont(job, atlas, atlas_pixels, request);
+	    if(!success)
+	    {
+		platform_debugprint("'bake_writefont' failed!\n");
+	    }
+	    bake_lap(job, BAKE_STAGE_ENCODE, &lap);
+	}
+	else
+	{
+	    platform_debugprint("'arena_push' failed!\n");
+	}
+
+	output_memory.peak        = request->memory.peak;
+	output_memory.reserved    = request->memory.reserved;
+	output_memory.allocations = request->memory.allocations;
+	if(success)
+	{
+	    if(job->cache[0])
+	    {
+		mem_copy(job->cache, request->cache, MAX_PATH);
+		request->cache_key = bake_key;
+	    }
+	    job->stats.font_bytes   = output_filebytes(request, 0);
+	    job->stats.bitmap_bytes = output_filebytes(request, 1);
+
+	    request->flush   = job->flush;
+	    request->written = &job->written;
+	    request->seconds = &job->stats.seconds[BAKE_STAGE_WRITE];
+	    output_submit(request);
+	}
+	else
+	{
+	    output_cancel(request);
+	}
+    }
+    else
+    {
+	platform_debugprint("'bake_loadfont' failed!\n");
+    }
+
+    u64 cached_size  = 0;
+    u32 cached_files = 0;
+    for(s32 s = 0; s < size_count; s++)
+    {
+	cached_size  += cached[s].file.size;
+	cached_files += cached[s].file.data ? 1 : 0;
+	cache_closeglyphs(&cached[s]);
+    }
+    job->stats.total = bake_seconds() - start;
+
+    bake_endjob(job, success);
+    job->memory.peak        += output_memory.peak;
+    job->memory.reserved    += output_memory.reserved;
+    job->memory.allocations += output_memory.allocations;
+    if(cached_size)
+    {
+	job->memory.peak        += cached_size;
+	job->memory.allocations += cached_files;
+    }
+    return(success);
+}
+internal b32
+bake_opensource(bake_source* source, s8* ttf_file)
+{
+    source->path = ttf_file;
+    source->file = platform_mapfile(ttf_file);
+    if(!source->file.data)
+    {
+	platform_debugprint("'platform_mapfile' failed!\n");
+	return(false);
+    }
+    if(!ttf_loadfont(&source->font, source->file.data, source->file.size))
+    {
+	platform_debugprint("'ttf_loadfont' failed!\n");
+	platform_unmapfile(source->file);
+	source->file = {};
+	return(false);
+    }
+    if(bake_cache[0])
+    {
+	source->hash = cache_hash(source->file.data, source->file.size, CACHE_VERSION);
+    }
+    return(true);
+}
+internal void
+bake_closesource(bake_source* source)
+{
+    platform_unmapfile(source->file);
+    *source = {};
+}
+
+// Report
+//
+// With -o every bake is reported as json, for build dashboards: the time each stage took, memory, the
+// glyphs, the atlas and how much of it the glyphs fill, and the bytes written. "-" prints it on the
+// standard output (instead of the summary).
+//
+//   { "success": true, "bakes": [ { "ttf": "fonts/Lato-Regular.ttf", "family": "Lato", "font": "out/Lato_72.font",
+//     "points": 72, "format": "r8", "success": true, "written": true, "cached": false,
+//     "seconds": { "total": 0.0121, "cache": 0, "raster": 0.0094, ..., "write": 0.0003 },
+//     "memory": { "peak": 702464, "reserved": 1287168, "allocations": 5 },
+//     "glyphs": 224, "rasterized": 224, "kerning_pairs": 4064,
+//     "atlas": { "width": 512, "height": 392, "textures": 1, "glyph_area": 122734, "rect_area": 144512, "fill": 0.611, "padded_fill": 0.720 },
+//     "bytes": { "font": 229328, "bitmap": 200758 } } ] }
+//
+// 'sizes' is only there when the atlas has more than one, 'points' is the first of them. 'fill' is the glyphs' pixels over the atlas, 'padded_fill' the same with their padding. 'total' is the bake
+// itself, the files are written after it ('write', in the background). Cached bakes only have 'total'.
+//
+
+struct bake_reportbuffer
+{
+    s8* data; // 0 = only counting.
+    u64 size;
+    u64 capacity;
+};
+internal void
+bake_reportprint(bake_reportbuffer* report, const s8* format, ...)
+{
+    u64 left   = (report->data && report->size < report->capacity) ? (report->capacity - report->size) : 0;
+    s8* target = left ? (report->data + report->size) : 0;
+
+    va_list arguments;
+    va_start(arguments, format);
+    s32 length = vsnprintf(target, left, format, arguments);
+    va_end(arguments);
+
+    if(length > 0) { report->size += length; }
+}
+// a json string, quotes, backslashes and control characters escaped.
+internal void
+bake_reportstring(bake_reportbuffer* report, const s8* text)
+{
+    bake_reportprint(report, "\"");
+    for(const u8* c = (const u8*)text; *c; c++)
+    {
+	if     (*c == '"' || *c == '\\') { bake_reportprint(report, "\\%c", *c);     }
+	else if(*c < 0x20)               { bake_reportprint(report, "\\u%04x", *c); }
+	else                             { bake_reportprint(report, "%c", *c);       }
+    }
+    bake_reportprint(report, "\"");
+}
+// name 'name_id' (TTF_NAME_*) of the font as utf-8, windows unicode names first (english), then any unicode
+// name, then mac roman. false if the font has none, 'name' is always terminated.
+internal b32
+bake_fontname(ttf_font* font, u16 name_id, s8* name, s32 capacity)
+{
+    if(capacity < 1) { return(false); }
+    name[0] = 0;
+
+    ttf_table table   = font->tables[TTF_TABLE_NAME];
+    s32       count   = ttf_tableu16(font, table, 2);
+    ttf_table storage = ttf_subtable(table, ttf_tableu16(font, table, 4));
+
+    s32 best        = 0;
+    u32 best_offset = 0;
+    u32 best_length = 0;
+    for(s32 record = 0; record < count; record++)
+    {
+	u32 at = 6 + (record * 12);
+	if(!ttf_inside(table, at, 12)) { break; }
+	if(ttf_tableu16(font, table, at + 6) != name_id) { continue; }
+
+	u16 platform_id = ttf_tableu16(font, table, at);
+	u16 encoding_id = ttf_tableu16(font, table, at + 2);
+	u16 language_id = ttf_tableu16(font, table, at + 4);
+	u16 length      = ttf_tableu16(font, table, at + 8);
+	u16 offset      = ttf_tableu16(font, table, at + 10);
+	if(!ttf_inside(storage, offset, length)) { continue; }
+
+	s32 rank = 0;
+	if(platform_id == 3 && (encoding_id == 1 || encoding_id == 10)) { rank = (language_id == 0x409) ? 4 : 3; }
+	if(platform_id == 0)                                            { rank = 3; }
+	if(platform_id == 3 && encoding_id == 0)                        { rank = 2; } // symbol, also utf-16.
+	if(platform_id == 1 && encoding_id == 0)                        { rank = 1; }
+	if(rank > best)
+	{
+	    best        = rank;
+	    best_offset = offset;
+	    best_length = length;
+	}
+    }
+    if(best == 0) { return(false); }
+
+    u8* text = font->data + storage.offset + best_offset;
+    s32 size = 0;
+    if(best == 1)
+    {
+	// mac roman, the ascii half is all a name needs, the rest becomes '?'.
+	for(u32 c = 0; c < best_length && size < (capacity - 1); c++)
+	{
+	    name[size++] = (text[c] < 0x80) ? (s8)text[c] : '?';
+	}
+    }
+    else
+    {
+	// utf-16 (big-endian) -> utf-8.
+	for(u32 c = 0; (c + 2) <= best_length;)
+	{
+	    u32 codepoint = ttf_u16(text + c);
+	    c += 2;
+	    if(codepoint >= 0xd800 && codepoint < 0xdc00 && (c + 2) <= best_length)
+	    {
+		u32 low = ttf_u16(text + c);
+		if(low >= 0xdc00 && low < 0xe000)
+		{
+		    codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+		    c += 2;
+		}
+	    }
+	    if(codepoint >= 0xd800 && codepoint < 0xe000) { codepoint = '?'; } // unpaired.
+
+	    u8  bytes[4];
+	    s32 byte_count = 0;
+	    if(codepoint < 0x80)         { bytes[byte_count++] = (u8)codepoint; }
+	    else if(codepoint < 0x800)   { bytes[byte_count++] = (u8)(0xc0 | (codepoint >> 6));
+					   bytes[byte_count++] = (u8)(0x80 | (codepoint & 0x3f)); }
+	    else if(codepoint < 0x10000) { bytes[byte_count++] = (u8)(0xe0 | (codepoint >> 12));
+					   bytes[byte_count++] = (u8)(0x80 | ((codepoint >> 6) & 0x3f));
+					   bytes[byte_count++] = (u8)(0x80 | (codepoint & 0x3f)); }
+	    else                         { bytes[byte_count++] = (u8)(0xf0 | (codepoint >> 18));
+					   bytes[byte_count++] = (u8)(0x80 | ((codepoint >> 12) & 0x3f));
+					   bytes[byte_count++] = (u8)(0x80 | ((codepoint >> 6) & 0x3f));
+					   bytes[byte_count++] = (u8)(0x80 | (codepoint & 0x3f)); }
+	    if((size + byte_count) > (capacity - 1)) { break; }
+
+	    mem_copy(bytes, name + size, byte_count);
+	    size += byte_count;
+	}
+    }
+    name[size] = 0;
+    return(size > 0);
+}
+internal void
+bake_reportjobs(bake_reportbuffer* report, bake_job* jobs, s32 job_count, b32 success)
+{
+    const s8* formats[5] = { "rgba32", "r8", "sdf", "msdf", "bc4" };
+    const s8* stages[BAKE_STAGE_COUNT] = { "cache", "raster", "pack", "kerning", "wait", "blit", "encode", "write" };
+
+    bake_reportprint(report, "{ \"success\": %s, \"bakes\": [", success ? "true" : "false");
+    for(s32 j = 0; j < job_count; j++)
+    {
+	bake_job*   job   = &jobs[j];
+	bake_stats* stats = &job->stats;
+
+	s8 family[256] = {};
+	if(job->source->file.data) { bake_fontname(&job->source->font, TTF_NAME_FAMILY, family, sizeof(family)); }
+
+	bake_reportprint(report, "%s\n  { \"ttf\": ", (j > 0) ? "," : "");
+	bake_reportstring(report, job->source->path ? job->source->path : "");
+	bake_reportprint(report, ", \"family\": ");
+	bake_reportstring(report, family);
+	bake_reportprint(report, ", \"font\": ");
+	bake_reportstring(report, job->font_file);
+	bake_reportprint(report, ", \"points\": %g", job->points[0]);
+	if(job->size_count > 1)
+	{
+	    for(s32 s = 0; s < job->size_count && s < BAKE_MAX_SIZES; s++)
+	    {
+		bake_reportprint(report, "%s%g", s ? ", " : ", \"sizes\": [ ", job->points[s]);
+	    }
+	    bake_reportprint(report, " ]");
+	}
+	bake_reportprint(report, ", \"format\": \"%s\", \"success\": %s, \"written\": %s, \"cached\": %s,\n",
+			 (job->format < 5) ? formats[job->format] : "?",
+			 job->success ? "true" : "false", job->written ? "true" : "false", job->cached ? "true" : "false");
+
+	bake_reportprint(report, "    \"seconds\": { \"total\": %.6f", stats->total);
+	for(s32 stage = 0; stage < BAKE_STAGE_COUNT; stage++)
+	{
+	    bake_reportprint(report, ", \"%s\": %.6f", stages[stage], stats->seconds[stage]);
+	}
+	bake_reportprint(report, " },\n    \"memory\": { \"peak\": %llu, \"reserved\": %llu, \"allocations\": %u },\n",
+			 (unsigned long long)job->memory.peak, (unsigned long long)job->memory.reserved, job->memory.allocations);
+
+	u64 atlas_area = (u64)stats->width * stats->height * stats->texture_count; // every texture.
+	bake_reportprint(report, "    \"glyphs\": %d, \"rasterized\": %d, \"kerning_pairs\": %d,\n",
+			 stats->glyph_count, stats->rasterized, stats->pair_count);
+	bake_reportprint(report, "    \"atlas\": { \"width\": %d, \"height\": %d, \"textures\": %d, \"glyph_area\": %llu, \"rect_area\": %llu, \"fill\": %.4f, \"padded_fill\": %.4f },\n",
+			 stats->width, stats->height, stats->texture_count, (unsigned long long)stats->glyph_area, (unsigned long long)stats->rect_area,
+			 atlas_area ? (r64)stats->glyph_area / atlas_area : 0.0, atlas_area ? (r64)stats->rect_area / atlas_area : 0.0);
+	bake_reportprint(report, "    \"bytes\": { \"font\": %llu, \"bitmap\": %llu } }",
+			 (unsigned long long)stats->font_bytes, (unsigned long long)stats->bitmap_bytes);
+    }
+    bake_reportprint(report, "%s] }\n", job_count ? "\n" : " ");
+}
+// the report of 'jobs' to 'bake_report' (-o), false if it couldn't be written.
+internal b32
+bake_writereport(bake_job* jobs, s32 job_count, b32 success)
+{
+    // once to size it, once to write it.
+    bake_reportbuffer report = {};
+    bake_reportjobs(&report, jobs, job_count, success);
+
+    report.capacity = report.size + 1;
+    report.data     = (s8*)platform_allocate(report.capacity);
+    report.size     = 0;
+    if(!report.data)
+    {
+	platform_debugprint("'platform_allocate' failed!\n");
+	return(false);
+    }
+    bake_reportjobs(&report, jobs, job_count, success);
+
+    b32 written = (strcmp(bake_report, "-") == 0) ? platform_print(report.data, report.size)
+						  : platform_writefile(bake_report, report.size, report.data);
+    if(!written)
+    {
+	platform_debugprint("'bake_writereport' failed!\n");
+    }
+    platform_deallocate(report.data);
+    return(written);
+}
+// bakes the command line (or gui) settings.
+internal b32
+bake_font()
+{
+    b32 success = false;
+
+    bake_source source = {};
+    source.path = open_file;
+
+    bake_job job = {};
+    job.source      = &source;
+    job.size_count  = bake_parsesizes(fontheight_field, job.points);
+    job.format      = bake_format;
+    job.padding     = bake_padding;
+    job.bleed       = bake_bleed;
+    job.spread      = bake_spread;
+    job.levels      = bake_levels;
+    job.quality     = bake_quality;
+    job.chunk_size  = bake_chunk * 1024;
+    job.flush       = bake_flush;
+    job.max_texture = bake_maxtexture;
+    mem_copy(bake_ranges, job.ranges, BAKE_MAX_RANGES);
+    mem_copy(bake_cache,  job.cache,  MAX_PATH);
+    mem_copy(  save_file, job.  font_file, MAX_PATH);
+    mem_copy(bitmap_file, job.bitmap_file, MAX_PATH);
+    if(bake_embed) { header_path(save_file, job.header_file); }
+
+    // does the ttf file exist?
+    if(platform_fileexists(open_file))
+    {
+	if(bake_opensource(&source, open_file))
+	{
+	    output_startup();
+	    success = bake_run(&job);
+	    output_shutdown();
+	    success = success && job.written;
+	    bake_lastmemory = job.memory;
+	    bake_lastcached = job.cached ? 1 : 0;
+	}
+    }
+    else
+    {
+	platform_debugprint("'bake_font' failed!\n");
+
+	// error: specified truetype file does not exist.
+    }
+
+    // the report is written even when the bake failed, that's when it's needed most.
+    if(bake_report[0])
+    {
+	success = bake_writereport(&job, 1, success) && success;
+    }
+    bake_closesource(&source);
+
+    return(success);
+}
+
+// Batch
+//
+// A manifest lists one truetype file per line, the sizes to bake it at and where to save them:
+//
+//   # comment
+//   fonts/DMMono-Regular.ttf  12,24,48  out/DMMono_{size}.font
+//   "fonts/Open Sans.ttf"     72        "out/Open Sans.font"
+//   fonts/NotoSans.ttf        32        out/NotoSans.font       20-7e,400-4ff
+//   fonts/Lato-Regular.ttf    12+16+24  out/Lato_ui.font
+//
+// Sizes joined by '+' are one job, baked into one atlas (like -h"12+16+24"). '{size}' in the output
+// is replaced with the size. Without it (and with more than one size)
+// '_<size>' goes in front of the extension. The last column is optional, the codepoint ranges
+// of the line (like -u). -p, -b, -f, -r, -l, -q, -z, -x, -y, -e, -u, -c and -dpi apply to every job.
+//
+// Every truetype file is read and parsed once. With at least as many jobs as threads every job
+// is baked on a single thread and the jobs are spread, otherwise the jobs run one after another
+// and spread their glyphs instead.
+//
+
+struct bake_batch
+{
+    bake_source* sources;
+    s8         (*source_files)[MAX_PATH];
+    s32          source_count;
+
+    bake_job* jobs;
+    s32       job_count;
+};
+
+// next token of the line, quotes group spaces. false at the end of the line.
+internal b32
+bake_manifesttoken(s8** cursor, s8* end, s8* token)
+{
+    s8* c = *cursor;
+    while(c < end && (*c == ' ' || *c == '\t' || *c == '\r')) { c++; }
+    if(c >= end || *c == '\n' || *c == '#') { *cursor = c; return(false); }
+
+    s32 size = 0;
+    if(*c == '"')
+    {
+	c++;
+	while(c < end && *c != '"' && *c != '\n')
+	{
+	    if(size < (MAX_PATH - 1)) { token[size++] = *c; }
+	    c++;
+	}
+	if(c < end && *c == '"') { c++; }
+    }
+    else
+    {
+	while(c < end && *c != ' ' && *c != '\t' && *c != '\r' && *c != '\n')
+	{
+	    if(size < (MAX_PATH - 1)) { token[size++] = *c; }
+	    c++;
+	}
+    }
+    token[size] = '\0';
+
+    *cursor = c;
+    return(true);
+}
+// 'output' with '{size}' replaced (or '_size' before the extension when 'suffix').
+internal b32
+bake_manifestpath(s8* output, s8* size, b32 suffix, s8* path)
+{
+    s32 length = 0;
+
+    s8* marker = strstr(output, "{size}");
+    s8* dot    = strrchr(output, '.');
+    s8* slash  = strrchr(output, '/');
+    if(!slash) { slash = strrchr(output, '\\'); }
+    if(dot && slash && dot < slash) { dot = 0; } // a dot in a directory name isn't an extension.
+
+    if(marker)
+    {
+	length = snprintf(path, MAX_PATH, "%.*s%s%s", (s32)(marker - output), output, size, marker + 6);
+    }
+    else if(suffix && dot)
+    {
+	length = snprintf(path, MAX_PATH, "%.*s_%s%s", (s32)(dot - output), output, size, dot);
+    }
+    else if(suffix)
+    {
+	length = snprintf(path, MAX_PATH, "%s_%s", output, size);
+    }
+    else
+    {
+	length = snprintf(path, MAX_PATH, "%s", output);
+    }
+    return(length > 0 && length < MAX_PATH);
+}
+// the jobs of a manifest line, a job per ',' size ('jobs' has room for them). false if the line is invalid.
+internal b32
+bake_linejobs(bake_source* source, s8* sizes, s8* output, s8* ranges, bake_job* jobs, s32* job_count)
+{
+    b32 success = true;
+    b32 suffix  = (strchr(sizes, ',') != 0);
+    for(s8* size = strtok(sizes, ","); size && success; size = strtok(0, ","))
+    {
+	bake_job* job = &jobs[(*job_count)++];
+	job->source      = source;
+	job->size_count  = bake_parsesizes(size, job->points);
+	job->format      = bake_format;
+	job->padding     = bake_padding;
+	job->bleed       = bake_bleed;
+	job->spread      = bake_spread;
+	job->levels      = bake_levels;
+	job->quality     = bake_quality;
+	job->chunk_size  = bake_chunk * 1024;
+	job->flush       = bake_flush;
+	job->max_texture = bake_maxtexture;
+	mem_copy(ranges,     job->ranges, BAKE_MAX_RANGES);
+	mem_copy(bake_cache, job->cache,  MAX_PATH);
+
+	success = (job->size_count > 0) && bake_manifestpath(output, size, suffix, job->font_file);
+	bitmap_path(job->font_file, job->bitmap_file);
+	if(bake_embed) { header_path(job->font_file, job->header_file); }
+    }
+    return(success);
+}
+internal b32
+bake_loadmanifest(bake_batch* batch, s8* manifest_path)
+{
+    platform_file manifest = platform_readfile(manifest_path);
+    if(!manifest.data)
+    {
+	platform_debugprint("'platform_readfile' failed!\n");
+	return(false);
+    }
+
+    // at most a job per size, sizes are comma separated.
+    s8* start = (s8*)manifest.data;
+    s8* end   = start + manifest.size;
+    s32 lines = 1;
+    s32 jobs  = 1;
+    for(s8* c = start; c < end; c++)
+    {
+	if(*c == '\n') { lines++; jobs++; }
+	if(*c == ',')  { jobs++; }
+    }
+    batch->sources      = (bake_source*)platform_allocate(lines * sizeof(bake_source));
+    batch->source_files = (s8(*)[MAX_PATH])platform_allocate(lines * MAX_PATH);
+    batch->jobs         = (bake_job*)platform_allocate(jobs * sizeof(bake_job));
+
+    b32 success = batch->sources && batch->source_files && batch->jobs;
+
+    s8 ttf[MAX_PATH];
+    s8 sizes[MAX_PATH];
+    s8 output[MAX_PATH];
+    s8 ranges[BAKE_MAX_RANGES];
+    s8* cursor = start;
+    for(s32 line = 1; success && cursor < end; line++)
+    {
+	if(bake_manifesttoken(&cursor, end, ttf))
+	{
+	    if(bake_manifesttoken(&cursor, end, sizes) && bake_manifesttoken(&cursor, end, output))
+	    {
+		// the same truetype file on several lines is still only parsed once.
+		s32 source = 0;
+		while(source < batch->source_count && strcmp(batch->source_files[source], ttf) != 0) { source++; }
+		if(source == batch->source_count)
+		{
+		    mem_copy(ttf, batch->source_files[source], MAX_PATH);
+		    batch->source_count++;
+		}
+
+		// optional, the line's ranges instead of -u.
+		if(!bake_manifesttoken(&cursor, end, ranges))
+		{
+		    mem_copy(bake_ranges, ranges, BAKE_MAX_RANGES);
+		}
+
+		success = bake_linejobs(&batch->sources[source], sizes, output, ranges, batch->jobs, &batch->job_count);
+	    }
+	    else
+	    {
+		success = false;
+	    }
+	    if(!success)
+	    {
+		s8 message[64];
+		snprintf(message, sizeof(message), "manifest line %d is invalid!\n", line);
+		platform_debugprint(message);
+	    }
+	}
+
+	while(cursor < end && *cursor != '\n') { cursor++; } // rest of the line (comment).
+	cursor++;
+    }
+
+    platform_freefile(manifest);
+    return(success && batch->job_count > 0);
+}
+internal void
+bake_batchjob(void* data, s32 thread, s32 j)
+{
+    bake_job* job = &((bake_job*)data)[j];
+    if(job->source->file.data)
+    {
+	bake_run(job);
+    }
+}
+// every job on a thread of its own when there are enough of them, otherwise one after another (spreading their glyphs).
+internal void
+bake_runjobs(bake_job* jobs, s32 job_count)
+{
+    s32 first_thread = 0;
+    if(job_count >= work_span(&first_thread))
+    {
+	work_run(job_count, bake_batchjob, jobs);
+    }
+    else
+    {
+	for(s32 j = 0; j < job_count; j++)
+	{
+	    bake_batchjob(jobs, 0, j);
+	}
+    }
+}
+internal void
+bake_freebatch(bake_batch* batch)
+{
+    for(s32 source = 0; source < batch->source_count; source++)
+    {
+	bake_closesource(&batch->sources[source]);
+    }
+    platform_deallocate(batch->sources);
+    platform_deallocate(batch->source_files);
+    platform_deallocate(batch->jobs);
+    *batch = {};
+}
+// bakes every job of the manifest, returns how many succeeded (in 'baked') and whether all of them did.
+internal b32
+bake_manifest(s8* manifest_path, s32* baked, s32* job_count)
+{
+    bake_batch batch = {};
+    b32 success = bake_loadmanifest(&batch, manifest_path);
+    if(success)
+    {
+	bake_memory memory = {};
+	bake_lastcached = 0;
+	for(s32 source = 0; source < batch.source_count; source++)
+	{
+	    if(bake_opensource(&batch.sources[source], batch.source_files[source]))
+	    {
+		memory.peak += batch.sources[source].file.size;
+		memory.allocations++;
+	    }
+	}
+
+	output_startup();
+	bake_runjobs(batch.jobs, batch.job_count);
+	output_shutdown();
+
+	// the biggest job of every thread is the most that thread ever held at once.
+	u64 thread_peak    [WORK_MAX_THREADS] = {};
+	u64 thread_reserved[WORK_MAX_THREADS] = {};
+	for(s32 j = 0; j < batch.job_count; j++)
+	{
+	    bake_job* job = &batch.jobs[j];
+	    if(job->success && job->written)
+	    {
+		(*baked)++;
+		if(job->cached) { bake_lastcached++; }
+	    }
+	    else
+	    {
+		platform_debugprint(job->success ? "'output_writer' failed: " : "'bake_run' failed: ");
+		platform_debugprint(job->font_file);
+		platform_debugprint("\n");
+	    }
+	    if(!job->source->file.data) { continue; } // never ran.
+
+	    // the truetype files are counted once, above.
+	    u64 peak = job->memory.peak - job->source->file.size;
+	    if(peak                 > thread_peak    [job->thread]) { thread_peak    [job->thread] = peak; }
+	    if(job->memory.reserved > thread_reserved[job->thread]) { thread_reserved[job->thread] = job->memory.reserved; }
+	    memory.allocations += job->memory.allocations - 1;
+	}
+	for(s32 thread = 0; thread < WORK_MAX_THREADS; thread++)
+	{
+	    memory.peak     += thread_peak    [thread];
+	    memory.reserved += thread_reserved[thread];
+	}
+	bake_lastmemory = memory;
+
+	success = (*baked == batch.job_count);
+    }
+    *job_count = batch.job_count;
+
+    if(bake_report[0])
+    {
+	success = bake_writereport(batch.jobs, batch.job_count, success) && success;
+    }
+
+    bake_freebatch(&batch);
+    return(success);
+}
+
+// -e, the atlas as a c++ header.
+#include "atlas_baked_embed.cpp"
+
+// -w, bakes requests until it's told to quit. only the command line serves, programs that bring their own
+// main (ATLAS_BAKED_NO_MAIN) leave it out.
+#ifndef ATLAS_BAKED_NO_MAIN
+#include "atlas_baked_server.cpp"
+#endif
+
+// glyphs rasterized by the running program rather than baked, reuses the rasterizer above. the baker doesn't
+// use it, programs that do define ATLAS_BAKED_DYNAMIC.
+#ifdef ATLAS_BAKED_DYNAMIC
+#include "atlas_baked_dynamic.cpp"
+#endif
@@ -0,0 +1,113 @@
+// Arena
+//
+// Bump allocator for everything a bake needs, released all at once.
+//
+// An arena is a chain of blocks from 'platform_allocate', every push is taken from the newest block
+// and a new (bigger) block is only chained on when it runs out. 'arena_reserve' sizes the block up
+// front so a bake normally makes one allocation per arena. Pushes are not zeroed and an arena is
+// only ever used by one thread at a time (every worker has its own).
+//
+// 'arena_reset' frees all but the newest block, so the next bake starts with the largest one.
+//
+
+#define ARENA_ALIGNMENT     16
+#define ARENA_MINIMUM_BLOCK (64 * 1024)
+
+struct arena_block
+{
+    arena_block* previous;
+    u64          size; // including this header.
+    u64          used;
+};
+struct arena
+{
+    arena_block* block;
+
+    u64 used;        // in every block, since the last reset.
+    u64 peak;        // most 'used' ever was.
+    u64 reserved;    // bytes currently held from the os.
+    u32 allocations; // blocks ever allocated.
+};
+
+internal u64 arena_align(u64 size) { return((size + (ARENA_ALIGNMENT - 1)) & ~(u64)(ARENA_ALIGNMENT - 1)); }
+
+internal b32
+arena_grow(arena* memory, u64 size)
+{
+    u64 block_size = arena_align(sizeof(arena_block)) + size;
+    if(memory->block && block_size < (memory->block->size * 2))
+    {
+	block_size = memory->block->size * 2;
+    }
+    if(block_size < ARENA_MINIMUM_BLOCK) { block_size = ARENA_MINIMUM_BLOCK; }
+
+    arena_block* block = (arena_block*)platform_allocate(block_size);
+    if(!block) { return(false); }
+
+    block->previous = memory->block;
+    block->size     = block_size;
+    block->used     = arena_align(sizeof(arena_block));
+
+    memory->block     = block;
+    memory->reserved += block_size;
+    memory->allocations++;
+    return(true);
+}
+// makes sure the next 'size' bytes come from one block.
+internal b32
+arena_reserve(arena* memory, u64 size)
+{
+    size = arena_align(size);
+    if(memory->block && (memory->block->used + size) <= memory->block->size) { return(true); }
+
+    return(arena_grow(memory, size));
+}
+internal void*
+arena_push(arena* memory, u64 size)
+{
+    if(size == 0) { return(0); }
+
+    size = arena_align(size);
+    if(!arena_reserve(memory, size)) { return(0); }
+
+    void* result = (u8*)memory->block + memory->block->used;
+    memory->block->used += size;
+
+    memory->used += size;
+    if(memory->used > memory->peak) { memory->peak = memory->used; }
+
+    return(result);
+}
+internal void*
+arena_pushzero(arena* memory, u64 size)
+{
+    void* result = arena_push(memory, size);
+    if(result) { memset(result, 0, size); }
+    return(result);
+}
+internal void
+arena_reset(arena* memory)
+{
+    arena_block* block = memory->block;
+    if(block)
+    {
+	while(block->previous)
+	{
+	    arena_block* previous = block->previous;
+	    block->previous = previous->previous;
+
+	    memory->reserved -= previous->size;
+	    platform_deallocate(previous);
+	}
+	block->used = arena_align(sizeof(arena_block));
+    }
+    memory->used = 0;
+}
+internal void
+arena_release(arena* memory)
+{
+    arena_reset(memory);
+    platform_deallocate(memory->block);
+
+    *memory = {};
+}
@@ -0,0 +1,269 @@
+// BC4
+//
+// Single channel block compression (BC4 unorm, DXT5's alpha block), 4x4 texels in 8 bytes:
+//
+//   u8  red_0, red_1
+//   u48 indices      3 bits per texel, texel 0 in the lowest bits, rows first
+//
+// red_0 >  red_1: red_0, red_1 and 6 values in between.
+// red_0 <= red_1: red_0, red_1, 4 values in between, 0 and 255.
+//
+// Glyph blocks are mostly empty or solid with an anti-aliased edge through them, which the second
+// mode keeps exact (0 and 255 for free, the palette spent on the edge).
+//
+// quality:
+//   0  min/max endpoints, first mode only.
+//   1  both modes, the one with the smaller error wins.
+//   2  both modes, every endpoint pair within 'BC4_SEARCH' of min/max is tried, then refined with up to
+//      'BC4_REFINE' least squares fits of the endpoints to the indices.
+//
+// Blocks past the edge of the image repeat its last row/column. Rows are encoded in memory order
+// (bottom-up, like the atlas), block row 0 is rows 0 -> 3.
+//
+
+#define BC4_SEARCH 2
+#define BC4_REFINE 2
+
+internal void
+bc4_palette(s32 red_0, s32 red_1, s32* palette)
+{
+    palette[0] = red_0;
+    palette[1] = red_1;
+    if(red_0 > red_1)
+    {
+	for(s32 i = 1; i < 7; i++)
+	{
+	    palette[i + 1] = (((7 - i) * red_0) + (i * red_1) + 3) / 7;
+	}
+    }
+    else
+    {
+	for(s32 i = 1; i < 5; i++)
+	{
+	    palette[i + 1] = (((5 - i) * red_0) + (i * red_1) + 2) / 5;
+	}
+	palette[6] = 0;
+	palette[7] = 255;
+    }
+}
+// nearest palette entry of every texel, returns the squared error.
+internal s32
+bc4_fit(u8* texels, s32 red_0, s32 red_1, u8* indices)
+{
+    s32 palette[8];
+    bc4_palette(red_0, red_1, palette);
+
+    s32 error = 0;
+    for(s32 t = 0; t < 16; t++)
+    {
+	s32 best       = 0;
+	s32 best_error = 256 * 256;
+	for(s32 i = 0; i < 8; i++)
+	{
+	    s32 d = texels[t] - palette[i];
+	    if((d * d) < best_error)
+	    {
+		best       = i;
+		best_error = d * d;
+	    }
+	}
+	indices[t] = (u8)best;
+	error += best_error;
+    }
+    return(error);
+}
+// least squares endpoints for the texels' current 'indices' (0 and 255 of the second mode don't count).
+internal b32
+bc4_refit(u8* texels, u8* indices, b32 first_mode, s32* red_0, s32* red_1)
+{
+    r32 aa = 0, ab = 0, bb = 0, av = 0, bv = 0;
+    for(s32 t = 0; t < 16; t++)
+    {
+	s32 index = indices[t];
+	if(!first_mode && index >= 6) { continue; }
+
+	// value = (1 - w) * red_0 + w * red_1.
+	r32 w = (index == 0) ? 0.0f : ((index == 1) ? 1.0f : (r32)(index - 1) / (first_mode ? 7.0f : 5.0f));
+	r32 a = 1.0f - w;
+	aa += a * a;
+	ab += a * w;
+	bb += w * w;
+	av += a * texels[t];
+	bv += w * texels[t];
+    }
+    r32 determinant = (aa * bb) - (ab * ab);
+    if(determinant < 0.0001f) { return(false); }
+
+    r32 r_0 = ((bb * av) - (ab * bv)) / determinant;
+    r32 r_1 = ((aa * bv) - (ab * av)) / determinant;
+    *red_0 = (r_0 < 0.0f) ? 0 : ((r_0 > 255.0f) ? 255 : (s32)(r_0 + 0.5f));
+    *red_1 = (r_1 < 0.0f) ? 0 : ((r_1 > 255.0f) ? 255 : (s32)(r_1 + 0.5f));
+    return(true);
+}
+// tries 'red_0', 'red_1' (every pair around them with 'search', then 'refine' least squares fits), keeps the
+// best in 'best_*'. each pair stays in the mode 'red_0', 'red_1' are in.
+internal void
+bc4_try(u8* texels, s32 red_0, s32 red_1, s32 search, s32 refine, s32* best_error, s32* best_0, s32* best_1, u8* best_indices)
+{
+    b32 first_mode = (red_0 > red_1);
+
+    s32 error = 0x7fffffff;
+    s32 r_0   = red_0;
+    s32 r_1   = red_1;
+    u8  indices[16];
+    for(s32 d_0 = -search; d_0 <= search; d_0++)
+    {
+	for(s32 d_1 = -search; d_1 <= search; d_1++)
+	{
+	    s32 try_0 = red_0 + d_0;
+	    s32 try_1 = red_1 + d_1;
+	    if(try_0 < 0 || try_0 > 255 || try_1 < 0 || try_1 > 255) { continue; }
+	    if((try_0 > try_1) != first_mode)                         { continue; }
+
+	    u8  try_indices[16];
+	    s32 try_error = bc4_fit(texels, try_0, try_1, try_indices);
+	    if(try_error < error)
+	    {
+		error = try_error;
+		r_0   = try_0;
+		r_1   = try_1;
+		mem_copy(try_indices, indices, 16);
+	    }
+	}
+    }
+    for(s32 r = 0; r < refine && error > 0; r++)
+    {
+	s32 try_0, try_1;
+	if(!bc4_refit(texels, indices, first_mode, &try_0, &try_1)) { break; }
+	if((try_0 > try_1) != first_mode)                           { break; } // rounded into the other mode.
+
+	u8  try_indices[16];
+	s32 try_error = bc4_fit(texels, try_0, try_1, try_indices);
+	if(try_error >= error) { break; }
+
+	error = try_error;
+	r_0   = try_0;
+	r_1   = try_1;
+	mem_copy(try_indices, indices, 16);
+    }
+
+    if(error < *best_error)
+    {
+	*best_error = error;
+	*best_0     = r_0;
+	*best_1     = r_1;
+	mem_copy(indices, best_indices, 16);
+    }
+}
+internal void
+bc4_encodeblock(u8* texels, s32 quality, u8* block)
+{
+    s32 low  = 255;
+    s32 high = 0;
+    s32 inner_low  = 255; // without 0 and 255, the second mode has those anyway.
+    s32 inner_high = 0;
+    for(s32 t = 0; t < 16; t++)
+    {
+	s32 value = texels[t];
+	if(value < low)  { low  = value; }
+	if(value > high) { high = value; }
+	if(value > 0 && value < 255)
+	{
+	    if(value < inner_low)  { inner_low  = value; }
+	    if(value > inner_high) { inner_high = value; }
+	}
+    }
+    if(inner_low > inner_high) { inner_low = inner_high = low; } // only 0 and 255.
+
+    s32 best_error = 0x7fffffff;
+    s32 red_0      = high;
+    s32 red_1      = low;
+    u8  indices[16];
+
+    s32 search = (quality >= 2) ? BC4_SEARCH : 0;
+    s32 refine = (quality >= 2) ? BC4_REFINE : 0;
+    if(high > low)
+    {
+	bc4_try(texels, high, low, search, refine, &best_error, &red_0, &red_1, indices);
+    }
+    if(quality >= 1 || high == low)
+    {
+	bc4_try(texels, inner_low, inner_high, search, refine, &best_error, &red_0, &red_1, indices);
+    }
+
+    u64 bits = 0;
+    for(s32 t = 0; t < 16; t++)
+    {
+	bits |= (u64)indices[t] << (t * 3);
+    }
+    block[0] = (u8)red_0;
+    block[1] = (u8)red_1;
+    for(s32 b = 0; b < 6; b++)
+    {
+	block[2 + b] = (u8)(bits >> (b * 8));
+    }
+}
+internal void
+bc4_decodeblock(u8* block, u8* texels)
+{
+    s32 palette[8];
+    bc4_palette(block[0], block[1], palette);
+
+    u64 bits = 0;
+    for(s32 b = 0; b < 6; b++)
+    {
+	bits |= (u64)block[2 + b] << (b * 8);
+    }
+    for(s32 t = 0; t < 16; t++)
+    {
+	texels[t] = (u8)palette[(bits >> (t * 3)) & 7];
+    }
+}
+internal u64
+bc4_size(s32 width, s32 height)
+{
+    return((u64)((width + 3) / 4) * ((height + 3) / 4) * 8);
+}
+// one row of blocks (4 rows of pixels), 'blocks' is the start of the image's blocks.
+internal void
+bc4_encoderow(u8* pixels, s32 width, s32 height, s32 block_row, s32 quality, u8* blocks)
+{
+    s32 block_count = (width + 3) / 4;
+    u8* block       = blocks + ((u64)block_row * block_count * 8);
+    for(s32 b = 0; b < block_count; b++, block += 8)
+    {
+	u8 texels[16];
+	for(s32 y = 0; y < 4; y++)
+	{
+	    s32 row = (block_row * 4) + y;
+	    row = (row < height) ? row : (height - 1);
+	    for(s32 x = 0; x < 4; x++)
+	    {
+		s32 column = (b * 4) + x;
+		column = (column < width) ? column : (width - 1);
+		texels[(y * 4) + x] = pixels[(row * width) + column];
+	    }
+	}
+	bc4_encodeblock(texels, quality, block);
+    }
+}
+internal void
+bc4_decode(u8* blocks, s32 width, s32 height, u8* pixels)
+{
+    s32 block_count = (width + 3) / 4;
+    for(s32 block_row = 0; block_row < ((height + 3) / 4); block_row++)
+    {
+	for(s32 b = 0; b < block_count; b++)
+	{
+	    u8 texels[16];
+	    bc4_decodeblock(blocks + ((((u64)block_row * block_count) + b) * 8), texels);
+	    for(s32 y = 0; y < 4 && ((block_row * 4) + y) < height; y++)
+	    {
+		for(s32 x = 0; x < 4 && ((b * 4) + x) < width; x++)
+		{
+		    pixels[(((block_row * 4) + y) * width) + (b * 4) + x] = texels[(y * 4) + x];
+		}
+	    }
+	}
+    }
+}
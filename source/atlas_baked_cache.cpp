@@ -0,0 +1,215 @@
+// Cache
+//
+// Content-addressed, on-disk, so an unchanged font is never baked twice.
+//
+// Keys are hashes of everything that goes into the output: the truetype file's bytes, the size,
+// the dpi, the format and the options (see 'bake_cachekeys'). An entry is just a file named after
+// its key, '<directory>/<key>.<extension>':
+//
+//   .font, .bmp   a whole bake, copied to the output on a hit (written with the outputs, see atlas_baked_output.cpp).
+//   .glyphs       every glyph ever rasterized for one font, size, dpi and format (whatever the padding,
+//                 the ranges...), so a different glyph set only rasterizes the glyphs that are new.
+//
+// Entries are copies, never hard links: the outputs are written in place, a link would let the next
+// bake to the same path overwrite the entry as well. Nothing is ever evicted, delete the directory.
+//
+// The hash is not cryptographic, it only has to tell builds apart. Bump 'CACHE_VERSION' whenever the
+// rasterizer changes what it produces.
+//
+
+#define CACHE_VERSION 2
+#define CACHE_MAGIC   0x43474241 // 'ABGC'
+
+// 8 bytes a step, multiply and rotate (murmur style) with a final avalanche.
+internal u64
+cache_hash(void* data, u64 size, u64 seed)
+{
+    u64 prime = 0x9e3779b97f4a7c15ull;
+    u64 hash  = seed ^ (size * prime);
+
+    u8* bytes = (u8*)data;
+    for(; size >= 8; size -= 8, bytes += 8)
+    {
+	u64 word;
+	memcpy(&word, bytes, 8);
+	word *= 0xff51afd7ed558ccdull;
+	word ^= word >> 32;
+	hash  = (hash ^ word) * prime;
+	hash  = (hash << 27) | (hash >> 37);
+    }
+    if(size)
+    {
+	u64 word = 0;
+	memcpy(&word, bytes, size);
+	hash = (hash ^ word) * prime;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return(hash);
+}
+internal b32
+cache_path(s8* directory, u64 key, const s8* extension, s8* path)
+{
+    s32 length = snprintf(path, MAX_PATH, "%s/%016llx.%s", directory, (unsigned long long)key, extension);
+    return(length > 0 && length < MAX_PATH);
+}
+internal b32
+cache_copyfile(s8* source, s8* target)
+{
+    platform_file file = platform_readfile(source);
+    if(!file.data) { return(false); }
+
+    b32 success = platform_writefile(target, file.size, file.data);
+    platform_freefile(file);
+    return(success);
+}
+// entry -> 'target', false on a miss.
+internal b32
+cache_fetch(s8* directory, u64 key, const s8* extension, s8* target)
+{
+    s8 path[MAX_PATH];
+    return(cache_path(directory, key, extension, path) && platform_fileexists(path) && cache_copyfile(path, target));
+}
+
+// glyphs.
+//
+//   cache_glyphfile
+//   cache_glyph  glyphs[glyph_count]    sorted by codepoint
+//   u8           pixels[pixel_size]     every glyph's trimmed pixels, 'width * height * bytes_per_pixel' each
+//
+struct cache_glyph
+{
+    u32 codepoint;
+    s32 offset;  // from the top of the surface, before the glyphs are lined up.
+    s32 spacing;
+    s32 pre_spacing;
+    s32 width;
+    s32 height;
+    u32 pixel_offset; // into 'pixels'.
+};
+struct cache_glyphfile
+{
+    u32 magic;
+    u32 version;
+    u64 key;
+    u64 hash; // of everything after this header, a torn or stale write is a miss.
+    s32 glyph_count;
+    s32 bytes_per_pixel;
+    u64 pixel_size;
+};
+struct cache_glyphs
+{
+    platform_file file;
+
+    cache_glyph* glyphs;
+    u8*          pixels;
+    s32          glyph_count;
+};
+
+internal b32
+cache_openglyphs(cache_glyphs* cache, s8* directory, u64 key, s32 bytes_per_pixel)
+{
+    *cache = {};
+
+    s8 path[MAX_PATH];
+    if(!cache_path(directory, key, "glyphs", path) || !platform_fileexists(path)) { return(false); }
+
+    platform_file file = platform_readfile(path);
+    if(!file.data) { return(false); }
+
+    cache_glyphfile* header = (cache_glyphfile*)file.data;
+    b32 valid = file.size >= sizeof(cache_glyphfile) &&
+		header->magic == CACHE_MAGIC && header->version == CACHE_VERSION && header->key == key &&
+		header->bytes_per_pixel == bytes_per_pixel &&
+		header->glyph_count > 0 && (u64)header->glyph_count <= (file.size / sizeof(cache_glyph)) &&
+		header->pixel_size <= file.size &&
+		(sizeof(cache_glyphfile) + (header->glyph_count * sizeof(cache_glyph)) + header->pixel_size) == file.size &&
+		header->hash == cache_hash(header + 1, file.size - sizeof(cache_glyphfile), key);
+    if(valid)
+    {
+	cache->file        = file;
+	cache->glyphs      = (cache_glyph*)(header + 1);
+	cache->pixels      = (u8*)(cache->glyphs + header->glyph_count);
+	cache->glyph_count = header->glyph_count;
+
+	// the hash only catches accidents, every glyph still has to be inside the file.
+	for(s32 g = 0; g < cache->glyph_count && valid; g++)
+	{
+	    cache_glyph* glyph = &cache->glyphs[g];
+	    u64 size = (u64)glyph->width * glyph->height * bytes_per_pixel;
+	    valid = glyph->width >= 0 && glyph->height >= 0 && (glyph->pixel_offset + size) <= header->pixel_size &&
+		    (g == 0 || cache->glyphs[g - 1].codepoint < glyph->codepoint);
+	}
+    }
+    if(!valid)
+    {
+	platform_freefile(file);
+	*cache = {};
+    }
+    return(valid);
+}
+internal void
+cache_closeglyphs(cache_glyphs* cache)
+{
+    platform_freefile(cache->file);
+    *cache = {};
+}
+internal cache_glyph*
+cache_findglyph(cache_glyphs* cache, u32 codepoint)
+{
+    s32 low  = 0;
+    s32 high = cache->glyph_count - 1;
+    while(low <= high)
+    {
+	s32 middle = (low + high) / 2;
+	u32 found  = cache->glyphs[middle].codepoint;
+	if(found == codepoint) { return(&cache->glyphs[middle]); }
+	if(found <  codepoint) { low  = middle + 1; }
+	else                   { high = middle - 1; }
+    }
+    return(0);
+}
+// 'glyphs' sorted by codepoint, 'pixels' has every glyph's own (their 'pixel_offset' is filled in here).
+internal b32
+cache_writeglyphs(s8* directory, u64 key, s32 bytes_per_pixel, cache_glyph* glyphs, u8** pixels, s32 glyph_count, arena* memory)
+{
+    s8 path[MAX_PATH];
+    if(!cache_path(directory, key, "glyphs", path)) { return(false); }
+
+    u64 pixel_size = 0;
+    for(s32 g = 0; g < glyph_count; g++)
+    {
+	glyphs[g].pixel_offset = (u32)pixel_size;
+	pixel_size += (u64)glyphs[g].width * glyphs[g].height * bytes_per_pixel;
+    }
+    u64 glyph_size = (u64)glyph_count * sizeof(cache_glyph);
+    u64 file_size  = sizeof(cache_glyphfile) + glyph_size + pixel_size;
+    if(file_size >= 0xffffffff) { return(false); }
+
+    u8* save = (u8*)arena_push(memory, file_size);
+    if(!save) { return(false); }
+
+    cache_glyphfile* header = (cache_glyphfile*)save;
+    header->magic           = CACHE_MAGIC;
+    header->version         = CACHE_VERSION;
+    header->key             = key;
+    header->glyph_count     = glyph_count;
+    header->bytes_per_pixel = bytes_per_pixel;
+    header->pixel_size      = pixel_size;
+
+    u8* target = save + sizeof(cache_glyphfile) + glyph_size;
+    mem_copy(glyphs, header + 1, glyph_size);
+    for(s32 g = 0; g < glyph_count; g++)
+    {
+	u64 size = (u64)glyphs[g].width * glyphs[g].height * bytes_per_pixel;
+	if(size) { mem_copy(pixels[g], target + glyphs[g].pixel_offset, size); }
+    }
+    header->hash = cache_hash(header + 1, file_size - sizeof(cache_glyphfile), key);
+
+    platform_makedirectory(directory);
+    return(platform_writefile(path, file_size, save));
+}
@@ -0,0 +1,593 @@
+// Dynamic
+//
+// A glyph cache for the running program, for character sets too big to bake ahead of time (cjk, user
+// names). Glyphs are rasterized when they're first asked for, with the bake's own rasterizer and trimming
+// ('bake_rasterize'), into one texture of a fixed size. When it's full the least recently used glyphs
+// make room. Everything is allocated when the cache is made (the texture, 'glyph_capacity' glyphs, the
+// shelves) plus a scratch per thread, so memory stays the same whatever the script.
+//
+// The texture is cut into shelves (rows), every shelf is one height class: the glyph and its padding,
+// rounded up to 'DYNAMIC_CLASS' pixels. Glyphs of any width share a shelf, every shelf keeps the x spans
+// that are free (sorted, neighbours merged) and a glyph takes the smallest span it fits in. A glyph goes
+// in a shelf of its class (or one class taller), or opens a new shelf, or goes in any shelf tall enough.
+// When none of that works the least recently used glyph is evicted (its span is free again), and again
+// until it fits. Glyphs used since the last 'dynamic_nextframe' are never evicted, they're about to be
+// drawn.
+//
+// Not part of the baker, programs that use it include atlas_baked.cpp with ATLAS_BAKED_NO_MAIN and
+// ATLAS_BAKED_DYNAMIC defined.
+//
+// usage, once a frame:
+//
+//   dynamic_glyph* glyphs[256];
+//   dynamic_ensure(&cache, codepoints, count, glyphs); // 0 for codepoints the font doesn't have (or no room).
+//   s32 dirty = dynamic_dirtyrects(&cache, rects, 64);
+//   upload(cache.pixels, cache.atlas.width, rects, dirty); // only what changed since the last upload.
+//   draw(glyphs, count);
+//   dynamic_nextframe(&cache);
+//
+// Glyph headers are the bake's ('glyph_header'), their uvs point into the cache's texture. Offsets are
+// from the ascent instead of the tallest glyph (the glyphs come and go), the same for every glyph.
+//
+
+#define DYNAMIC_CLASS   8    // pixels, shelf heights are rounded up to it.
+#define DYNAMIC_ALIGN   4    // pixels, widths in a shelf are rounded up to it.
+#define DYNAMIC_PADDING 1    // empty pixels around every glyph (each side).
+#define DYNAMIC_BATCH   256  // glyphs rasterized at a time, the scratch never holds more.
+#define DYNAMIC_NONE    -1
+#define DYNAMIC_EMPTY   0xffffffff // codepoint of a glyph entry that isn't in the cache.
+
+struct dynamic_glyph
+{
+    u32          codepoint;
+    glyph_header header; // uvs in the cache's texture.
+
+    s32 shelf; // DYNAMIC_NONE when it has no pixels.
+    s32 x;     // its span of the shelf.
+    s32 span;
+    u64 frame; // last used.
+
+    s32 newer; // lru list.
+    s32 older;
+    s32 next;  // hash chain, or the unused entries.
+};
+struct dynamic_span
+{
+    s32 x;
+    s32 width;
+};
+struct dynamic_shelf
+{
+    s32 y;
+    s32 height; // pixels, its class.
+    s32 used;   // glyphs in it.
+
+    dynamic_span* spans; // free, by x.
+    s32           span_count;
+
+    s32 dirty_min; // x range written since the last 'dynamic_dirtyrects', min >= max = clean.
+    s32 dirty_max;
+};
+struct dynamic_rect
+{
+    s32 x;
+    s32 y; // bottom row, rows go up like the texture.
+    s32 width;
+    s32 height;
+};
+struct dynamic_cache
+{
+    bake_atlas atlas; // format, spread, the texture size and the metrics. 'glyphs' isn't used.
+    ttf_font*  font;  // not copied, has to outlive the cache.
+    u8*        pixels; // 'atlas.width' * 'atlas.height', 'bake_bytesperpixel' each. bottom-up.
+
+    r32 scale;
+    s32 ascent; // of the surface, see 'bake_loadfont'.
+    s32 raster_pixels;
+
+    dynamic_glyph* glyphs;
+    s32            glyph_capacity;
+    s32*           table;      // hash heads, DYNAMIC_NONE = empty.
+    u32            table_bits;
+    s32            newest;     // lru list, DYNAMIC_NONE = empty.
+    s32            oldest;
+    s32            unused;     // entries with no glyph.
+
+    dynamic_shelf* shelves;
+    s32            shelf_count;
+    s32            shelf_capacity;
+    s32            span_capacity; // per shelf.
+    s32            shelf_top;  // first row no shelf has.
+
+    u64 frame;
+
+    arena        memory; // everything above.
+    bake_scratch scratch[WORK_MAX_THREADS];
+    arena        scratch_memory[WORK_MAX_THREADS]; // the scratch.
+    arena        glyph_memory[WORK_MAX_THREADS];   // trimmed glyphs of one batch.
+};
+
+internal u32
+dynamic_hash(dynamic_cache* cache, u32 codepoint)
+{
+    return((codepoint * 2654435761u) >> (32 - cache->table_bits));
+}
+internal dynamic_glyph*
+dynamic_find(dynamic_cache* cache, u32 codepoint)
+{
+    for(s32 g = cache->table[dynamic_hash(cache, codepoint)]; g != DYNAMIC_NONE; g = cache->glyphs[g].next)
+    {
+	if(cache->glyphs[g].codepoint == codepoint) { return(&cache->glyphs[g]); }
+    }
+    return(0);
+}
+internal void
+dynamic_unlink(dynamic_cache* cache, s32 g)
+{
+    dynamic_glyph* glyph = &cache->glyphs[g];
+    if(glyph->newer != DYNAMIC_NONE) { cache->glyphs[glyph->newer].older = glyph->older; }
+    else                             { cache->newest = glyph->older; }
+    if(glyph->older != DYNAMIC_NONE) { cache->glyphs[glyph->older].newer = glyph->newer; }
+    else                             { cache->oldest = glyph->newer; }
+}
+// marks 'glyph' used this frame, it goes to the front of the lru list.
+internal void
+dynamic_touch(dynamic_cache* cache, dynamic_glyph* glyph)
+{
+    s32 g = (s32)(glyph - cache->glyphs);
+    glyph->frame = cache->frame;
+    if(cache->newest == g) { return; }
+
+    dynamic_unlink(cache, g);
+    glyph->newer = DYNAMIC_NONE;
+    glyph->older = cache->newest;
+    if(cache->newest != DYNAMIC_NONE) { cache->glyphs[cache->newest].newer = g; }
+    cache->newest = g;
+    if(cache->oldest == DYNAMIC_NONE) { cache->oldest = g; }
+}
+// its span goes back to its shelf (merged with the free ones next to it), shelves at the top that nobody
+// uses any more go back to the texture.
+internal void
+dynamic_freespan(dynamic_cache* cache, dynamic_glyph* glyph)
+{
+    if(glyph->shelf == DYNAMIC_NONE) { return; }
+
+    dynamic_shelf* shelf = &cache->shelves[glyph->shelf];
+    dynamic_span*  spans = shelf->spans;
+    s32 index = 0;
+    while(index < shelf->span_count && spans[index].x < glyph->x) { index++; }
+
+    b32 before = (index > 0 && (spans[index - 1].x + spans[index - 1].width) == glyph->x);
+    b32 after  = (index < shelf->span_count && spans[index].x == (glyph->x + glyph->span));
+    if(before && after)
+    {
+	spans[index - 1].width += glyph->span + spans[index].width;
+	memmove(&spans[index], &spans[index + 1], (shelf->span_count - index - 1) * sizeof(dynamic_span));
+	shelf->span_count--;
+    }
+    else if(before)
+    {
+	spans[index - 1].width += glyph->span;
+    }
+    else if(after)
+    {
+	spans[index].x      = glyph->x;
+	spans[index].width += glyph->span;
+    }
+    else
+    {
+	// there's always room, free spans have a taken one between them ('span_capacity').
+	memmove(&spans[index + 1], &spans[index], (shelf->span_count - index) * sizeof(dynamic_span));
+	spans[index] = { glyph->x, glyph->span };
+	shelf->span_count++;
+    }
+    shelf->used--;
+    glyph->shelf = DYNAMIC_NONE;
+
+    while(cache->shelf_count > 0 && cache->shelves[cache->shelf_count - 1].used == 0)
+    {
+	cache->shelf_top -= cache->shelves[cache->shelf_count - 1].height;
+	cache->shelf_count--;
+    }
+}
+// takes 'glyph' out of the cache, its entry is unused again.
+internal void
+dynamic_remove(dynamic_cache* cache, dynamic_glyph* glyph)
+{
+    s32  g    = (s32)(glyph - cache->glyphs);
+    s32* link = &cache->table[dynamic_hash(cache, glyph->codepoint)];
+    while(*link != g) { link = &cache->glyphs[*link].next; }
+    *link = glyph->next;
+
+    dynamic_unlink(cache, g);
+    dynamic_freespan(cache, glyph);
+
+    glyph->codepoint = DYNAMIC_EMPTY;
+    glyph->next      = cache->unused;
+    cache->unused    = g;
+}
+// the least recently used glyph, false when every glyph was used this frame.
+internal b32
+dynamic_evict(dynamic_cache* cache)
+{
+    if(cache->oldest == DYNAMIC_NONE || cache->glyphs[cache->oldest].frame == cache->frame) { return(false); }
+
+    dynamic_remove(cache, &cache->glyphs[cache->oldest]);
+    return(true);
+}
+// a new entry for 'codepoint' (no pixels yet), used this frame. 0 when every entry was used this frame.
+internal dynamic_glyph*
+dynamic_insert(dynamic_cache* cache, u32 codepoint)
+{
+    if(cache->unused == DYNAMIC_NONE && !dynamic_evict(cache)) { return(0); }
+
+    s32            g     = cache->unused;
+    dynamic_glyph* glyph = &cache->glyphs[g];
+    cache->unused = glyph->next;
+
+    u32 hash = dynamic_hash(cache, codepoint);
+    *glyph = {};
+    glyph->codepoint   = codepoint;
+    glyph->shelf       = DYNAMIC_NONE;
+    glyph->frame       = cache->frame;
+    glyph->newer       = DYNAMIC_NONE;
+    glyph->older       = cache->newest;
+    glyph->next        = cache->table[hash];
+    cache->table[hash] = g;
+
+    if(cache->newest != DYNAMIC_NONE) { cache->glyphs[cache->newest].newer = g; }
+    else                              { cache->oldest = g; }
+    cache->newest = g;
+    return(glyph);
+}
+// the smallest free span of at least 'width' in the lowest shelf 'height' -> 'max_height' tall, DYNAMIC_NONE
+// for 'shelf_index' when there's none.
+internal void
+dynamic_findspan(dynamic_cache* cache, s32 width, s32 height, s32 max_height, s32* shelf_index, s32* span_index)
+{
+    *shelf_index = DYNAMIC_NONE;
+
+    s32 best_height = 0;
+    s32 best_width  = 0;
+    for(s32 s = 0; s < cache->shelf_count; s++)
+    {
+	dynamic_shelf* shelf = &cache->shelves[s];
+	if(shelf->height < height || shelf->height > max_height) { continue; }
+	if(*shelf_index != DYNAMIC_NONE && shelf->height > best_height) { continue; }
+
+	for(s32 span = 0; span < shelf->span_count; span++)
+	{
+	    s32 span_width = shelf->spans[span].width;
+	    if(span_width < width) { continue; }
+
+	    if(*shelf_index == DYNAMIC_NONE || shelf->height < best_height || span_width < best_width)
+	    {
+		*shelf_index = s;
+		*span_index  = span;
+		best_height  = shelf->height;
+		best_width   = span_width;
+	    }
+	}
+    }
+}
+// a new shelf of 'height' on top of the others, DYNAMIC_NONE when the texture has no rows left.
+internal s32
+dynamic_openshelf(dynamic_cache* cache, s32 height)
+{
+    if((cache->shelf_top + height) > cache->atlas.height || cache->shelf_count >= cache->shelf_capacity) { return(DYNAMIC_NONE); }
+
+    s32            s     = cache->shelf_count++;
+    dynamic_shelf* shelf = &cache->shelves[s];
+    shelf->y          = cache->shelf_top;
+    shelf->height     = height;
+    shelf->used       = 0;
+    shelf->spans[0]   = { 0, cache->atlas.width };
+    shelf->span_count = 1;
+    shelf->dirty_min  = 0;
+    shelf->dirty_max  = 0;
+    cache->shelf_top += height;
+    return(s);
+}
+// copies the trimmed glyph into a span of a shelf, evicting what it has to. false if it doesn't fit.
+internal b32
+dynamic_place(dynamic_cache* cache, dynamic_glyph* glyph, u8* trimmed)
+{
+    glyph_header* header = &glyph->header;
+    if(!header->width || !header->height)
+    {
+	header->u0 = header->u1 = header->v0 = header->v1 = 0.0f; // empty glyph (space), nothing to sample.
+	return(true);
+    }
+    if(!trimmed) { return(false); }
+
+    s32 width  = (header->width  + (DYNAMIC_PADDING * 2) + (DYNAMIC_ALIGN - 1)) & ~(DYNAMIC_ALIGN - 1);
+    s32 height = (header->height + (DYNAMIC_PADDING * 2) + (DYNAMIC_CLASS - 1)) & ~(DYNAMIC_CLASS - 1);
+    if(width > cache->atlas.width || height > cache->atlas.height) { return(false); }
+
+    // its class (or one taller), a new shelf, any shelf tall enough, then make room.
+    s32 shelf_index = DYNAMIC_NONE;
+    s32 span_index  = 0;
+    for(;;)
+    {
+	dynamic_findspan(cache, width, height, height + DYNAMIC_CLASS, &shelf_index, &span_index);
+	if(shelf_index != DYNAMIC_NONE) { break; }
+
+	shelf_index = dynamic_openshelf(cache, height);
+	if(shelf_index != DYNAMIC_NONE) { break; }
+
+	dynamic_findspan(cache, width, height, cache->atlas.height, &shelf_index, &span_index);
+	if(shelf_index != DYNAMIC_NONE || !dynamic_evict(cache)) { break; }
+    }
+    if(shelf_index == DYNAMIC_NONE) { return(false); }
+
+    dynamic_shelf* shelf = &cache->shelves[shelf_index];
+    dynamic_span*  span  = &shelf->spans[span_index];
+    s32 x = span->x;
+    span->x     += width;
+    span->width -= width;
+    if(span->width == 0)
+    {
+	memmove(span, span + 1, (shelf->span_count - span_index - 1) * sizeof(dynamic_span));
+	shelf->span_count--;
+    }
+    shelf->used++;
+    glyph->shelf = shelf_index;
+    glyph->x     = x;
+    glyph->span  = width;
+
+    // the span is cleared first, whatever was there before shows through the padding otherwise.
+    s32 bytes  = bake_bytesperpixel(cache->atlas.format);
+    s32 stride = cache->atlas.width * bytes;
+    u8* row    = cache->pixels + (shelf->y * stride) + (x * bytes);
+    for(s32 y = 0; y < shelf->height; y++)
+    {
+	memset(row + (y * stride), 0, width * bytes);
+    }
+    bake_writeglyph(trimmed, header->width * bytes, header->height, header->width * bytes,
+		    row + (DYNAMIC_PADDING * stride) + (DYNAMIC_PADDING * bytes), stride);
+    bake_glyphuv(&cache->atlas, header, x + DYNAMIC_PADDING, shelf->y + DYNAMIC_PADDING);
+
+    if(shelf->dirty_min >= shelf->dirty_max)
+    {
+	shelf->dirty_min = x;
+	shelf->dirty_max = x + width;
+    }
+    else
+    {
+	shelf->dirty_min = (x < shelf->dirty_min) ? x : shelf->dirty_min;
+	shelf->dirty_max = ((x + width) > shelf->dirty_max) ? (x + width) : shelf->dirty_max;
+    }
+    return(true);
+}
+struct dynamic_rasterjob
+{
+    dynamic_cache*  cache;
+    dynamic_glyph** pending;
+    u8**            trimmed;
+};
+internal void
+dynamic_rasterglyph(void* data, s32 thread, s32 p)
+{
+    dynamic_rasterjob* job   = (dynamic_rasterjob*)data;
+    dynamic_cache*     cache = job->cache;
+    dynamic_glyph*     glyph = job->pending[p];
+
+    job->trimmed[p] = bake_rasterize(&cache->atlas, cache->font, &cache->scratch[thread], &cache->glyph_memory[thread],
+				     glyph->codepoint, cache->scale, cache->raster_pixels, cache->ascent, &glyph->header);
+
+    // from the top of the surface -> from the ascent (see 'bake_alignglyphs').
+    glyph->header.offset = cache->ascent - glyph->header.offset;
+}
+// rasterizes the 'pending' glyphs (on every thread) and places them, the ones that don't fit leave the cache.
+internal void
+dynamic_flush(dynamic_cache* cache, dynamic_glyph** pending, s32 pending_count)
+{
+    if(pending_count == 0) { return; }
+
+    s32 first_thread = 0;
+    s32 thread_count = work_span(&first_thread);
+    b32 allocated    = true;
+    for(s32 thread = first_thread; thread < (first_thread + thread_count); thread++)
+    {
+	if(!cache->scratch[thread].surface.pixels)
+	{
+	    arena* memory = &cache->scratch_memory[thread];
+	    arena_reserve(memory, bake_scratchbytes(&cache->atlas, cache->font, cache->raster_pixels));
+	    if(!bake_pushscratch(&cache->scratch[thread], &cache->atlas, cache->font, cache->raster_pixels, memory))
+	    {
+		arena_reset(memory);
+		cache->scratch[thread] = {};
+		allocated = false;
+	    }
+	}
+    }
+
+    u8* trimmed[DYNAMIC_BATCH] = {};
+    if(allocated)
+    {
+	dynamic_rasterjob job = {};
+	job.cache   = cache;
+	job.pending = pending;
+	job.trimmed = trimmed;
+	work_run(pending_count, dynamic_rasterglyph, &job);
+    }
+    else
+    {
+	platform_debugprint("'bake_pushscratch' failed!\n");
+    }
+
+    for(s32 p = 0; p < pending_count; p++)
+    {
+	if(!allocated || !dynamic_place(cache, pending[p], trimmed[p]))
+	{
+	    dynamic_remove(cache, pending[p]);
+	}
+    }
+    for(s32 thread = first_thread; thread < (first_thread + thread_count); thread++)
+    {
+	arena_reset(&cache->glyph_memory[thread]);
+    }
+}
+// makes a cache of 'glyph_capacity' glyphs in a 'width' x 'height' texture, for 'points' of 'font' in 'format'
+// (r8, sdf or msdf, with 'spread'). the glyphs are the same as a bake at that size (-h) would make.
+internal b32
+dynamic_create(dynamic_cache* cache, ttf_font* font, r32 points, u32 format, s32 spread, s32 width, s32 height, s32 glyph_capacity)
+{
+    *cache = {};
+
+    s32 pixels = (points/72)*96*(DPI/96.0f);
+    if(format != FONT_FORMAT_R8 && !bake_isdistance(format))
+    {
+	platform_debugprint("'dynamic_create' failed! (r8, sdf or msdf, the texture is updated a glyph at a time)\n");
+	return(false);
+    }
+    if(pixels < 2 || width < DYNAMIC_CLASS || height < DYNAMIC_CLASS || glyph_capacity < 1 ||
+       (bake_isdistance(format) && (spread < 1 || spread > pixels)))
+    {
+	platform_debugprint("'dynamic_create' failed!\n");
+	return(false);
+    }
+
+    cache->font               = font;
+    cache->atlas.width        = width;
+    cache->atlas.height       = height;
+    cache->atlas.glyph_width  = pixels;
+    cache->atlas.glyph_height = pixels;
+    cache->atlas.format       = format;
+    cache->atlas.spread       = bake_isdistance(format) ? spread : 0;
+    cache->atlas.level_count  = 1;
+    cache->atlas.points       = points;
+
+    // rasterized like 'bake_loadsizes' does.
+    cache->raster_pixels      = pixels/2;
+    cache->scale              = bake_fontmetrics(font, points/2.0, &cache->ascent, &cache->atlas.line_spacing);
+    cache->atlas.scale        = cache->scale;
+
+    cache->glyph_capacity = glyph_capacity;
+    cache->table_bits     = 1;
+    while((1u << cache->table_bits) < (u32)(glyph_capacity * 2)) { cache->table_bits++; }
+
+    // free spans have a taken one (at least 'DYNAMIC_ALIGN' wide) between them.
+    cache->shelf_capacity = height / DYNAMIC_CLASS;
+    cache->span_capacity  = (width / (DYNAMIC_ALIGN * 2)) + 2;
+
+    u64 texture_bytes = (u64)width * height * bake_bytesperpixel(format);
+    u64 table_size    = (u64)1 << cache->table_bits;
+    arena_reserve(&cache->memory, texture_bytes + (glyph_capacity * sizeof(dynamic_glyph)) + (table_size * sizeof(s32)) +
+		  (cache->shelf_capacity * (sizeof(dynamic_shelf) + (cache->span_capacity * sizeof(dynamic_span)))) + (4 * ARENA_ALIGNMENT));
+
+    cache->pixels  = (u8*)           arena_pushzero(&cache->memory, texture_bytes);
+    cache->glyphs  = (dynamic_glyph*)arena_push    (&cache->memory, glyph_capacity * sizeof(dynamic_glyph));
+    cache->table   = (s32*)          arena_push    (&cache->memory, table_size * sizeof(s32));
+    cache->shelves = (dynamic_shelf*)arena_pushzero(&cache->memory, cache->shelf_capacity * sizeof(dynamic_shelf));
+    dynamic_span* spans = (dynamic_span*)arena_push(&cache->memory, cache->shelf_capacity * cache->span_capacity * sizeof(dynamic_span));
+    if(!cache->pixels || !cache->glyphs || !cache->table || !cache->shelves || !spans)
+    {
+	platform_debugprint("'arena_push' failed!\n");
+	arena_release(&cache->memory);
+	return(false);
+    }
+
+    for(s32 s = 0; s < cache->shelf_capacity; s++)
+    {
+	cache->shelves[s].spans = spans + (s * cache->span_capacity);
+    }
+    for(u64 t = 0; t < table_size; t++)
+    {
+	cache->table[t] = DYNAMIC_NONE;
+    }
+    for(s32 g = 0; g < glyph_capacity; g++)
+    {
+	cache->glyphs[g].codepoint = DYNAMIC_EMPTY;
+	cache->glyphs[g].next      = (g + 1 < glyph_capacity) ? (g + 1) : DYNAMIC_NONE;
+    }
+    cache->unused = 0;
+    cache->newest = DYNAMIC_NONE;
+    cache->oldest = DYNAMIC_NONE;
+    cache->frame  = 1;
+    return(true);
+}
+internal void
+dynamic_destroy(dynamic_cache* cache)
+{
+    for(s32 thread = 0; thread < WORK_MAX_THREADS; thread++)
+    {
+	arena_release(&cache->scratch_memory[thread]);
+	arena_release(&cache->glyph_memory[thread]);
+    }
+    arena_release(&cache->memory);
+    *cache = {};
+}
+// the glyph of every codepoint (in 'glyphs', one each), rasterized and placed when it isn't in the cache yet.
+// 0 for codepoints the font has no glyph for, and for the ones there's no room for (every glyph in the texture
+// was used this frame). returns how many there are.
+internal s32
+dynamic_ensure(dynamic_cache* cache, u32* codepoints, s32 count, dynamic_glyph** glyphs)
+{
+    dynamic_glyph* pending[DYNAMIC_BATCH];
+    s32            pending_count = 0;
+
+    s32 first = 0; // the codepoints from here on aren't final yet.
+    for(s32 c = 0; c < count; c++)
+    {
+	dynamic_glyph* glyph = dynamic_find(cache, codepoints[c]);
+	if(glyph)
+	{
+	    dynamic_touch(cache, glyph);
+	}
+	else if(codepoints[c] != DYNAMIC_EMPTY && ttf_glyphindex(cache->font, codepoints[c]) != 0)
+	{
+	    if(pending_count == DYNAMIC_BATCH)
+	    {
+		dynamic_flush(cache, pending, pending_count);
+		pending_count = 0;
+		for(; first < c; first++)
+		{
+		    if(glyphs[first] && glyphs[first]->codepoint != codepoints[first]) { glyphs[first] = 0; }
+		}
+	    }
+
+	    glyph = dynamic_insert(cache, codepoints[c]);
+	    if(glyph) { pending[pending_count++] = glyph; }
+	}
+	glyphs[c] = glyph;
+    }
+    dynamic_flush(cache, pending, pending_count);
+
+    // the ones that didn't fit left the cache again.
+    s32 found = 0;
+    for(s32 c = 0; c < count; c++)
+    {
+	if(glyphs[c] && glyphs[c]->codepoint != codepoints[c]) { glyphs[c] = 0; }
+	found += glyphs[c] ? 1 : 0;
+    }
+    return(found);
+}
+// the parts of the texture written since the last call, a rectangle per shelf (at most 'capacity', the rest
+// are left for the next call). returns how many.
+internal s32
+dynamic_dirtyrects(dynamic_cache* cache, dynamic_rect* rects, s32 capacity)
+{
+    s32 count = 0;
+    for(s32 s = 0; s < cache->shelf_count && count < capacity; s++)
+    {
+	dynamic_shelf* shelf = &cache->shelves[s];
+	if(shelf->dirty_min >= shelf->dirty_max) { continue; }
+
+	dynamic_rect* rect = &rects[count++];
+	rect->x      = shelf->dirty_min;
+	rect->y      = shelf->y;
+	rect->width  = shelf->dirty_max - shelf->dirty_min;
+	rect->height = shelf->height;
+
+	shelf->dirty_min = 0;
+	shelf->dirty_max = 0;
+    }
+    return(count);
+}
+// glyphs used before this are the first to go again.
+internal void
+dynamic_nextframe(dynamic_cache* cache)
+{
+    cache->frame++;
+}
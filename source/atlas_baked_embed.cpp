@@ -0,0 +1,287 @@
+// Embed
+//
+// With -e every .font is also written as a c++ header (.h next to it) with the same atlas as constant data,
+// for programs that would rather not read a file at startup: there's nothing to open, check or parse, the
+// arrays are in the program's read-only pages and the glyphs of string literals are found at compile time.
+//
+//   #include "atlas_baked_reader.h" // optional, first: 'Lato_24_font' is an 'atlas_font' then.
+//   #include "Lato_24.h"
+//
+//   constexpr int32_t a = Lato_24_glyphindex(U'A');              // -1 when it wasn't baked.
+//   upload(Lato_24_pixels, Lato_24_width, Lato_24_height);      // alignas(16), bottom-up rows (or bc4 blocks).
+//   const atlas_glyph* glyph = atlas_findglyph(&Lato_24_font, codepoint);
+//
+// Everything is named after the header's file ('Lato_24'). The arrays are the .font's tables as they are:
+//
+//   Lato_24_glyphs[glyph_count], Lato_24_codepoints[glyph_count]     every size's, one size after another
+//   Lato_24_lookups[]                                                 every size's lookup, see 'bake_buildlookup'
+//   Lato_24_sizes[size_count]                                         'lookup_offset' is in bytes from 'Lato_24_lookups'
+//   Lato_24_kerning[glyph_count + 1], Lato_24_kern_pairs[pair_count]  only with kerning
+//   Lato_24_textures[glyph_count]                                     only with more than one texture
+//   Lato_24_pixels[payload_size]                                      every texture's levels, 'Lato_24_level_offsets'
+//
+// The payload is never compressed (-z only applies to the .font), the compiler has to see every byte anyway.
+// The types are the reader's ('ATLAS_BAKED_TYPES'), whichever of the two is included first defines them.
+// The header needs c++14 (constexpr functions with loops and locals).
+//
+
+#define EMBED_BYTES_PER_LINE  32
+#define EMBED_VALUES_PER_LINE 16
+
+// 'value' as a float literal that reads back as the same float.
+internal void
+embed_float(bake_reportbuffer* report, r32 value)
+{
+    s8 text[32];
+    snprintf(text, sizeof(text), "%.9g", value);
+    b32 integer = (strpbrk(text, ".en") == 0); // 'inf' and 'nan' never happen, uvs are inside the atlas.
+    bake_reportprint(report, "%s%sf", text, integer ? ".0" : "");
+}
+// the bytes in decimal, 'EMBED_BYTES_PER_LINE' a line. by hand rather than 'bake_reportprint', atlases are megabytes.
+internal void
+embed_bytes(bake_reportbuffer* report, u8* bytes, u64 count)
+{
+    for(u64 b = 0; b < count; b++)
+    {
+	s8  text[8];
+	s32 length = 0;
+	u8  value  = bytes[b];
+	if(value >= 100) { text[length++] = (s8)('0' + (value / 100));       }
+	if(value >= 10)  { text[length++] = (s8)('0' + ((value / 10) % 10)); }
+	text[length++] = (s8)('0' + (value % 10));
+	text[length++] = ',';
+	text[length++] = ((b % EMBED_BYTES_PER_LINE) == (EMBED_BYTES_PER_LINE - 1) || b == (count - 1)) ? '\n' : ' ';
+
+	if(report->data && (report->size + length) <= report->capacity)
+	{
+	    mem_copy(text, report->data + report->size, length);
+	}
+	report->size += length;
+    }
+}
+// 'count' unsigned values of 'size' bytes (2 or 4), 'EMBED_VALUES_PER_LINE' a line.
+internal void
+embed_values(bake_reportbuffer* report, void* values, s32 count, s32 size)
+{
+    for(s32 v = 0; v < count; v++)
+    {
+	u32 value = (size == 2) ? ((u16*)values)[v] : ((u32*)values)[v];
+	b32 last  = ((v % EMBED_VALUES_PER_LINE) == (EMBED_VALUES_PER_LINE - 1) || v == (count - 1));
+	bake_reportprint(report, "%s%u,%s", ((v % EMBED_VALUES_PER_LINE) == 0) ? "    " : "", value, last ? "\n" : " ");
+    }
+}
+internal void
+embed_header(bake_reportbuffer* report, bake_job* job, bake_atlas* atlas, font_fileheader* file, u8* payload, u16** lookups,
+	     s32* lookup_sizes, s32* page_counts)
+{
+    const s8* formats[5] = { "rgba32", "r8", "sdf", "msdf", "bc4" };
+
+    s8 name[MAX_PATH];
+    header_name(job->header_file, name);
+
+    s8 guard[MAX_PATH];
+    s32 length = 0;
+    for(s8* c = name; *c; c++)
+    {
+	guard[length++] = (*c >= 'a' && *c <= 'z') ? (s8)(*c - 'a' + 'A') : *c;
+    }
+    guard[length] = '\0';
+
+    // the name of the font, on one line.
+    s8 full_name[256] = {};
+    bake_fontname(&job->source->font, TTF_NAME_FULL, full_name, sizeof(full_name));
+    for(s8* c = full_name; *c; c++)
+    {
+	if((u8)*c < 0x20) { *c = ' '; }
+    }
+
+    s32         size_count = atlas->sizes ? atlas->size_count : 1;
+    bake_atlas* sizes      = atlas->sizes ? atlas->sizes : atlas;
+
+    bake_reportprint(report, "// %s, %s", name, full_name);
+    for(s32 s = 0; s < size_count; s++)
+    {
+	bake_reportprint(report, "%s%g", s ? "+" : " ", sizes[s].points);
+    }
+    bake_reportprint(report, "pt %s, baked by atlas_baked -e. bake it again rather than edit it.\n", formats[file->format]);
+    bake_reportprint(report, "// see atlas_baked_embed.cpp.\n\n"
+		     "#ifndef ATLAS_EMBED_%s_H\n#define ATLAS_EMBED_%s_H\n\n#include <stdint.h>\n\n", guard, guard);
+
+    // the reader's types, see 'atlas_baked_reader.h'.
+    bake_reportprint(report,
+		     "#pragma pack(push, 1)\n"
+		     "#ifndef ATLAS_BAKED_TYPES\n"
+		     "#define ATLAS_BAKED_TYPES\n"
+		     "typedef struct atlas_glyph\n{\n"
+		     "    int8_t  character;\n    int32_t offset;\n    int32_t spacing;\n    int32_t pre_spacing;\n"
+		     "    int32_t width;\n    int32_t height;\n    float   u0;\n    float   u1;\n    float   v0;\n    float   v1;\n"
+		     "} atlas_glyph;\n\n"
+		     "typedef struct atlas_size\n{\n"
+		     "    float   points;\n    int32_t glyph_first;\n    int32_t glyph_count;\n    int32_t glyph_height;\n"
+		     "    int32_t glyph_width;\n    int32_t line_spacing;\n    int32_t lookup_offset;\n    int32_t lookup_size;\n"
+		     "    int32_t page_count;\n"
+		     "} atlas_size;\n\n"
+		     "typedef struct atlas_kernpair\n{\n"
+		     "    uint16_t second;\n    int16_t  value;\n"
+		     "} atlas_kernpair;\n"
+		     "#endif\n"
+		     "#pragma pack(pop)\n\n");
+
+    const s8* metrics[13] = { "width", "height", "format", "glyph_count", "glyph_width", "glyph_height", "line_spacing", "spread",
+			      "level_count", "payload_size", "texture_count", "texture_size", "pair_count" };
+    s32 values[13] = { file->width, file->height, file->format, file->glyph_count, file->glyph_width, file->glyph_height,
+		       file->line_spacing, file->spread, file->level_count, file->payload_size, file->texture_count,
+		       file->texture_size, file->pair_count };
+    for(s32 m = 0; m < 13; m++)
+    {
+	bake_reportprint(report, "static constexpr int32_t %s_%s = %d;\n", name, metrics[m], values[m]);
+    }
+    bake_reportprint(report, "static constexpr int32_t %s_size_count = %d;\n\n", name, size_count);
+
+    // from the first level, not the file.
+    bake_reportprint(report, "static constexpr uint32_t %s_level_offsets[%d] =\n{\n", name, file->level_count);
+    for(s32 level = 0; level < file->level_count; level++)
+    {
+	bake_reportprint(report, "    %d,\n", file->level_offsets[level] - file->level_offsets[0]);
+    }
+    bake_reportprint(report, "};\n\n");
+
+    bake_reportprint(report, "static constexpr atlas_glyph %s_glyphs[%d] =\n{\n", name, file->glyph_count);
+    for(s32 g = 0; g < file->glyph_count; g++)
+    {
+	glyph_header* glyph = &atlas->glyphs[g];
+	bake_reportprint(report, "    { %d, %d, %d, %d, %d, %d, ", glyph->character, glyph->offset, glyph->spacing, glyph->pre_spacing,
+			 glyph->width, glyph->height);
+	embed_float(report, glyph->u0);
+	bake_reportprint(report, ", ");
+	embed_float(report, glyph->u1);
+	bake_reportprint(report, ", ");
+	embed_float(report, glyph->v0);
+	bake_reportprint(report, ", ");
+	embed_float(report, glyph->v1);
+	bake_reportprint(report, " },\n");
+    }
+    bake_reportprint(report, "};\n\n");
+
+    bake_reportprint(report, "static constexpr uint32_t %s_codepoints[%d] =\n{\n", name, file->glyph_count);
+    embed_values(report, atlas->codepoints, file->glyph_count, 4);
+    bake_reportprint(report, "};\n\n");
+
+    s32 lookup_total = 0;
+    for(s32 s = 0; s < size_count; s++)
+    {
+	lookup_total += lookup_sizes[s];
+    }
+    bake_reportprint(report, "static constexpr uint16_t %s_lookups[%d] =\n{\n", name, lookup_total / 2);
+    for(s32 s = 0; s < size_count; s++)
+    {
+	embed_values(report, lookups[s], lookup_sizes[s] / 2, 2);
+    }
+    bake_reportprint(report, "};\n\n");
+
+    bake_reportprint(report, "static constexpr atlas_size %s_sizes[%d] =\n{\n", name, size_count);
+    s32 lookup_offset = 0;
+    for(s32 s = 0; s < size_count; s++)
+    {
+	bake_reportprint(report, "    { ");
+	embed_float(report, sizes[s].points);
+	bake_reportprint(report, ", %d, %d, %d, %d, %d, %d, %d, %d },\n", sizes[s].glyph_first, sizes[s].glyph_count,
+			 sizes[s].glyph_height, sizes[s].glyph_width, sizes[s].line_spacing, lookup_offset, lookup_sizes[s],
+			 page_counts[s]);
+	lookup_offset += lookup_sizes[s];
+    }
+    bake_reportprint(report, "};\n\n");
+
+    if(file->pair_count)
+    {
+	bake_reportprint(report, "static constexpr uint32_t %s_kerning[%d] =\n{\n", name, file->glyph_count + 1);
+	embed_values(report, atlas->kerning, file->glyph_count + 1, 4);
+	bake_reportprint(report, "};\n\nstatic constexpr atlas_kernpair %s_kern_pairs[%d] =\n{\n", name, file->pair_count);
+	for(s32 p = 0; p < file->pair_count; p++)
+	{
+	    bake_reportprint(report, "    { %u, %d },\n", (u32)atlas->kern_pairs[p].second, (s32)atlas->kern_pairs[p].value);
+	}
+	bake_reportprint(report, "};\n\n");
+    }
+    if(file->texture_count > 1)
+    {
+	bake_reportprint(report, "static constexpr uint16_t %s_textures[%d] =\n{\n", name, file->glyph_count);
+	embed_values(report, atlas->textures, file->glyph_count, 2);
+	bake_reportprint(report, "};\n\n");
+    }
+
+    bake_reportprint(report, "alignas(16) static const uint8_t %s_pixels[%d] =\n{\n", name, file->payload_size);
+    embed_bytes(report, payload, (u64)file->payload_size);
+    bake_reportprint(report, "};\n\n");
+
+    // the same lookup as 'atlas_findglyph', usable in constant expressions.
+    bake_reportprint(report,
+		     "// the glyph of 'codepoint' in size 'size' (an index into '%s_glyphs'), -1 when it wasn't baked.\n"
+		     "static constexpr int32_t\n"
+		     "%s_glyphindex(uint32_t codepoint, int32_t size = 0)\n"
+		     "{\n"
+		     "    if(size < 0 || size >= %s_size_count) { return(-1); }\n"
+		     "\n"
+		     "    const uint16_t* lookup = %s_lookups + (%s_sizes[size].lookup_offset / 2);\n"
+		     "    uint32_t page_count = (uint32_t)%s_sizes[size].page_count;\n"
+		     "    uint32_t page       = codepoint / 256;\n"
+		     "    if(page >= page_count) { return(-1); }\n"
+		     "\n"
+		     "    uint16_t index = lookup[page_count + (lookup[page] * 256) + (codepoint %% 256)];\n"
+		     "    return((index == 0xffff) ? -1 : index);\n"
+		     "}\n\n",
+		     name, name, name, name, name, name);
+
+    // the whole thing as the reader's font, pointing at the arrays above. 'atlas_selectsize' finds the other
+    // sizes' lookups from 'data'.
+    bake_reportprint(report, "#ifdef ATLAS_BAKED_READER_H\nstatic const atlas_font %s_font =\n{\n", name);
+    bake_reportprint(report, "    %s_glyphs,\n    %s_pixels,\n    %s_codepoints,\n    %s_lookups,\n    %d, // page_count\n",
+		     name, name, name, name, page_counts[0]);
+    bake_reportprint(report, "    %s_glyph_count,\n    %s_width,\n    %s_height,\n    %s_format,\n    %d, // bytes_per_pixel\n"
+		     "    %d, // version\n", name, name, name, name,
+		     (file->format == FONT_FORMAT_BC4) ? 0 : bake_bytesperpixel(file->format), FONT_VERSION);
+    bake_reportprint(report, "    %s_glyph_width,\n    %s_glyph_height,\n    %s_line_spacing,\n    %s_spread,\n    %s_level_count,\n    {",
+		     name, name, name, name, name);
+    for(s32 level = 0; level < file->level_count; level++)
+    {
+	bake_reportprint(report, "%s %s_pixels + %d", level ? "," : "", name, file->level_offsets[level] - file->level_offsets[0]);
+    }
+    bake_reportprint(report, " },\n    {");
+    for(s32 level = 0; level < file->level_count; level++)
+    {
+	bake_reportprint(report, "%s %d", level ? "," : "", file->level_offsets[level] - file->level_offsets[0]);
+    }
+    bake_reportprint(report, " },\n    0, // compression\n    %s_payload_size,\n    0, // chunk_size\n    0, // chunk_count\n    0, // chunks\n", name);
+    if(file->pair_count)
+    {
+	bake_reportprint(report, "    %s_kerning,\n    %s_kern_pairs,\n", name, name);
+    }
+    else
+    {
+	bake_reportprint(report, "    0, // kerning\n    0, // kern_pairs\n");
+    }
+    bake_reportprint(report, "    %s_pair_count,\n    %s%s,\n    %s_size_count,\n    0, // size_index\n    %s%s,\n    %s_texture_count,\n"
+		     "    %s_texture_size,\n    %s_lookups,\n    sizeof(%s_lookups),\n"
+		     "#if defined(_WIN32)\n    0, // file\n    0, // mapping\n#else\n    0, // mapped\n#endif\n};\n#endif\n\n#endif\n",
+		     name, (size_count > 1) ? name : "0", (size_count > 1) ? "_sizes" : "", name,
+		     (file->texture_count > 1) ? name : "0", (file->texture_count > 1) ? "_textures" : "", name, name, name, name);
+}
+// hands the header of a versioned atlas to 'request', counted first so it's built in one piece on its arena.
+internal b32
+bake_writeheader(bake_job* job, bake_atlas* atlas, font_fileheader* file, u8* payload, u16** lookups, s32* lookup_sizes,
+		 s32* page_counts, output_request* request)
+{
+    bake_reportbuffer report = {};
+    embed_header(&report, job, atlas, file, payload, lookups, lookup_sizes, page_counts);
+
+    report.capacity = report.size + 1; // vsnprintf's terminator.
+    report.size     = 0;
+    report.data     = (s8*)arena_push(&request->memory, report.capacity);
+    platform_buffer* buffers = (platform_buffer*)arena_push(&request->memory, sizeof(platform_buffer));
+    if(!report.data || !buffers) { return(false); }
+
+    embed_header(&report, job, atlas, file, payload, lookups, lookup_sizes, page_counts);
+
+    buffers[0] = { report.data, report.size };
+    return(output_addfile(request, job->header_file, buffers, 1, "h"));
+}
@@ -0,0 +1,360 @@
+// Atlas Baked (layout)
+//
+// Header-only text layout over a font opened with atlas_baked_reader.h, C or C++, nothing is allocated.
+//
+// 'atlas_layout' lays out many strings (utf-8) in one call and writes the quads into vertex and index
+// memory the caller provides (a mapped buffer, a frame's scratch). Every visible glyph is one quad, 4
+// vertices (top-left, top-right, bottom-right, bottom-left, clockwise with y down) and 6 indices.
+// Positions are in pixels with y going down, the top of a text's first line is at its 'y', and the uvs
+// are the glyph's own. Kerning is applied when the file has it (version 7). '\n' starts a new line, a
+// 'max_width' wraps lines at spaces.
+//
+// usage:
+//
+//   atlas_text texts[2] =
+//   {
+//       { "Score", 5, 16.0f, 16.0f, 1.0f, 0.0f },
+//       { tooltip, tooltip_length, 16.0f, 64.0f, 0.5f, 300.0f }, // half the baked size, wrapped at 300 pixels.
+//   };
+//   atlas_textquads quads[2];
+//   int32_t count = atlas_layout(&font, texts, 2, vertices, indices, capacity, quads);
+//   draw(vertices, count * 4, indices, count * 6);
+//
+// Glyphs spread over several textures (version 9) need the texture of every quad as well, to batch the
+// draws by texture: 'atlas_layouttextures' is 'atlas_layout' that writes it.
+//
+// 'atlas_measure' and 'atlas_fitline' only add up advances and kerning (no quads, no uvs), for sizing
+// boxes and breaking lines without laying anything out.
+//
+// The quad math is done in SSE2 where the compiler targets it, in plain C otherwise.
+//
+
+#ifndef ATLAS_BAKED_LAYOUT_H
+#define ATLAS_BAKED_LAYOUT_H
+
+#include "atlas_baked_reader.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define ATLAS_LAYOUT_SSE2 1
+#endif
+
+typedef struct atlas_vertex
+{
+    float x;
+    float y;
+    float u;
+    float v;
+} atlas_vertex;
+
+typedef struct atlas_text
+{
+    const char* text;      // utf-8.
+    int32_t     length;    // bytes.
+    float       x;         // left of every line.
+    float       y;         // top of the first line.
+    float       scale;     // 1 = the baked size, 0 is taken as 1.
+    float       max_width; // in pixels, lines wrap at spaces past it. 0 = only at '\n'.
+} atlas_text;
+
+typedef struct atlas_textquads
+{
+    int32_t first;      // quad.
+    int32_t count;
+    int32_t line_count;
+    float   width;      // of the widest line, in pixels.
+    float   height;     // of 'line_count' lines.
+    int32_t length;     // bytes laid out, less than the text's when the quads ran out.
+} atlas_textquads;
+
+// the codepoint at 'text[*at]', '*at' moves past it. malformed sequences are 0xfffd, one byte each.
+static inline uint32_t
+atlas_utf8(const uint8_t* text, int32_t length, int32_t* at)
+{
+    static const uint32_t least[4] = { 0, 0x80, 0x800, 0x10000 }; // anything less is overlong.
+
+    int32_t  i    = *at;
+    uint32_t byte = text[i];
+    *at = i + 1;
+    if(byte < 0x80) { return(byte); }
+
+    int32_t extra = (byte >= 0xf0) ? 3 : (byte >= 0xe0) ? 2 : (byte >= 0xc0) ? 1 : 0;
+    if(extra == 0 || byte >= 0xf8 || extra >= (length - i)) { return(0xfffd); }
+
+    uint32_t codepoint = byte & (0x3f >> extra);
+    for(int32_t e = 1; e <= extra; e++)
+    {
+	uint32_t next = text[i + e];
+	if((next & 0xc0) != 0x80) { return(0xfffd); }
+	codepoint = (codepoint << 6) | (next & 0x3f);
+    }
+    if(codepoint < least[extra] || codepoint > 0x10ffff || (codepoint >= 0xd800 && codepoint <= 0xdfff)) { return(0xfffd); }
+
+    *at = i + extra + 1;
+    return(codepoint);
+}
+// pixels from one pen position to the next at the baked size, kerning aside.
+static inline int32_t
+atlas_advance(const atlas_glyph* glyph)
+{
+    return(glyph->pre_spacing + glyph->width + glyph->spacing);
+}
+// pixels from the top of one line to the top of the next at the baked size.
+static inline int32_t
+atlas_lineheight(const atlas_font* font)
+{
+    return(font->glyph_height + font->line_spacing);
+}
+// how much of 'text' goes on one line: the bytes up to the first '\n', or with a 'max_width' (pixels, at
+// 'scale') up to the last space that keeps the line inside it. a word wider than the whole line is broken
+// between glyphs, a line always takes at least one. '*next' is where the next line starts (past the '\n'
+// or the spaces at the break), '*width' the line's width in pixels. returns the line's bytes.
+static inline int32_t
+atlas_fitline(const atlas_font* font, const char* text, int32_t length, float scale, float max_width,
+	      int32_t* next, float* width)
+{
+    const uint8_t* bytes = (const uint8_t*)text;
+    float limit = (max_width > 0.0f) ? (max_width / scale) : 0.0f; // at the baked size.
+
+    float   pen         = 0.0f;
+    int32_t previous    = -1;
+    int32_t break_at    = -1; // the last space, where the line ends if a later glyph doesn't fit.
+    float   break_width = 0.0f;
+    int32_t placed      = 0;
+
+    int32_t at = 0;
+    while(at < length)
+    {
+	int32_t  start     = at;
+	uint32_t codepoint = atlas_utf8(bytes, length, &at);
+	if(codepoint == '\n')
+	{
+	    *next  = at;
+	    *width = pen * scale;
+	    return(start);
+	}
+
+	const atlas_glyph* glyph = atlas_findglyph(font, codepoint);
+	if(!glyph)
+	{
+	    previous = -1;
+	    continue;
+	}
+	int32_t index   = (int32_t)(glyph - font->glyphs);
+	float   kerning = (previous >= 0) ? atlas_glyphkerning(font, previous, index) : 0.0f;
+	float   end     = pen + kerning + (float)atlas_advance(glyph);
+
+	if(codepoint == ' ')
+	{
+	    // spaces hang past the end instead of wrapping.
+	    if(break_at != start) { break_width = pen; }
+	    break_at = at;
+	}
+	else if(limit > 0.0f && end > limit && placed > 0)
+	{
+	    if(break_at >= 0)
+	    {
+		// back to the first of the spaces, the next line starts after the last one.
+		int32_t line = break_at - 1;
+		while(line > 0 && bytes[line - 1] == ' ') { line--; }
+		*next  = break_at;
+		*width = break_width * scale;
+		return(line);
+	    }
+	    *next  = start;
+	    *width = pen * scale;
+	    return(start);
+	}
+	pen      = end;
+	previous = index;
+	placed++;
+    }
+    *next  = length;
+    *width = pen * scale;
+    return(length);
+}
+// the width of the widest line of 'text' in pixels ('\n' starts a new line, nothing wraps), and the number
+// of lines when 'line_count' isn't 0.
+static inline float
+atlas_measure(const atlas_font* font, const char* text, int32_t length, float scale, int32_t* line_count)
+{
+    float   widest = 0.0f;
+    int32_t lines  = 0;
+    for(int32_t at = 0; at < length; lines++)
+    {
+	int32_t next;
+	float   width;
+	atlas_fitline(font, text + at, length - at, scale, 0.0f, &next, &width);
+	widest = (width > widest) ? width : widest;
+	at    += next;
+    }
+    if(line_count) { *line_count = lines; }
+    return(widest);
+}
+// the 4 vertices of 'glyph' with the pen at 'x' and the top of the line at 'y'.
+static inline void
+atlas_writequad(atlas_vertex* vertices, const atlas_glyph* glyph, float x, float y, float scale)
+{
+#if defined(ATLAS_LAYOUT_SSE2)
+    __m128i box  = _mm_setr_epi32(glyph->pre_spacing, glyph->offset, glyph->pre_spacing + glyph->width, glyph->offset + glyph->height);
+    __m128  edge = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(box), _mm_set1_ps(scale)), _mm_setr_ps(x, y, x, y)); // x0 y0 x1 y1
+    __m128  uv   = _mm_loadu_ps(&glyph->u0);                                                                 // u0 u1 v0 v1
+
+    __m128 corner  = _mm_shuffle_ps(uv,   uv,   _MM_SHUFFLE(3, 1, 2, 0)); // u0 v0 u1 v1
+    __m128 flipped = _mm_shuffle_ps(edge, edge, _MM_SHUFFLE(3, 0, 1, 2)); // x1 y0 x0 y1
+    __m128 crossed = _mm_shuffle_ps(uv,   uv,   _MM_SHUFFLE(3, 0, 2, 1)); // u1 v0 u0 v1
+
+    _mm_storeu_ps(&vertices[0].x, _mm_movelh_ps(edge,    corner));  // x0 y0 u0 v0
+    _mm_storeu_ps(&vertices[1].x, _mm_movelh_ps(flipped, crossed)); // x1 y0 u1 v0
+    _mm_storeu_ps(&vertices[2].x, _mm_movehl_ps(corner,  edge));    // x1 y1 u1 v1
+    _mm_storeu_ps(&vertices[3].x, _mm_movehl_ps(crossed, flipped)); // x0 y1 u0 v1
+#else
+    float x0 = ((float)glyph->pre_spacing * scale) + x;
+    float y0 = ((float)glyph->offset * scale) + y;
+    float x1 = ((float)(glyph->pre_spacing + glyph->width) * scale) + x;
+    float y1 = ((float)(glyph->offset + glyph->height) * scale) + y;
+
+    vertices[0].x = x0; vertices[0].y = y0; vertices[0].u = glyph->u0; vertices[0].v = glyph->v0;
+    vertices[1].x = x1; vertices[1].y = y0; vertices[1].u = glyph->u1; vertices[1].v = glyph->v0;
+    vertices[2].x = x1; vertices[2].y = y1; vertices[2].u = glyph->u1; vertices[2].v = glyph->v1;
+    vertices[3].x = x0; vertices[3].y = y1; vertices[3].u = glyph->u0; vertices[3].v = glyph->v1;
+#endif
+}
+// quads of the glyphs on one line of 'text' (the first 'length' bytes, up to a '\n'), from quad 'first' on and
+// at most 'capacity' of them. '*consumed' is the bytes laid out (past the '\n' if there was one, short when the
+// quads ran out), '*width' the line's width in pixels. returns the number of quads.
+// 'textures' (one per quad, or 0) gets the texture of every quad, see 'atlas_glyphtexture'.
+static inline int32_t
+atlas_layoutline(const atlas_font* font, const char* text, int32_t length, float x, float y, float scale,
+		 atlas_vertex* vertices, uint32_t* indices, uint16_t* textures, int32_t first, int32_t capacity,
+		 int32_t* consumed, float* width)
+{
+    const uint8_t* bytes = (const uint8_t*)text;
+
+    float   pen      = x;
+    int32_t previous = -1;
+    int32_t count    = 0;
+
+    int32_t at = 0;
+    while(at < length)
+    {
+	int32_t  start     = at;
+	uint32_t codepoint = atlas_utf8(bytes, length, &at);
+	if(codepoint == '\n') { break; }
+
+	const atlas_glyph* glyph = atlas_findglyph(font, codepoint);
+	if(!glyph)
+	{
+	    previous = -1;
+	    continue;
+	}
+	int32_t index   = (int32_t)(glyph - font->glyphs);
+	float   kerning = (previous >= 0) ? atlas_glyphkerning(font, previous, index) * scale : 0.0f;
+
+	if(glyph->width > 0 && glyph->height > 0)
+	{
+	    if(count == capacity)
+	    {
+		at = start;
+		break;
+	    }
+
+	    int32_t quad = first + count++;
+	    atlas_writequad(vertices + ((int64_t)quad * 4), glyph, pen + kerning, y, scale);
+	    if(indices)
+	    {
+		uint32_t* index_at = indices + ((int64_t)quad * 6);
+		uint32_t  vertex   = (uint32_t)quad * 4;
+		index_at[0] = vertex;
+		index_at[1] = vertex + 1;
+		index_at[2] = vertex + 2;
+		index_at[3] = vertex;
+		index_at[4] = vertex + 2;
+		index_at[5] = vertex + 3;
+	    }
+	    if(textures) { textures[quad] = (uint16_t)atlas_glyphtexture(font, glyph); }
+	}
+	pen     += kerning + ((float)atlas_advance(glyph) * scale);
+	previous = index;
+    }
+    *consumed = at;
+    *width    = pen - x;
+    return(count);
+}
+// lays out 'text_count' texts one after the other into 'vertices' (4 per quad) and 'indices' (6 per quad,
+// counting from vertex 0, 0 = not written), at most 'capacity' quads. 'quads' (one per text, or 0) says which
+// quads belong to which text and how big it is. wrapped texts ('max_width') are measured a line at a time
+// before the line is laid out. returns the number of quads, once they run out the texts left are empty.
+// 'textures' (one per quad, or 0) gets the texture of every quad.
+static inline int32_t
+atlas_layouttextures(const atlas_font* font, const atlas_text* texts, int32_t text_count,
+		     atlas_vertex* vertices, uint32_t* indices, uint16_t* textures, int32_t capacity, atlas_textquads* quads)
+{
+    int32_t count = 0;
+    for(int32_t t = 0; t < text_count; t++)
+    {
+	const atlas_text* text = &texts[t];
+	float scale       = (text->scale > 0.0f) ? text->scale : 1.0f;
+	float line_height = (float)atlas_lineheight(font) * scale;
+
+	int32_t first  = count;
+	int32_t lines  = 0;
+	float   widest = 0.0f;
+	int     full   = 0;
+
+	int32_t at = 0;
+	while(at < text->length && !full)
+	{
+	    // without wrapping the line ends at the '\n', 'atlas_layoutline' finds it.
+	    int32_t line = text->length - at;
+	    int32_t next = -1;
+	    if(text->max_width > 0.0f)
+	    {
+		float measured;
+		line = atlas_fitline(font, text->text + at, text->length - at, scale, text->max_width, &next, &measured);
+	    }
+
+	    int32_t consumed;
+	    float   width;
+	    int32_t added = atlas_layoutline(font, text->text + at, line, text->x, text->y + ((float)lines * line_height), scale,
+					     vertices, indices, textures, count, capacity - count, &consumed, &width);
+	    count += added;
+	    full   = (count == capacity) && (consumed < line) && (consumed == 0 || text->text[at + consumed - 1] != '\n');
+	    if(added > 0 || !full)
+	    {
+		lines++;
+		widest = (width > widest) ? width : widest;
+	    }
+	    at += (full || next < 0) ? consumed : next;
+	}
+
+	if(quads)
+	{
+	    quads[t].first      = first;
+	    quads[t].count      = count - first;
+	    quads[t].line_count = lines;
+	    quads[t].width      = widest;
+	    quads[t].height     = (float)lines * line_height;
+	    quads[t].length     = at;
+	}
+	if(full)
+	{
+	    for(int32_t rest = t + 1; quads && rest < text_count; rest++)
+	    {
+		atlas_textquads empty = { count, 0, 0, 0.0f, 0.0f, 0 };
+		quads[rest] = empty;
+	    }
+	    break;
+	}
+    }
+    return(count);
+}
+// 'atlas_layouttextures' without the textures, for fonts of one texture.
+static inline int32_t
+atlas_layout(const atlas_font* font, const atlas_text* texts, int32_t text_count,
+	     atlas_vertex* vertices, uint32_t* indices, int32_t capacity, atlas_textquads* quads)
+{
+    return(atlas_layouttextures(font, texts, text_count, vertices, indices, 0, capacity, quads));
+}
+
+#endif
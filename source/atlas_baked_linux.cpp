@@ -0,0 +1,598 @@
+// Atlas Baked (linux)
+//
+// Headless, command line only.
+//
+// build:
+// g++ -O2 -I<path to Handmade> source/atlas_baked_linux.cpp -o "build/atlas_baked" -lm -pthread
+//
+// usage:
+// atlas_baked -ttf"input.ttf" -s"output.font" -h"72"
+// atlas_baked -ttf input.ttf -s output.font -h 72 [-dpi 96] [-j 4] [-p 1] [-b 0] [-f r8|rgba32|sdf|msdf|bc4] [-r 4] [-l 1] [-q 1] [-z 64] [-x 4096] [-y 1] [-e 1] [-c cache] [-o report.json]
+// atlas_baked -ttf input.ttf -s output.font -h 12+16+24 (every size in one atlas)
+// atlas_baked -w /tmp/atlas_baked.socket [-dpi 96] [-j 4] [-p 1] [-b 0] [-f r8|rgba32|sdf|msdf|bc4] [-r 4] [-l 1] [-q 1] [-z 64] [-x 4096] [-y 1] [-e 1] [-c cache] [-o report.json]
+// atlas_baked -w - (requests on the standard input, answers on the standard output)
+// atlas_baked -m manifest.txt [-dpi 96] [-j 4] [-p 1] [-b 0] [-f r8|rgba32|sdf|msdf|bc4] [-r 4] [-l 1] [-q 1] [-z 64] [-x 4096] [-y 1] [-e 1] [-c cache] [-o report.json]
+//
+// exits with 1 when anything failed. '-o -' prints the json report instead of the summary.
+//
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <signal.h>
+#include <errno.h>
+
+#include "handmade.cpp"
+#include "handmade_math.cpp"
+#include "handmade_string.cpp"
+
+#include <cstdio>
+
+#ifndef MAX_PATH
+#define MAX_PATH PATH_MAX
+#endif
+
+#include "atlas_baked.cpp"
+
+// platform.
+internal void*
+platform_allocate(u64 size)
+{
+    // the size is kept in front of the block for 'munmap'.
+    if(size == 0) { return(0); }
+
+    u64* block = (u64*)mmap(0, size + 16, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(block == MAP_FAILED) { return(0); }
+
+    block[0] = size + 16;
+    return(block + 2);
+}
+internal void
+platform_deallocate(void* memory)
+{
+    if(memory)
+    {
+	u64* block = (u64*)memory - 2;
+	munmap(block, block[0]);
+    }
+}
+internal platform_file
+platform_readfile(s8* path)
+{
+    platform_file file = {};
+
+    s32 handle = open(path, O_RDONLY);
+    if(handle != -1)
+    {
+	struct stat status = {};
+	if(fstat(handle, &status) == 0 && status.st_size > 0 && status.st_size < 0xffffffff)
+	{
+	    file.data = platform_allocate(status.st_size);
+	    if(file.data)
+	    {
+		u64 total = 0;
+		while(total < (u64)status.st_size)
+		{
+		    ssize_t bytes_read = read(handle, (u8*)file.data + total, status.st_size - total);
+		    if(bytes_read <= 0) { break; }
+		    total += bytes_read;
+		}
+		if(total == (u64)status.st_size)
+		{
+		    file.size = (u32)total;
+		}
+		else
+		{
+		    platform_deallocate(file.data);
+		    file.data = 0;
+		}
+	    }
+	}
+	close(handle);
+    }
+    return(file);
+}
+internal void
+platform_freefile(platform_file file)
+{
+    platform_deallocate(file.data);
+}
+internal platform_file
+platform_mapfile(s8* path)
+{
+    platform_file file = {};
+
+    s32 handle = open(path, O_RDONLY);
+    if(handle != -1)
+    {
+	struct stat status = {};
+	if(fstat(handle, &status) == 0 && status.st_size > 0 && status.st_size < 0xffffffff)
+	{
+	    void* data = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+	    if(data != MAP_FAILED)
+	    {
+		file.data = data;
+		file.size = (u32)status.st_size;
+	    }
+	}
+	close(handle); // the mapping keeps the file.
+    }
+    return(file);
+}
+internal void
+platform_unmapfile(platform_file file)
+{
+    if(file.data)
+    {
+	munmap(file.data, file.size);
+    }
+}
+internal b32
+platform_writefile(s8* path, u64 size, void* data)
+{
+    s32 handle = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(handle == -1) { return(false); }
+
+    u64 total = 0;
+    while(total < size)
+    {
+	ssize_t bytes_written = write(handle, (u8*)data + total, size - total);
+	if(bytes_written <= 0) { break; }
+	total += bytes_written;
+    }
+    close(handle);
+
+    return(total == size);
+}
+internal b32
+platform_writebuffers(s8* path, platform_buffer* buffers, s32 count, b32 flush)
+{
+    s32 handle = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(handle == -1) { return(false); }
+
+    // up to 64 buffers a call, a short write continues from where it stopped.
+    b32 success = true;
+    s32 next    = 0;
+    u64 skip    = 0; // of 'buffers[next]', already written.
+    while(success && next < count)
+    {
+	struct iovec vectors[64];
+	s32 vector_count = 0;
+	for(s32 b = next; b < count && vector_count < 64; b++)
+	{
+	    u64 offset = (b == next) ? skip : 0;
+	    if(buffers[b].size == offset) { continue; }
+
+	    vectors[vector_count].iov_base = (u8*)buffers[b].data + offset;
+	    vectors[vector_count].iov_len  = buffers[b].size - offset;
+	    vector_count++;
+	}
+	if(vector_count == 0) { break; } // only empty buffers left.
+
+	ssize_t bytes_written = writev(handle, vectors, vector_count);
+	if(bytes_written <= 0) { success = false; break; }
+
+	for(u64 advance = (u64)bytes_written; advance > 0;)
+	{
+	    u64 left = buffers[next].size - skip;
+	    if(advance >= left)
+	    {
+		advance -= left;
+		next++;
+		skip = 0;
+	    }
+	    else
+	    {
+		skip   += advance;
+		advance = 0;
+	    }
+	}
+    }
+    if(success && flush) { success = (fsync(handle) == 0); }
+    if(close(handle) != 0) { success = false; }
+
+    return(success);
+}
+internal b32
+platform_fileexists(s8* path)
+{
+    struct stat status = {};
+    return(stat(path, &status) == 0 && S_ISREG(status.st_mode));
+}
+#ifndef ATLAS_BAKED_NO_MAIN // the server's.
+internal u64
+platform_filetime(s8* path)
+{
+    struct stat status = {};
+    if(stat(path, &status) != 0 || !S_ISREG(status.st_mode)) { return(0); }
+
+    u64 time = ((u64)status.st_mtim.tv_sec * 1000000000ull) + (u64)status.st_mtim.tv_nsec;
+    return(time ? time : 1);
+}
+#endif
+internal b32
+platform_makedirectory(s8* path)
+{
+    struct stat status = {};
+    return(mkdir(path, 0755) == 0 || (stat(path, &status) == 0 && S_ISDIR(status.st_mode)));
+}
+internal void
+platform_debugprint(const s8* message)
+{
+    fputs(message, stderr);
+}
+internal b32
+platform_print(const s8* text, u64 size)
+{
+    return(fwrite(text, 1, size, stdout) == size && fflush(stdout) == 0);
+}
+
+#ifndef ATLAS_BAKED_NO_MAIN // the benchmarks bring their own.
+
+// accepts '-ttf"file"' (the shell strips the quotes, leaving '-ttffile') and '-ttf file'.
+internal b32
+linux_parsearguments(s32 argument_count, s8** arguments)
+{
+    b32      ttf_given = false;
+    b32     font_given = false;
+    b32   height_given = false;
+    b32 manifest_given = false;
+    b32   server_given = false;
+
+    for(s32 a = 1; a < argument_count; a++)
+    {
+	s8* argument = arguments[a];
+
+	const s8* names[] = { "-ttf", "-s", "-h", "-dpi", "-j", "-p", "-b", "-f", "-m", "-u", "-r", "-c", "-l", "-q", "-z", "-y", "-o", "-x", "-w", "-e" };
+	s32 name = -1;
+	for(s32 n = 0; n < (s32)(sizeof(names)/sizeof(names[0])) && name == -1; n++)
+	{
+	    if(strncmp(argument, names[n], strlen(names[n])) == 0) { name = n; }
+	}
+	if(name == -1) { return(false); }
+
+	s8* value = argument + strlen(names[name]);
+	if(*value == '\0')
+	{
+	    if(a + 1 >= argument_count) { return(false); }
+	    value = arguments[++a];
+	}
+
+	switch(name)
+	{
+	case 0:
+	{
+	    if(strlen(value) >= MAX_PATH) { return(false); }
+	    strcpy(open_file, value);
+	    ttf_given = true;
+	}break;
+	case 1:
+	{
+	    if(strlen(value) >= MAX_PATH) { return(false); }
+	    strcpy(save_file, value);
+	    font_given = true;
+	}break;
+	case 2:
+	{
+	    if(strlen(value) >= sizeof(fontheight_field)) { return(false); } // too big.
+	    strcpy(fontheight_field, value);
+	    height_given = true;
+	}break;
+	case 3:
+	{
+	    DPI = (u32)strtoul(value, 0, 10);
+	    if(DPI == 0) { return(false); }
+	}break;
+	case 4:
+	{
+	    bake_threads = (s32)strtol(value, 0, 10); // 0 = one per core.
+	}break;
+	case 5:
+	{
+	    bake_padding = (s32)strtol(value, 0, 10);
+	}break;
+	case 6:
+	{
+	    bake_bleed = (s32)strtol(value, 0, 10);
+	}break;
+	case 7:
+	{
+	    if     (strcmp(value, "r8")     == 0) { bake_format = FONT_FORMAT_R8;     }
+	    else if(strcmp(value, "rgba32") == 0) { bake_format = FONT_FORMAT_RGBA32; }
+	    else if(strcmp(value, "sdf")    == 0) { bake_format = FONT_FORMAT_SDF;    }
+	    else if(strcmp(value, "msdf")   == 0) { bake_format = FONT_FORMAT_MSDF;   }
+	    else if(strcmp(value, "bc4")    == 0) { bake_format = FONT_FORMAT_BC4;    }
+	    else                                  { return(false); }
+	}break;
+	case 8:
+	{
+	    if(strlen(value) >= MAX_PATH) { return(false); }
+	    strcpy(manifest_file, value);
+	    manifest_given = true;
+	}break;
+	case 9:
+	{
+	    if(strlen(value) >= BAKE_MAX_RANGES) { return(false); }
+	    strcpy(bake_ranges, value);
+	}break;
+	case 10:
+	{
+	    bake_spread = (s32)strtol(value, 0, 10);
+	    if(bake_spread < 1) { return(false); }
+	}break;
+	case 11:
+	{
+	    if(strlen(value) >= MAX_PATH) { return(false); }
+	    strcpy(bake_cache, value);
+	}break;
+	case 12:
+	{
+	    bake_levels = (s32)strtol(value, 0, 10);
+	    if(bake_levels < 1 || bake_levels > FONT_MAX_LEVELS) { return(false); }
+	}break;
+	case 13:
+	{
+	    bake_quality = (s32)strtol(value, 0, 10);
+	    if(bake_quality < 0 || bake_quality > 2) { return(false); }
+	}break;
+	case 14:
+	{
+	    bake_chunk = (s32)strtol(value, 0, 10);
+	    if(bake_chunk < 0 || bake_chunk > (1024 * 1024)) { return(false); } // 1 GiB.
+	}break;
+	case 15:
+	{
+	    bake_flush = (strtol(value, 0, 10) != 0);
+	}break;
+	case 16:
+	{
+	    if(strlen(value) >= MAX_PATH) { return(false); }
+	    strcpy(bake_report, value);
+	}break;
+	case 17:
+	{
+	    bake_maxtexture = (s32)strtol(value, 0, 10);
+	    if(bake_maxtexture < 0 || bake_maxtexture > 65536) { return(false); }
+	}break;
+	case 18:
+	{
+	    if(strlen(value) >= MAX_PATH) { return(false); }
+	    strcpy(server_address, value);
+	    server_given = true;
+	}break;
+	case 19:
+	{
+	    bake_embed = (strtol(value, 0, 10) != 0);
+	}break;
+	}
+    }
+    return(manifest_given || server_given || (ttf_given && font_given && height_given));
+}
+
+// Serve
+//
+// -w"-" serves the standard input, anything else is the path of a unix socket (a stale one is replaced).
+// Every connection gets a thread, a 'quit' from any of them closes the others and the socket.
+//
+
+#define LINUX_MAX_CLIENTS 64
+
+struct linux_connection
+{
+    s32 input;
+    s32 output;
+};
+struct linux_client
+{
+    std::thread thread;
+    s32         socket;
+    b32         active;
+};
+struct linux_server
+{
+    std::mutex   mutex; // 'clients'.
+    linux_client clients[LINUX_MAX_CLIENTS];
+    s32          listener;
+    b32          quit;
+};
+
+global linux_server linux_listen;
+
+internal s32
+linux_read(void* connection, s8* buffer, s32 size)
+{
+    ssize_t bytes_read = -1;
+    do
+    {
+	bytes_read = read(((linux_connection*)connection)->input, buffer, size);
+    } while(bytes_read == -1 && errno == EINTR);
+    return((s32)bytes_read);
+}
+internal b32
+linux_write(void* connection, const s8* data, s32 size)
+{
+    while(size > 0)
+    {
+	ssize_t bytes_written = write(((linux_connection*)connection)->output, data, size);
+	if(bytes_written == -1 && errno == EINTR) { continue; }
+	if(bytes_written <= 0) { return(false); }
+	data += bytes_written;
+	size -= (s32)bytes_written;
+    }
+    return(true);
+}
+internal void
+linux_serveclient(s32 c)
+{
+    linux_client*    client     = &linux_listen.clients[c];
+    linux_connection connection = { client->socket, client->socket };
+    if(!server_connection(&connection, linux_read, linux_write))
+    {
+	// quit, 'accept' returns.
+	std::unique_lock<std::mutex> lock(linux_listen.mutex);
+	linux_listen.quit = true;
+	shutdown(linux_listen.listener, SHUT_RDWR);
+    }
+
+    std::unique_lock<std::mutex> lock(linux_listen.mutex);
+    close(client->socket);
+    client->socket = -1;
+    client->active = false;
+}
+internal b32
+linux_serve(s8* address)
+{
+    signal(SIGPIPE, SIG_IGN); // a client that went away is a failed write, not the end of the server.
+    if(!server_startup(address)) { return(false); }
+
+    b32 success = true;
+    if(strcmp(address, "-") == 0)
+    {
+	linux_connection connection = { STDIN_FILENO, STDOUT_FILENO };
+	server_connection(&connection, linux_read, linux_write);
+    }
+    else
+    {
+	struct sockaddr_un name = {};
+	name.sun_family = AF_UNIX;
+
+	linux_listen.listener = -1;
+	linux_listen.quit     = false;
+	if(strlen(address) < sizeof(name.sun_path))
+	{
+	    strcpy(name.sun_path, address);
+	    unlink(address);
+	    linux_listen.listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	}
+	if(linux_listen.listener == -1 || bind(linux_listen.listener, (struct sockaddr*)&name, sizeof(name)) != 0 ||
+	   listen(linux_listen.listener, 16) != 0)
+	{
+	    platform_debugprint("'linux_serve' failed! (can't listen on the socket)\n");
+	    success = false;
+	}
+
+	while(success)
+	{
+	    s32 accepted = accept(linux_listen.listener, 0, 0);
+	    if(accepted == -1 && errno == EINTR) { continue; }
+
+	    std::unique_lock<std::mutex> lock(linux_listen.mutex);
+	    if(accepted == -1 || linux_listen.quit)
+	    {
+		if(accepted != -1) { close(accepted); }
+		break;
+	    }
+
+	    // a slot whose thread is done.
+	    s32 c = 0;
+	    while(c < LINUX_MAX_CLIENTS && linux_listen.clients[c].active) { c++; }
+	    if(c == LINUX_MAX_CLIENTS)
+	    {
+		platform_debugprint("'linux_serve' failed! (too many clients)\n");
+		close(accepted);
+		continue;
+	    }
+	    linux_client* client = &linux_listen.clients[c];
+	    if(client->thread.joinable()) { client->thread.join(); }
+	    client->socket = accepted;
+	    client->active = true;
+	    client->thread = std::thread(linux_serveclient, c);
+	}
+
+	// the other clients stop reading, a bake that's running is finished and answered first.
+	{
+	    std::unique_lock<std::mutex> lock(linux_listen.mutex);
+	    for(s32 c = 0; c < LINUX_MAX_CLIENTS; c++)
+	    {
+		if(linux_listen.clients[c].active) { shutdown(linux_listen.clients[c].socket, SHUT_RD); }
+	    }
+	}
+	for(s32 c = 0; c < LINUX_MAX_CLIENTS; c++)
+	{
+	    if(linux_listen.clients[c].thread.joinable()) { linux_listen.clients[c].thread.join(); }
+	}
+	if(linux_listen.listener != -1)
+	{
+	    close(linux_listen.listener);
+	    unlink(address);
+	}
+    }
+
+    server_shutdown();
+    return(success);
+}
+
+s32
+main(s32 argument_count, s8** arguments)
+{
+    // Atlas Baked
+
+    if(!linux_parsearguments(argument_count, arguments))
+    {
+	fputs("error: did you provide all three arguments?\n   -ttf (truetype font file)\n   -s (save location)\n   -h (font height, 12+24+48 = one atlas of every size)\n   -j (threads, optional)\n   -p (padding, optional)\n   -b (bleed, optional)\n   -f (r8, rgba32, sdf, msdf or bc4, optional)\n   -m (manifest, instead of -ttf -s -h)\n   -u (unicode ranges, optional)\n   -r (sdf/msdf spread in pixels, optional)\n   -c (cache directory, optional)\n   -l (mip levels, optional)\n   -q (bc4 quality 0 -> 2, optional)\n   -z (compressed chunks in KiB, optional)\n   -x (max texture size in pixels, optional)\n   -y (1 = flush the outputs to the disk, optional)\n   -e (1 = also write the atlas as a c++ header, .h, optional)\n   -o (json report, - = standard output, optional)\n   -w (serve bake requests on a unix socket, - = standard input, instead of -ttf -s -h)\n", stderr);
+	return(1);
+    }
+
+    simd_startup(SIMD_BEST);
+    work_startup(bake_threads);
+
+    b32 success = false;
+    s32 baked   = 0;
+    s32 jobs    = 0;
+    if(server_address[0])
+    {
+	success = linux_serve(server_address);
+    }
+    else if(manifest_file[0])
+    {
+	success = bake_manifest(manifest_file, &baked, &jobs);
+    }
+    else
+    {
+	bitmap_path(save_file, bitmap_file);
+	success = bake_font();
+    }
+    work_shutdown();
+    bake_releasememory();
+
+    if(server_address[0])
+    {
+	return(success ? 0 : 1); // every request was answered on its own.
+    }
+
+    if(!success)
+    {
+	fputs("failed!\n", stderr);
+    }
+    if(strcmp(bake_report, "-") == 0)
+    {
+	return(success ? 0 : 1); // the standard output is the report.
+    }
+
+    if(manifest_file[0])
+    {
+	printf("baked %d of %d\n", baked, jobs);
+    }
+    if(!success)
+    {
+	return(1);
+    }
+
+    fputs("success!\n", stdout);
+    if(bake_cache[0])
+    {
+	printf("cached: %d of %d\n", bake_lastcached, manifest_file[0] ? jobs : 1);
+    }
+    printf("peak memory: %llu KiB (%llu KiB reserved, %u os allocations)\n",
+	   (unsigned long long)(bake_lastmemory.peak / 1024),
+	   (unsigned long long)(bake_lastmemory.reserved / 1024),
+	   bake_lastmemory.allocations);
+    return(0);
+}
+
+#endif
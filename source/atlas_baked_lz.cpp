@@ -0,0 +1,132 @@
+// LZ
+//
+// Lossless compression of the .font payload, in the LZ4 block format (so any LZ4 decoder reads it,
+// 'atlas_lz4' in the reader is a small one). Atlases are mostly zero coverage and empty padding, long
+// runs that a byte oriented LZ with no entropy coding turns into a few bytes and decodes at memory speed.
+//
+// A block is a list of sequences:
+//
+//   u8  token              literal count (high 4 bits), match length - 4 (low 4 bits), 15 = more follows
+//   u8  count[]            255 + 255 + ... + the rest, only after a 15
+//   u8  literals[count]
+//   u16 offset             back from the current output, 1 -> 65535
+//   u8  length[]           like 'count'
+//
+// The last sequence is literals only. A match never starts in the last 'LZ_MATCH_LIMIT' bytes and the
+// last 'LZ_LAST_LITERALS' are always literals (the format's rules, decoders rely on them).
+//
+// Matches are found with a single hash table of the last position of every 4 bytes (greedy, no chains),
+// misses skip ahead faster and faster so incompressible data goes through quickly.
+//
+
+#define LZ_HASH_BITS     13
+#define LZ_MIN_MATCH     4
+#define LZ_MATCH_LIMIT   12
+#define LZ_LAST_LITERALS 5
+#define LZ_MAX_OFFSET    0xffff
+
+// worst case (nothing matches) of 'size' bytes.
+internal u64
+lz_bound(u64 size)
+{
+    return(size + (size / 255) + 16);
+}
+internal u32
+lz_read32(u8* bytes)
+{
+    u32 value;
+    memcpy(&value, bytes, sizeof(value));
+    return(value);
+}
+internal u32
+lz_hash(u32 value)
+{
+    return((value * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+// the part of a literal count or match length past 15.
+internal u8*
+lz_writelength(u8* target, u64 length)
+{
+    for(; length >= 255; length -= 255)
+    {
+	*target++ = 255;
+    }
+    *target++ = (u8)length;
+    return(target);
+}
+internal u8*
+lz_writesequence(u8* target, u8* literals, u64 literal_count, u64 offset, u64 match_length)
+{
+    u8* token = target++;
+    *token = (u8)(((literal_count >= 15) ? 15 : literal_count) << 4);
+    if(literal_count >= 15) { target = lz_writelength(target, literal_count - 15); }
+
+    mem_copy(literals, target, literal_count);
+    target += literal_count;
+
+    if(match_length)
+    {
+	u64 length = match_length - LZ_MIN_MATCH;
+	*target++ = (u8)(offset & 0xff);
+	*target++ = (u8)(offset >> 8);
+	*token   |= (u8)((length >= 15) ? 15 : length);
+	if(length >= 15) { target = lz_writelength(target, length - 15); }
+    }
+    return(target);
+}
+// 'target' needs 'lz_bound(size)' bytes, returns the compressed size.
+internal u64
+lz_compress(u8* source, u64 size, u8* target)
+{
+    u8* output = target;
+    u64 anchor = 0; // first byte not written yet.
+
+    if(size > LZ_MATCH_LIMIT)
+    {
+	u32 table[1 << LZ_HASH_BITS] = {}; // position of the last 4 bytes with that hash.
+
+	u64 limit    = size - LZ_MATCH_LIMIT;
+	u64 end      = size - LZ_LAST_LITERALS;
+	u64 position = 0;
+	u32 misses   = 0;
+	while(position < limit)
+	{
+	    u32 value     = lz_read32(source + position);
+	    u32 hash      = lz_hash(value);
+	    u64 candidate = table[hash];
+	    table[hash]   = (u32)position;
+
+	    if(candidate < position && (position - candidate) <= LZ_MAX_OFFSET && lz_read32(source + candidate) == value)
+	    {
+		// grow the match back into the literals, then forward.
+		while(position > anchor && candidate > 0 && source[position - 1] == source[candidate - 1])
+		{
+		    position--;
+		    candidate--;
+		}
+		u64 length = LZ_MIN_MATCH;
+		while((position + length) < end && source[candidate + length] == source[position + length])
+		{
+		    length++;
+		}
+
+		output = lz_writesequence(output, source + anchor, position - anchor, position - candidate, length);
+
+		position += length;
+		anchor    = position;
+		misses    = 0;
+		if(position < limit)
+		{
+		    table[lz_hash(lz_read32(source + position - 2))] = (u32)(position - 2);
+		}
+	    }
+	    else
+	    {
+		position += 1 + (misses++ >> 6);
+	    }
+	}
+    }
+
+    output = lz_writesequence(output, source + anchor, size - anchor, 0, 0);
+    return((u64)(output - target));
+}
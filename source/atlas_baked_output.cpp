@@ -0,0 +1,235 @@
+// Output
+//
+// Writes the .font, .bmp (and .h) of a bake on a thread of its own, so the next job rasterizes while the files
+// of the last one go to disk.
+//
+// A bake takes a request ('output_begin') and builds everything its files are made of in the request's
+// arena (the atlas itself, the headers), then describes every file as a list of buffers pointing into it
+// and hands it over ('output_submit'). Files are written gathered ('platform_writebuffers'), nothing is
+// copied into a staging block first. The request's arena is reset once its files are written, until then
+// the bake's own arenas are free for the next job.
+//
+// There is one request per worker and one more, so a worker only waits for the disk when the job
+// before its last one still hasn't been written. 'output_wait' waits for everything submitted.
+//
+// With a cache directory every file is also written to its cache entry from the same buffers.
+//
+
+#define OUTPUT_MAX_REQUESTS (WORK_MAX_THREADS + 1)
+#define OUTPUT_MAX_FILES    3
+
+struct output_file
+{
+    s8               path[MAX_PATH];
+    platform_buffer* buffers;
+    s32              buffer_count;
+    const s8*        cache_extension; // entry '<key>.<extension>' in 'cache', 0 = not cached.
+};
+struct output_request
+{
+    arena memory; // everything the files point at.
+
+    output_file files[OUTPUT_MAX_FILES];
+    s32         file_count;
+
+    s8  cache[MAX_PATH]; // directory, empty = no cache.
+    u64 cache_key;
+    b32 flush;           // to the disk before the request counts as written.
+
+    b32* written; // set once the files are written (false if any of them failed), 0 = nobody asks.
+    r64* seconds; // set to the time writing took, 0 = nobody asks.
+    b32  busy;    // taken by a bake or waiting to be written.
+};
+struct output_queue
+{
+    std::thread thread;
+    b32         running;
+
+    std::mutex              mutex;
+    std::condition_variable wake;  // the writer, a request was submitted (or it's time to quit).
+    std::condition_variable freed; // bakes, a request was written.
+
+    output_request requests[OUTPUT_MAX_REQUESTS];
+    s32 queue[OUTPUT_MAX_REQUESTS]; // submitted, in order.
+    s32 first;
+    s32 count;
+    s32 writing; // taken off the queue, not written yet.
+    b32 quit;
+};
+
+global output_queue output;
+
+internal b32
+output_writerequest(output_request* request)
+{
+    b32 success = true;
+    for(s32 f = 0; f < request->file_count; f++)
+    {
+	output_file* file = &request->files[f];
+	if(!platform_writebuffers(file->path, file->buffers, file->buffer_count, request->flush))
+	{
+	    platform_debugprint("'platform_writebuffers' failed!\n");
+	    success = false;
+	}
+    }
+
+    // cache entries only ever hold outputs that were written.
+    if(success && request->cache[0])
+    {
+	platform_makedirectory(request->cache);
+	for(s32 f = 0; f < request->file_count; f++)
+	{
+	    output_file* file = &request->files[f];
+	    s8 path[MAX_PATH];
+	    if(file->cache_extension && cache_path(request->cache, request->cache_key, file->cache_extension, path))
+	    {
+		platform_writebuffers(path, file->buffers, file->buffer_count, request->flush);
+	    }
+	}
+    }
+    return(success);
+}
+internal void
+output_writer()
+{
+    for(;;)
+    {
+	output_request* request = 0;
+	{
+	    std::unique_lock<std::mutex> lock(output.mutex);
+	    output.wake.wait(lock, []{ return(output.quit || output.count > 0); });
+	    if(output.count == 0) { return; } // quit, and everything is written.
+
+	    request = &output.requests[output.queue[output.first]];
+	    output.first = (output.first + 1) % OUTPUT_MAX_REQUESTS;
+	    output.count--;
+	    output.writing++;
+	}
+
+	r64 start   = std::chrono::duration<r64>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	b32 success = output_writerequest(request);
+	if(request->written) { *request->written = success; }
+	if(request->seconds) { *request->seconds = std::chrono::duration<r64>(std::chrono::steady_clock::now().time_since_epoch()).count() - start; }
+
+	arena_reset(&request->memory);
+	request->memory.peak        = 0;
+	request->memory.allocations = 0;
+	{
+	    std::unique_lock<std::mutex> lock(output.mutex);
+	    request->busy = false;
+	    output.writing--;
+	}
+	output.freed.notify_all();
+    }
+}
+internal void
+output_startup()
+{
+    output.first   = 0;
+    output.count   = 0;
+    output.writing = 0;
+    output.quit    = false;
+    output.thread  = std::thread(output_writer);
+    output.running = true;
+}
+// writes whatever is left, then stops the writer.
+internal void
+output_shutdown()
+{
+    if(!output.running) { return; }
+    {
+	std::unique_lock<std::mutex> lock(output.mutex);
+	output.quit = true;
+    }
+    output.wake.notify_one();
+    output.thread.join();
+    output.running = false;
+}
+internal void
+output_releasememory()
+{
+    for(s32 r = 0; r < OUTPUT_MAX_REQUESTS; r++)
+    {
+	arena_release(&output.requests[r].memory);
+    }
+}
+// a free request, waits for one to be written when there is none.
+internal output_request*
+output_begin()
+{
+    std::unique_lock<std::mutex> lock(output.mutex);
+    for(;;)
+    {
+	for(s32 r = 0; r < OUTPUT_MAX_REQUESTS; r++)
+	{
+	    output_request* request = &output.requests[r];
+	    if(!request->busy)
+	    {
+		request->busy       = true;
+		request->file_count = 0;
+		request->cache[0]   = 0;
+		request->cache_key  = 0;
+		request->flush      = false;
+		request->written    = 0;
+		request->seconds    = 0;
+		return(request);
+	    }
+	}
+	output.freed.wait(lock);
+    }
+}
+// 'buffers' (and what they point at) have to stay until the request is written, push them on its arena.
+internal b32
+output_addfile(output_request* request, s8* path, platform_buffer* buffers, s32 buffer_count, const s8* cache_extension)
+{
+    if(request->file_count >= OUTPUT_MAX_FILES || strlen(path) >= MAX_PATH) { return(false); }
+
+    output_file* file = &request->files[request->file_count++];
+    strcpy(file->path, path);
+    file->buffers         = buffers;
+    file->buffer_count    = buffer_count;
+    file->cache_extension = cache_extension;
+    return(true);
+}
+// bytes of the request's file 'f', 0 when there's no such file.
+internal u64
+output_filebytes(output_request* request, s32 f)
+{
+    u64 size = 0;
+    for(s32 b = 0; f < request->file_count && b < request->files[f].buffer_count; b++)
+    {
+	size += request->files[f].buffers[b].size;
+    }
+    return(size);
+}
+// hands the request to the writer, it's not touched again by the caller.
+internal void
+output_submit(output_request* request)
+{
+    {
+	std::unique_lock<std::mutex> lock(output.mutex);
+	output.queue[(output.first + output.count) % OUTPUT_MAX_REQUESTS] = (s32)(request - output.requests);
+	output.count++;
+    }
+    output.wake.notify_one();
+}
+// a request that ends up with nothing to write.
+internal void
+output_cancel(output_request* request)
+{
+    arena_reset(&request->memory);
+    request->memory.peak        = 0;
+    request->memory.allocations = 0;
+    {
+	std::unique_lock<std::mutex> lock(output.mutex);
+	request->busy = false;
+    }
+    output.freed.notify_all();
+}
+// until everything submitted so far is written.
+internal void
+output_wait()
+{
+    std::unique_lock<std::mutex> lock(output.mutex);
+    output.freed.wait(lock, []{ return(output.count == 0 && output.writing == 0); });
+}
@@ -0,0 +1,238 @@
+// Pack
+//
+// Skyline rectangle packer (bottom-left heuristic).
+//
+// The skyline is the upper outline of everything placed so far, stored as a list of horizontal
+// segments (x, y, width) from left to right. A rectangle is placed at the lowest y it can rest at
+// without overlapping, ties go to the narrowest segment. Rectangles are packed tallest first,
+// which keeps the skyline flat and the waste small for glyphs (which are similar in height).
+//
+// Coordinates follow the atlas memory, y = 0 is the first (bottom) row.
+//
+// 'pack_pages' fills pages of a fixed size one after another, what doesn't fit on a page goes to the next.
+//
+
+#include <stdlib.h>
+
+struct pack_node
+{
+    s32 x;
+    s32 y;
+    s32 width;
+};
+struct pack_skyline
+{
+    s32 width;
+    s32 height; // maximum.
+
+    pack_node* nodes;
+    s32        node_count;
+    s32        node_capacity; // width + 1 is always enough.
+
+    s32 used_height;
+};
+struct pack_rect
+{
+    s32 width;  // including padding.
+    s32 height;
+
+    s32 x;
+    s32 y;
+    s32 page; // 'pack_pages' only.
+    b32 packed;
+};
+
+internal void
+pack_begin(pack_skyline* skyline, s32 width, s32 height, pack_node* nodes, s32 node_capacity)
+{
+    skyline->width         = width;
+    skyline->height        = height;
+    skyline->nodes         = nodes;
+    skyline->node_capacity = node_capacity;
+    skyline->node_count    = 1;
+    skyline->used_height   = 0;
+
+    nodes[0].x     = 0;
+    nodes[0].y     = 0;
+    nodes[0].width = width;
+}
+// the y a 'width' wide rectangle rests at when its left edge is at node 'index', -1 if it doesn't fit.
+internal s32
+pack_fit(pack_skyline* skyline, s32 index, s32 width, s32 height)
+{
+    s32 x = skyline->nodes[index].x;
+    if((x + width) > skyline->width) { return(-1); }
+
+    s32 y         = 0;
+    s32 remaining = width;
+    while(remaining > 0)
+    {
+	pack_node* node = &skyline->nodes[index];
+	if(node->y > y) { y = node->y; }
+	if((y + height) > skyline->height) { return(-1); }
+
+	remaining -= node->width;
+	index++;
+    }
+    return(y);
+}
+internal b32
+pack_insert(pack_skyline* skyline, s32 width, s32 height, s32* x, s32* y)
+{
+    s32 best_index = -1;
+    s32 best_y     = skyline->height;
+    s32 best_width = skyline->width;
+
+    for(s32 index = 0; index < skyline->node_count; index++)
+    {
+	s32 fit = pack_fit(skyline, index, width, height);
+	if(fit >= 0)
+	{
+	    // lowest first, then the narrowest segment (keeps wide gaps for wide glyphs).
+	    if(fit < best_y || (fit == best_y && skyline->nodes[index].width < best_width))
+	    {
+		best_index = index;
+		best_y     = fit;
+		best_width = skyline->nodes[index].width;
+	    }
+	}
+    }
+    if(best_index < 0)                                  { return(false); }
+    if((skyline->node_count + 1) > skyline->node_capacity) { return(false); }
+
+    // insert the new segment, then shrink or remove the ones it now covers.
+    pack_node* nodes = skyline->nodes;
+    for(s32 index = skyline->node_count; index > best_index; index--)
+    {
+	nodes[index] = nodes[index - 1];
+    }
+    nodes[best_index].y     = best_y + height;
+    nodes[best_index].width = width;
+    skyline->node_count++;
+
+    s32 left  = nodes[best_index].x;
+    s32 right = left + width;
+    s32 index = best_index + 1;
+    while(index < skyline->node_count && nodes[index].x < right)
+    {
+	s32 shrink = right - nodes[index].x;
+	if(nodes[index].width > shrink)
+	{
+	    nodes[index].x     += shrink;
+	    nodes[index].width -= shrink;
+	    break;
+	}
+	for(s32 move = index; move < (skyline->node_count - 1); move++)
+	{
+	    nodes[move] = nodes[move + 1];
+	}
+	skyline->node_count--;
+    }
+
+    // merge neighbours at the same height.
+    for(s32 merge = 0; merge < (skyline->node_count - 1);)
+    {
+	if(nodes[merge].y == nodes[merge + 1].y)
+	{
+	    nodes[merge].width += nodes[merge + 1].width;
+	    for(s32 move = merge + 1; move < (skyline->node_count - 1); move++)
+	    {
+		nodes[move] = nodes[move + 1];
+	    }
+	    skyline->node_count--;
+	}
+	else
+	{
+	    merge++;
+	}
+    }
+
+    if((best_y + height) > skyline->used_height) { skyline->used_height = best_y + height; }
+
+    *x = left; // 'best_index' may have been merged away.
+    *y = best_y;
+    return(true);
+}
+
+internal s32
+pack_compare(const void* a, const void* b)
+{
+    u64 first  = *(u64*)a;
+    u64 second = *(u64*)b;
+    return((first < second) ? -1 : ((first > second) ? 1 : 0));
+}
+// tallest first: height (descending), width (descending), then index so the layout never depends on the sort.
+internal void
+pack_order(pack_rect* rects, s32 count, u64* order)
+{
+    for(s32 r = 0; r < count; r++)
+    {
+	u64 h = (rects[r].height > 0xffff) ? 0xffff : (rects[r].height < 0 ? 0 : rects[r].height);
+	u64 w = (rects[r].width  > 0xffff) ? 0xffff : (rects[r].width  < 0 ? 0 : rects[r].width);
+	order[r]        = ((0xffff - h) << 48) | ((0xffff - w) << 32) | (u32)r;
+	rects[r].packed = false;
+	rects[r].page   = 0;
+    }
+    qsort(order, count, sizeof(u64), pack_compare);
+}
+// packs tallest first, 'order' is scratch (count entries), 'nodes' needs width + 1 entries.
+// rectangles that do not fit keep 'packed' false, returns the used height.
+internal s32
+pack_rects(pack_rect* rects, s32 count, s32 width, s32 height, u64* order, pack_node* nodes)
+{
+    pack_order(rects, count, order);
+
+    pack_skyline skyline = {};
+    pack_begin(&skyline, width, height, nodes, width + 1);
+
+    for(s32 o = 0; o < count; o++)
+    {
+	pack_rect* rect = &rects[(u32)order[o]];
+	if(rect->width <= 0 || rect->height <= 0) { continue; }
+
+	rect->packed = pack_insert(&skyline, rect->width, rect->height, &rect->x, &rect->y);
+    }
+    return(skyline.used_height);
+}
+// packs into as many 'width' x 'height' pages as it takes, tallest first on every page, and every rectangle
+// gets its 'page'. returns the number of pages (at least one), 0 if a rectangle is bigger than a page.
+// '*used_height' is the tallest of the pages.
+internal s32
+pack_pages(pack_rect* rects, s32 count, s32 width, s32 height, u64* order, pack_node* nodes, s32* used_height)
+{
+    pack_order(rects, count, order);
+
+    s32 left = 0;
+    for(s32 r = 0; r < count; r++)
+    {
+	if(rects[r].width > 0 && rects[r].height > 0) { left++; }
+    }
+
+    s32 page_count = 0;
+    *used_height   = 0;
+    while(left > 0)
+    {
+	pack_skyline skyline = {};
+	pack_begin(&skyline, width, height, nodes, width + 1);
+
+	s32 placed = 0;
+	for(s32 o = 0; o < count; o++)
+	{
+	    pack_rect* rect = &rects[(u32)order[o]];
+	    if(rect->packed || rect->width <= 0 || rect->height <= 0) { continue; }
+
+	    if(pack_insert(&skyline, rect->width, rect->height, &rect->x, &rect->y))
+	    {
+		rect->packed = true;
+		rect->page   = page_count;
+		placed++;
+	    }
+	}
+	if(placed == 0) { return(0); } // what's left doesn't fit on an empty page.
+
+	if(skyline.used_height > *used_height) { *used_height = skyline.used_height; }
+	left -= placed;
+	page_count++;
+    }
+    return((page_count > 0) ? page_count : 1);
+}
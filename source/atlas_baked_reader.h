@@ -0,0 +1,913 @@
+// Atlas Baked (reader)
+//
+// Header-only reader for .font files, C or C++, no dependencies besides the os.
+//
+// The file is memory-mapped and never copied. 'atlas_open' checks the header and every offset
+// against the file size once, after that every lookup is a few loads: glyphs are found by codepoint
+// in O(1) (two table loads) and 'pixels' points straight at the atlas inside the mapping.
+//
+// usage:
+//
+//   atlas_font font;
+//   if(atlas_open(&font, "DMMono_72.font"))
+//   {
+//       const atlas_glyph* glyph = atlas_findglyph(&font, 'A');
+//       upload(font.pixels, font.width, font.height, font.format); // one byte (r8, sdf) or four (rgba32, msdf) per pixel, or bc4 blocks.
+//       atlas_close(&font);
+//   }
+//
+// 'atlas_load' does the same checks on memory the caller already has (an archive, an embedded array).
+// Both the versioned layout (magic 'ATLS') and the original unversioned one (rgba32) are read.
+//
+// Compressed files ('compression' != 0) have no 'pixels', the payload (every level) is decoded into
+// memory the caller provides, whole or a chunk at a time:
+//
+//   uint8_t* staging = map_upload_buffer(font.payload_size);
+//   atlas_decompress(&font, staging); // level n at 'staging + font.level_offsets[n]'.
+//
+// Version 7 files carry the font's kerning between the baked glyphs. 'atlas_kernstring' gives the
+// adjustment after every codepoint of a string in one pass, 'atlas_kerning' one pair:
+//
+//   float kerning[64];
+//   atlas_kernstring(&font, codepoints, count, kerning); // pen_x += advance(i) + kerning[i].
+//
+// Version 8 files can hold several sizes in one atlas (one texture for all of them). A font starts out
+// as the first size, a copy of it is another (everything else is shared, the copy is a few pointers):
+//
+//   atlas_font small = font;
+//   atlas_selectsize(&small, atlas_findsize(&font, 12.0f)); // lookups, metrics and layout are now 12pt's.
+//
+// Version 9 files can spread the glyphs over several textures of the same size (baked with a maximum
+// texture size). Every texture is a whole payload of its own, so they can be streamed in one at a time:
+//
+//   for(int32_t t = 0; t < font.texture_count; t++)
+//   {
+//       atlas_decompresstexture(&font, t, staging); // 'texture_size' bytes, level n at 'staging + font.level_offsets[n]'.
+//       upload_layer(t, staging);
+//   }
+//   int32_t layer = atlas_glyphtexture(&font, glyph);
+//
+// Atlases baked with -e are also a c++ header of constant arrays. Included after this one it has an 'atlas_font'
+// too, one that was never opened (nothing to close):
+//
+//   #include "Lato_24.h"
+//   const atlas_glyph* glyph = atlas_findglyph(&Lato_24_font, 'A');
+//
+//
+// The layouts below must match the ones written by atlas_baked.cpp.
+//
+
+#ifndef ATLAS_BAKED_READER_H
+#define ATLAS_BAKED_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define ATLAS_MAGIC   0x534c5441 // 'ATLS'
+#define ATLAS_VERSION 9
+
+#define ATLAS_FORMAT_RGBA32 0
+#define ATLAS_FORMAT_R8     1
+#define ATLAS_FORMAT_SDF    2 // distance, 0.5 on the edge, 'spread' pixels to 0 and 1.
+#define ATLAS_FORMAT_MSDF   3 // median(r, g, b) is the distance, alpha is a plain sdf.
+#define ATLAS_FORMAT_BC4    4 // r8 compressed, 8 bytes per 4x4 block (bc4 unorm), rows of blocks bottom-up.
+
+#define ATLAS_LEGACY_GLYPH_COUNT 233 // ' '(32) -> 'y diaeresis'(255)
+
+#define ATLAS_MAX_LEVELS 16
+
+#define ATLAS_COMPRESSION_NONE 0
+#define ATLAS_COMPRESSION_LZ4  1 // independent chunks, each one lz4 block.
+
+#define ATLAS_PAGE_SIZE 256
+#define ATLAS_NO_GLYPH  0xffff
+
+#pragma pack(push, 1)
+// also in the headers baked with -e, whichever is included first has them.
+#ifndef ATLAS_BAKED_TYPES
+#define ATLAS_BAKED_TYPES
+typedef struct atlas_glyph
+{
+    int8_t  character; // ansi code page (1252), 0 for the rest. 'codepoints' has the real one.
+    int32_t offset;
+
+    int32_t     spacing;
+    int32_t pre_spacing;
+
+    int32_t  width;
+    int32_t height;
+
+    float u0;
+    float u1;
+    float v0;
+    float v1;
+} atlas_glyph;
+
+typedef struct atlas_size
+{
+    float   points;
+    int32_t glyph_first; // its glyphs are [glyph_first, glyph_first + glyph_count).
+    int32_t glyph_count;
+    int32_t glyph_height;
+    int32_t glyph_width;
+    int32_t line_spacing;
+    int32_t lookup_offset;
+    int32_t lookup_size;
+    int32_t page_count;
+} atlas_size;
+
+typedef struct atlas_kernpair
+{
+    uint16_t second; // glyph index.
+    int16_t  value;  // pixels * 64.
+} atlas_kernpair;
+#endif
+
+typedef struct atlas_fileheader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t format;
+    uint32_t header_size;
+
+    int32_t   size;
+    int32_t  width;
+    int32_t height;
+    int32_t glyph_count;
+
+    int32_t glyph_height;
+    int32_t glyph_width;
+
+    int32_t line_spacing;
+
+    int32_t glyph_offset;
+    int32_t  byte_offset;
+
+    // version 3.
+    int32_t codepoint_offset;
+    int32_t    lookup_offset;
+    int32_t    lookup_size;
+    int32_t      page_count;
+
+    // version 4.
+    int32_t spread;
+
+    // version 5.
+    int32_t level_count;
+    int32_t level_offsets[ATLAS_MAX_LEVELS];
+
+    // version 6.
+    uint32_t compression;
+    int32_t  payload_size;
+    int32_t  chunk_size;
+    int32_t  chunk_count;
+    int32_t  chunk_offset;
+
+    // version 7.
+    int32_t kerning_offset;
+    int32_t    pair_offset;
+    int32_t    pair_count;
+
+    // version 8.
+    int32_t size_count;
+    int32_t size_offset; // atlas_size[size_count], 0 with one size.
+
+    // version 9.
+    int32_t texture_count;
+    int32_t texture_size;   // payload bytes of one texture, texture t's level n is at 'level_offsets[n] + t * texture_size'.
+    int32_t texture_offset; // uint16_t[glyph_count], the texture of every glyph. 0 with one texture.
+} atlas_fileheader;
+
+typedef struct atlas_legacyheader // no magic, rgba32.
+{
+    int32_t   size;
+    int32_t  width;
+    int32_t height;
+    int32_t glyph_count;
+
+    int32_t glyph_height;
+    int32_t glyph_width;
+
+    int32_t line_spacing;
+
+    int32_t glyph_offset;
+    int32_t  byte_offset;
+} atlas_legacyheader;
+#pragma pack(pop)
+
+typedef struct atlas_font
+{
+    // everything points into 'data'.
+    const atlas_glyph* glyphs;
+    const uint8_t*     pixels; // bottom-up rows, 'width' pixels each.
+
+    // version 3, 0 before: the codepoint of every glyph (ascending, per size) and the lookup, see 'atlas_findglyph'.
+    const uint32_t* codepoints;
+    const uint16_t* lookup;
+    int32_t         page_count;
+
+    int32_t glyph_count;
+    int32_t width;
+    int32_t height;
+    int32_t format;          // ATLAS_FORMAT_
+    int32_t bytes_per_pixel; // 0 for bc4, see 'atlas_bytes'.
+    int32_t version;         // 1 = the unversioned layout.
+
+    int32_t glyph_width;
+    int32_t glyph_height;
+    int32_t line_spacing;
+    int32_t spread;          // sdf and msdf, in pixels. 0 otherwise.
+
+    // mips, 'levels[0]' is 'pixels'. level n is (width >> n) * (height >> n) pixels, see 'atlas_level' and 'atlas_bytes'.
+    int32_t        level_count;
+    const uint8_t* levels[ATLAS_MAX_LEVELS];        // 0 when compressed.
+    uint32_t       level_offsets[ATLAS_MAX_LEVELS]; // from 'pixels', or the start of the decompressed payload.
+
+    // version 6, see 'atlas_decompress'. 'payload_size' is every level's bytes, compressed or not.
+    int32_t         compression; // ATLAS_COMPRESSION_
+    int32_t         payload_size;
+    int32_t         chunk_size;
+    int32_t         chunk_count;
+    const uint32_t* chunks;      // chunk_count + 1 file offsets, chunk n is [chunks[n], chunks[n + 1]).
+
+    // version 7, 0 when there's no kerning. the pairs of glyph n are [kerning[n], kerning[n + 1]) in 'kern_pairs',
+    // sorted by the second glyph.
+    const uint32_t*       kerning;
+    const atlas_kernpair* kern_pairs;
+    int32_t               pair_count;
+
+    // version 8, more than one size in the atlas: 'lookup', 'page_count' and the metrics above are the selected
+    // size's ('atlas_selectsize'), the glyphs of every size share 'glyphs', 'codepoints' and the kerning.
+    const atlas_size* sizes; // 0 with one size.
+    int32_t           size_count;
+    int32_t           size_index; // selected.
+
+    // version 9, more than one texture: 'pixels', 'levels' and 'level_offsets' are texture 0's, the rest follow
+    // 'texture_size' bytes apart (compressed, each one is chunked on its own). see 'atlas_texture'.
+    const uint16_t* textures;      // texture of every glyph, 0 with one texture.
+    int32_t         texture_count;
+    int32_t         texture_size;  // payload bytes of one texture, every level.
+
+    const void* data;
+    size_t      size;
+
+    // mapping, 0 when the memory came from 'atlas_load'.
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int mapped;
+#endif
+} atlas_font;
+
+// 0 -> 255 of the ansi code page (1252) as unicode, the baked glyphs are in this order.
+static const uint16_t atlas_codepage[32] =
+{
+    0x20ac, 0x0081, 0x201a, 0x0192, 0x201e, 0x2026, 0x2020, 0x2021,
+    0x02c6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008d, 0x017d, 0x008f,
+    0x0090, 0x2018, 0x2019, 0x201c, 0x201d, 0x2022, 0x2013, 0x2014,
+    0x02dc, 0x2122, 0x0161, 0x203a, 0x0153, 0x009d, 0x017e, 0x0178,
+};
+
+static inline int
+atlas_inside(size_t size, int64_t offset, int64_t bytes)
+{
+    return(offset >= 0 && bytes >= 0 && (uint64_t)(offset + bytes) <= (uint64_t)size);
+}
+// bytes of a 'width' x 'height' image (or mip level) in 'format'.
+static inline int64_t
+atlas_bytes(int32_t format, int64_t width, int64_t height)
+{
+    if(format == ATLAS_FORMAT_BC4) { return(((width + 3) / 4) * ((height + 3) / 4) * 8); }
+    return(width * height * ((format == ATLAS_FORMAT_R8 || format == ATLAS_FORMAT_SDF) ? 1 : 4));
+}
+// a codepoint lookup has to stay inside the file and every entry has to land inside the tables (and on a glyph
+// in [first, first + count)), so 'atlas_findglyph' doesn't check.
+static inline int
+atlas_checklookup(const uint8_t* bytes, int64_t size, int32_t lookup_offset, int32_t lookup_size, int32_t page_count,
+		  int32_t first, int32_t count)
+{
+    int64_t pages = (int64_t)lookup_size - ((int64_t)page_count * 2);
+    if(page_count <= 0 || page_count > (0x110000 / ATLAS_PAGE_SIZE)) { return(0); }
+    if(pages < 0 || (pages % (ATLAS_PAGE_SIZE * 2)) != 0)            { return(0); }
+    if(!atlas_inside((size_t)size, lookup_offset, lookup_size))      { return(0); }
+    if(lookup_offset & 1)                                            { return(0); }
+
+    const uint16_t* lookup = (const uint16_t*)(bytes + lookup_offset);
+    int32_t page_total = (int32_t)(pages / (ATLAS_PAGE_SIZE * 2));
+    for(int32_t p = 0; p < page_count; p++)
+    {
+	if(lookup[p] >= page_total) { return(0); }
+    }
+    for(int32_t g = page_count; g < (lookup_size / 2); g++)
+    {
+	if(lookup[g] != ATLAS_NO_GLYPH && (lookup[g] < first || lookup[g] >= (first + count))) { return(0); }
+    }
+    return(1);
+}
+// checks the header and every offset against 'size', nothing is copied.
+static inline int
+atlas_load(atlas_font* font, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    memset(font, 0, sizeof(atlas_font));
+
+    if(!data || size < sizeof(atlas_legacyheader)) { return(0); }
+
+    int32_t width, height, glyph_count, glyph_offset, byte_offset, file_size;
+    uint32_t magic;
+    memcpy(&magic, bytes, sizeof(magic));
+    if(magic == ATLAS_MAGIC)
+    {
+	// version 2 ends at 'byte_offset', version 3 at 'page_count', version 4 at 'spread', version 5 at 'level_offsets',
+	// version 6 at 'chunk_offset', version 7 at 'pair_count', version 8 at 'size_offset'.
+	size_t base_size   = offsetof(atlas_fileheader, codepoint_offset);
+	size_t lookup_size = offsetof(atlas_fileheader, spread);
+	size_t spread_size = offsetof(atlas_fileheader, level_count);
+	size_t level_size  = offsetof(atlas_fileheader, compression);
+	size_t chunk_size  = offsetof(atlas_fileheader, kerning_offset);
+	size_t kern_size   = offsetof(atlas_fileheader, size_count);
+	size_t sizes_size  = offsetof(atlas_fileheader, texture_count);
+
+	atlas_fileheader header;
+	memset(&header, 0, sizeof(header));
+	if(size < base_size) { return(0); }
+	memcpy(&header, bytes, (size < sizeof(header)) ? size : sizeof(header));
+
+	// newer versions only append to the header, an older reader can't know what else changed.
+	if(header.version < 2 || header.version > ATLAS_VERSION) { return(0); }
+	size_t least_size = (header.version < 3) ? base_size : (header.version < 4) ? lookup_size :
+			    (header.version < 5) ? spread_size : (header.version < 6) ? level_size :
+			    (header.version < 7) ? chunk_size  : (header.version < 8) ? kern_size :
+			    (header.version < 9) ? sizes_size  : sizeof(header);
+	if(header.header_size < least_size || header.header_size > size) { return(0); }
+	if(header.format > ATLAS_FORMAT_BC4)                             { return(0); }
+
+	int distance = (header.format == ATLAS_FORMAT_SDF || header.format == ATLAS_FORMAT_MSDF);
+	if(distance && (header.version < 4 || header.spread <= 0)) { return(0); }
+
+	font->version         = header.version;
+	font->format          = header.format;
+	font->bytes_per_pixel = (header.format == ATLAS_FORMAT_BC4) ? 0 : (int32_t)atlas_bytes(header.format, 1, 1);
+	font->spread          = distance ? header.spread : 0;
+	font->glyph_width     = header.glyph_width;
+	font->glyph_height    = header.glyph_height;
+	font->line_spacing    = header.line_spacing;
+
+	width        = header.width;
+	height       = header.height;
+	glyph_count  = header.glyph_count;
+	glyph_offset = header.glyph_offset;
+	byte_offset  = header.byte_offset;
+	file_size    = header.size;
+
+	if(header.version >= 3)
+	{
+	    if(header.size < 0 || (size_t)header.size > size)                              { return(0); }
+	    if(!atlas_inside(header.size, header.codepoint_offset, (int64_t)header.glyph_count * 4)) { return(0); }
+	    if(header.codepoint_offset & 3)                                                { return(0); }
+	    if(!atlas_checklookup(bytes, header.size, header.lookup_offset, header.lookup_size, header.page_count,
+				  0, header.glyph_count))                                  { return(0); }
+
+	    font->codepoints = (const uint32_t*)(bytes + header.codepoint_offset);
+	    font->lookup     = (const uint16_t*)(bytes + header.lookup_offset);
+	    font->page_count = header.page_count;
+	}
+	font->size_count = 1;
+	if(header.version >= 8 && header.size_count != 1)
+	{
+	    // the sizes have to cover the glyphs in order, the first one is the header's.
+	    if(header.size_count < 1 || header.size_count > header.glyph_count)          { return(0); }
+	    if(!atlas_inside(header.size, header.size_offset, (int64_t)header.size_count * sizeof(atlas_size))) { return(0); }
+	    if(header.size_offset & 3)                                                   { return(0); }
+
+	    const atlas_size* sizes = (const atlas_size*)(bytes + header.size_offset);
+	    int32_t glyph_first = 0;
+	    for(int32_t s = 0; s < header.size_count; s++)
+	    {
+		const atlas_size* entry = &sizes[s];
+		if(entry->glyph_first != glyph_first || entry->glyph_count <= 0)         { return(0); }
+		if(entry->glyph_count > (header.glyph_count - glyph_first))              { return(0); }
+		if(!atlas_checklookup(bytes, header.size, entry->lookup_offset, entry->lookup_size, entry->page_count,
+				      entry->glyph_first, entry->glyph_count))           { return(0); }
+		glyph_first += entry->glyph_count;
+	    }
+	    if(glyph_first != header.glyph_count || sizes[0].lookup_offset != header.lookup_offset) { return(0); }
+
+	    font->sizes      = sizes;
+	    font->size_count = header.size_count;
+	}
+	if(header.version >= 7 && header.pair_count != 0)
+	{
+	    // every range has to be in order and inside the pairs, every second glyph a glyph, so
+	    // 'atlas_glyphkerning' doesn't check.
+	    int64_t index_bytes = ((int64_t)header.glyph_count + 1) * 4;
+	    if(header.pair_count < 0 || header.glyph_count <= 0)                         { return(0); }
+	    if(header.size < 0 || (size_t)header.size > size)                           { return(0); }
+	    if(!atlas_inside(header.size, header.kerning_offset, index_bytes))           { return(0); }
+	    if(!atlas_inside(header.size, header.pair_offset, (int64_t)header.pair_count * 4)) { return(0); }
+	    if((header.kerning_offset & 3) || (header.pair_offset & 1))                 { return(0); }
+
+	    const uint32_t*       kerning = (const uint32_t*)(bytes + header.kerning_offset);
+	    const atlas_kernpair* pairs   = (const atlas_kernpair*)(bytes + header.pair_offset);
+	    if(kerning[0] != 0 || kerning[header.glyph_count] != (uint32_t)header.pair_count) { return(0); }
+	    for(int32_t g = 0; g < header.glyph_count; g++)
+	    {
+		if(kerning[g + 1] < kerning[g]) { return(0); }
+	    }
+	    for(int32_t p = 0; p < header.pair_count; p++)
+	    {
+		if(pairs[p].second >= header.glyph_count) { return(0); }
+	    }
+
+	    font->kerning    = kerning;
+	    font->kern_pairs = pairs;
+	    font->pair_count = header.pair_count;
+	}
+	font->texture_count = 1;
+	if(header.version >= 9 && header.texture_count != 1)
+	{
+	    // every texture holds a glyph at least, every glyph is on one of them.
+	    if(header.texture_count < 1 || header.texture_count > header.glyph_count)    { return(0); }
+	    if(header.texture_size <= 0 || header.size < 0 || (size_t)header.size > size) { return(0); }
+	    if(!atlas_inside(header.size, header.texture_offset, (int64_t)header.glyph_count * 2) || (header.texture_offset & 1)) { return(0); }
+
+	    const uint16_t* textures = (const uint16_t*)(bytes + header.texture_offset);
+	    for(int32_t g = 0; g < header.glyph_count; g++)
+	    {
+		if(textures[g] >= header.texture_count) { return(0); }
+	    }
+
+	    font->textures      = textures;
+	    font->texture_count = header.texture_count;
+	    font->texture_size  = header.texture_size;
+	}
+	if(header.version >= 6 && header.compression != ATLAS_COMPRESSION_NONE)
+	{
+	    // the chunks have to cover the payload (every texture on its own) and stay inside the file, in order.
+	    int64_t texture_size = font->textures ? font->texture_size : header.payload_size;
+	    int64_t chunk_count  = (header.chunk_size > 0) ? ((texture_size + header.chunk_size - 1) / header.chunk_size) * font->texture_count : 0;
+	    int64_t table_bytes  = (chunk_count + 1) * 4;
+	    if(header.compression != ATLAS_COMPRESSION_LZ4 || header.byte_offset != 0)   { return(0); }
+	    if(header.payload_size <= 0 || chunk_count <= 0 || header.chunk_count != chunk_count) { return(0); }
+	    if((texture_size * font->texture_count) != header.payload_size)              { return(0); }
+	    if(header.size < 0 || (size_t)header.size > size)                             { return(0); }
+	    if(!atlas_inside(header.size, header.chunk_offset, table_bytes) || (header.chunk_offset & 3)) { return(0); }
+
+	    const uint32_t* chunks = (const uint32_t*)(bytes + header.chunk_offset);
+	    if(chunks[0] < (uint64_t)(header.chunk_offset + table_bytes)) { return(0); }
+	    for(int32_t chunk = 0; chunk < header.chunk_count; chunk++)
+	    {
+		if(chunks[chunk + 1] < chunks[chunk]) { return(0); }
+	    }
+	    if(chunks[header.chunk_count] > (uint32_t)header.size) { return(0); }
+
+	    font->compression  = ATLAS_COMPRESSION_LZ4;
+	    font->payload_size = header.payload_size;
+	    font->chunk_size   = header.chunk_size;
+	    font->chunk_count  = header.chunk_count;
+	    font->chunks       = chunks;
+	}
+	if(header.version >= 5)
+	{
+	    if(header.level_count < 1 || header.level_count > ATLAS_MAX_LEVELS) { return(0); }
+	    if(header.level_offsets[0] != header.byte_offset)                   { return(0); }
+	    if(header.size < 0 || (size_t)header.size > size)                   { return(0); }
+
+	    // compressed, the levels are inside the payload instead of the file. with more than one texture
+	    // they have to fit in one (the others follow it), and the last one in the file.
+	    int64_t payload_end = 0;
+	    for(int32_t level = 0; level < header.level_count; level++)
+	    {
+		int64_t level_width  = header.width  >> level;
+		int64_t level_height = header.height >> level;
+		int64_t level_bytes  = atlas_bytes(header.format, level_width, level_height);
+		int64_t level_offset = header.level_offsets[level];
+		if(level_width <= 0 || level_height <= 0) { return(0); }
+		if(!atlas_inside(font->compression ? (size_t)font->payload_size : (size_t)header.size, level_offset, level_bytes)) { return(0); }
+		if(font->textures && (level_offset - header.byte_offset + level_bytes) > font->texture_size) { return(0); }
+
+		font->levels[level]        = font->compression ? 0 : bytes + level_offset;
+		font->level_offsets[level] = (uint32_t)(level_offset - header.byte_offset);
+		if((level_offset + level_bytes) > payload_end) { payload_end = level_offset + level_bytes; }
+	    }
+	    font->level_count = header.level_count;
+	    if(font->textures)
+	    {
+		int64_t payload_size = (int64_t)font->texture_size * font->texture_count;
+		if(!font->compression && !atlas_inside(header.size, header.byte_offset, payload_size)) { return(0); }
+		if(!font->compression) { font->payload_size = (int32_t)payload_size; }
+	    }
+	    else if(!font->compression)
+	    {
+		font->payload_size = (int32_t)(payload_end - header.byte_offset);
+	    }
+	}
+    }
+    else
+    {
+	atlas_legacyheader header;
+	memcpy(&header, bytes, sizeof(header));
+	if(header.glyph_count != ATLAS_LEGACY_GLYPH_COUNT) { return(0); }
+
+	font->version         = 1;
+	font->size_count      = 1;
+	font->texture_count   = 1;
+	font->format          = ATLAS_FORMAT_RGBA32;
+	font->bytes_per_pixel = 4;
+	font->glyph_width     = header.glyph_width;
+	font->glyph_height    = header.glyph_height;
+	font->line_spacing    = header.line_spacing;
+
+	width        = header.width;
+	height       = header.height;
+	glyph_count  = header.glyph_count;
+	glyph_offset = header.glyph_offset; // inside the header, right after the fields above.
+	byte_offset  = header.byte_offset;
+	file_size    = header.size;
+    }
+
+    int64_t glyph_bytes = (int64_t)glyph_count * sizeof(atlas_glyph);
+    int64_t pixel_bytes = atlas_bytes(font->format, width, height);
+    if(width <= 0 || height <= 0 || glyph_count <= 0)        { return(0); }
+    if(file_size < 0 || (size_t)file_size > size)             { return(0); }
+    if(!atlas_inside(file_size, glyph_offset, glyph_bytes))  { return(0); }
+    if(!font->compression && !atlas_inside(file_size, byte_offset, pixel_bytes)) { return(0); }
+
+    font->glyphs      = (const atlas_glyph*)(bytes + glyph_offset);
+    font->pixels      = font->compression ? 0 : bytes + byte_offset;
+    font->glyph_count = glyph_count;
+    if(font->level_count == 0)
+    {
+	font->level_count  = 1;
+	font->levels[0]    = font->pixels;
+	font->payload_size = (int32_t)pixel_bytes;
+    }
+    if(!font->textures) { font->texture_size = font->payload_size; }
+    font->width       = width;
+    font->height      = height;
+    font->data        = data;
+    font->size        = size;
+    return(1);
+}
+// maps 'path' read only, the pages are only read in when touched.
+static inline int
+atlas_open(atlas_font* font, const char* path)
+{
+    memset(font, 0, sizeof(atlas_font));
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(file == INVALID_HANDLE_VALUE) { return(0); }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = 0;
+    const void* data = 0;
+    if(GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+	mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+	if(mapping) { data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0); }
+    }
+    if(!data || !atlas_load(font, data, (size_t)size.QuadPart))
+    {
+	if(data)    { UnmapViewOfFile(data); }
+	if(mapping) { CloseHandle(mapping); }
+	CloseHandle(file);
+	memset(font, 0, sizeof(atlas_font));
+	return(0);
+    }
+    font->file    = file;
+    font->mapping = mapping;
+    return(1);
+#else
+    int handle = open(path, O_RDONLY);
+    if(handle == -1) { return(0); }
+
+    struct stat status;
+    void* data = MAP_FAILED;
+    if(fstat(handle, &status) == 0 && status.st_size > 0)
+    {
+	data = mmap(0, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+    }
+    close(handle); // the mapping keeps the file.
+
+    if(data == MAP_FAILED) { return(0); }
+    if(!atlas_load(font, data, (size_t)status.st_size))
+    {
+	munmap(data, (size_t)status.st_size);
+	memset(font, 0, sizeof(atlas_font));
+	return(0);
+    }
+    font->mapped = 1;
+    return(1);
+#endif
+}
+static inline void
+atlas_close(atlas_font* font)
+{
+#if defined(_WIN32)
+    if(font->mapping)
+    {
+	UnmapViewOfFile(font->data);
+	CloseHandle(font->mapping);
+	CloseHandle(font->file);
+    }
+#else
+    if(font->mapped)
+    {
+	munmap((void*)font->data, font->size);
+    }
+#endif
+    memset(font, 0, sizeof(atlas_font));
+}
+// makes 'size' (0 -> size_count - 1) the one 'atlas_findglyph', the metrics and the layout use. 0 when there's no such size.
+static inline int
+atlas_selectsize(atlas_font* font, int32_t size)
+{
+    if(size < 0 || size >= font->size_count) { return(0); }
+    if(font->sizes)
+    {
+	const atlas_size* entry = &font->sizes[size];
+	font->lookup       = (const uint16_t*)((const uint8_t*)font->data + entry->lookup_offset);
+	font->page_count   = entry->page_count;
+	font->glyph_height = entry->glyph_height;
+	font->glyph_width  = entry->glyph_width;
+	font->line_spacing = entry->line_spacing;
+    }
+    font->size_index = size;
+    return(1);
+}
+// the size closest to 'points', 0 with one size.
+static inline int32_t
+atlas_findsize(const atlas_font* font, float points)
+{
+    int32_t best = 0;
+    for(int32_t s = 1; s < font->size_count; s++)
+    {
+	float distance = font->sizes[s].points - points;
+	float closest  = font->sizes[best].points - points;
+	if((distance * distance) < (closest * closest)) { best = s; }
+    }
+    return(best);
+}
+// mip 'level' (0 = the atlas) of the first texture, 0 when there isn't one (or the font is compressed). uvs are
+// the same on every level, 'atlas_bytes' is its size.
+static inline const uint8_t*
+atlas_level(const atlas_font* font, int32_t level, int32_t* width, int32_t* height)
+{
+    if(level < 0 || level >= font->level_count) { return(0); }
+
+    *width  = font->width  >> level;
+    *height = font->height >> level;
+    return(font->levels[level]);
+}
+// mip 'level' of 'texture' (0 -> texture_count - 1), like 'atlas_level'.
+static inline const uint8_t*
+atlas_texture(const atlas_font* font, int32_t texture, int32_t level, int32_t* width, int32_t* height)
+{
+    if(texture < 0 || texture >= font->texture_count) { return(0); }
+
+    const uint8_t* pixels = atlas_level(font, level, width, height);
+    return(pixels ? pixels + ((int64_t)texture * font->texture_size) : 0);
+}
+// the texture 'glyph' is on, its uvs are inside that one.
+static inline int32_t
+atlas_glyphtexture(const atlas_font* font, const atlas_glyph* glyph)
+{
+    return(font->textures ? font->textures[glyph - font->glyphs] : 0);
+}
+// one lz4 block, 'source_size' bytes -> exactly 'target_size' bytes. 0 if it's malformed, nothing is read
+// or written outside the two.
+static inline int
+atlas_lz4(const uint8_t* source, size_t source_size, uint8_t* target, size_t target_size)
+{
+    const uint8_t* end = source + source_size;
+    size_t written = 0;
+    for(;;)
+    {
+	if(source >= end) { return(0); }
+	unsigned token = *source++;
+
+	size_t literals = token >> 4;
+	if(literals == 15)
+	{
+	    unsigned more;
+	    do
+	    {
+		if(source >= end) { return(0); }
+		more      = *source++;
+		literals += more;
+	    } while(more == 255);
+	}
+	if(literals > (size_t)(end - source) || literals > (target_size - written)) { return(0); }
+	// short copies are done 16 bytes at a time when there's room, the extra bytes are overwritten later.
+	if(literals <= 16 && (end - source) >= 16 && (target_size - written) >= 16) { memcpy(target + written, source, 16); }
+	else                                                                         { memcpy(target + written, source, literals); }
+	source  += literals;
+	written += literals;
+
+	if(source == end) { return(written == target_size); } // the last sequence has no match.
+
+	if((end - source) < 2) { return(0); }
+	size_t offset = (size_t)source[0] | ((size_t)source[1] << 8);
+	source += 2;
+
+	size_t length = token & 15;
+	if(length == 15)
+	{
+	    unsigned more;
+	    do
+	    {
+		if(source >= end) { return(0); }
+		more    = *source++;
+		length += more;
+	    } while(more == 255);
+	}
+	length += 4;
+	if(offset == 0 || offset > written || length > (target_size - written)) { return(0); }
+
+	// a match closer than its length repeats itself (a run), copied in pieces that never overlap: every
+	// piece doubles how far back the next one can read from.
+	uint8_t* to = target + written;
+	if(offset >= 16 && length <= 16 && (target_size - written) >= 16)
+	{
+	    memcpy(to, to - offset, 16);
+	    written += length;
+	    continue;
+	}
+	written += length;
+	for(size_t distance = offset; length > 0; )
+	{
+	    size_t piece = (distance < length) ? distance : length;
+	    memcpy(to, to - distance, piece);
+	    to       += piece;
+	    length   -= piece;
+	    distance += piece;
+	}
+    }
+}
+// payload bytes 'chunk * chunk_size' on ('chunk_size' of them, what's left for the last chunk) into 'target'.
+// with more than one texture the chunks start over with every texture, 'chunk_count / texture_count' each.
+static inline int
+atlas_decompresschunk(const atlas_font* font, int32_t chunk, void* target)
+{
+    if(font->compression != ATLAS_COMPRESSION_LZ4 || chunk < 0 || chunk >= font->chunk_count) { return(0); }
+
+    int32_t texture_chunks = font->chunk_count / font->texture_count;
+    int64_t start = (int64_t)(chunk % texture_chunks) * font->chunk_size;
+    int64_t bytes = font->texture_size - start;
+    bytes = (bytes > font->chunk_size) ? font->chunk_size : bytes;
+
+    const uint8_t* source = (const uint8_t*)font->data + font->chunks[chunk];
+    return(atlas_lz4(source, font->chunks[chunk + 1] - font->chunks[chunk], (uint8_t*)target, (size_t)bytes));
+}
+// one texture (every level) into 'target', 'texture_size' bytes. uncompressed fonts are just copied.
+static inline int
+atlas_decompresstexture(const atlas_font* font, int32_t texture, void* target)
+{
+    if(texture < 0 || texture >= font->texture_count) { return(0); }
+    if(font->compression == ATLAS_COMPRESSION_NONE)
+    {
+	memcpy(target, font->pixels + ((int64_t)texture * font->texture_size), (size_t)font->texture_size);
+	return(1);
+    }
+    int32_t texture_chunks = font->chunk_count / font->texture_count;
+    for(int32_t chunk = 0; chunk < texture_chunks; chunk++)
+    {
+	if(!atlas_decompresschunk(font, (texture * texture_chunks) + chunk,
+				  (uint8_t*)target + ((int64_t)chunk * font->chunk_size))) { return(0); }
+    }
+    return(1);
+}
+// the whole payload (every level of every texture) into 'target', 'payload_size' bytes. uncompressed fonts are just copied.
+static inline int
+atlas_decompress(const atlas_font* font, void* target)
+{
+    if(font->compression == ATLAS_COMPRESSION_NONE)
+    {
+	memcpy(target, font->pixels, (size_t)font->payload_size);
+	return(1);
+    }
+    for(int32_t texture = 0; texture < font->texture_count; texture++)
+    {
+	if(!atlas_decompresstexture(font, texture, (uint8_t*)target + ((int64_t)texture * font->texture_size))) { return(0); }
+    }
+    return(1);
+}
+// the glyph of a unicode codepoint, 0 when it wasn't baked. O(1), nothing is searched.
+static inline const atlas_glyph*
+atlas_findglyph(const atlas_font* font, uint32_t codepoint)
+{
+    if(font->lookup)
+    {
+	// page of 256 codepoints, then the glyph inside it. page 0 is all empty.
+	uint32_t page = codepoint / ATLAS_PAGE_SIZE;
+	if(page >= (uint32_t)font->page_count) { return(0); }
+
+	uint16_t index = font->lookup[font->page_count + (font->lookup[page] * ATLAS_PAGE_SIZE) + (codepoint % ATLAS_PAGE_SIZE)];
+	return((index == ATLAS_NO_GLYPH) ? 0 : &font->glyphs[index]);
+    }
+
+    // the baked glyphs are the ansi code page (1252) from ' ' on, so only its 32 non latin-1
+    // characters (0x80 -> 0x9f) need mapping back. they all live below 0x2200.
+    uint32_t character = codepoint;
+    if(codepoint >= 0x80 && codepoint < 0xa0)
+    {
+	// latin-1 controls, only baked where 1252 leaves them undefined.
+	if(atlas_codepage[codepoint - 0x80] != codepoint) { return(0); }
+    }
+    else if(codepoint >= 0x100)
+    {
+	character = 0;
+	switch(codepoint)
+	{
+	case 0x20ac: character = 0x80; break; case 0x201a: character = 0x82; break;
+	case 0x0192: character = 0x83; break; case 0x201e: character = 0x84; break;
+	case 0x2026: character = 0x85; break; case 0x2020: character = 0x86; break;
+	case 0x2021: character = 0x87; break; case 0x02c6: character = 0x88; break;
+	case 0x2030: character = 0x89; break; case 0x0160: character = 0x8a; break;
+	case 0x2039: character = 0x8b; break; case 0x0152: character = 0x8c; break;
+	case 0x017d: character = 0x8e; break; case 0x2018: character = 0x91; break;
+	case 0x2019: character = 0x92; break; case 0x201c: character = 0x93; break;
+	case 0x201d: character = 0x94; break; case 0x2022: character = 0x95; break;
+	case 0x2013: character = 0x96; break; case 0x2014: character = 0x97; break;
+	case 0x02dc: character = 0x98; break; case 0x2122: character = 0x99; break;
+	case 0x0161: character = 0x9a; break; case 0x203a: character = 0x9b; break;
+	case 0x0153: character = 0x9c; break; case 0x017e: character = 0x9e; break;
+	case 0x0178: character = 0x9f; break;
+	}
+	if(!character) { return(0); }
+    }
+
+    int32_t index = (int32_t)character - 32;
+    if(index < 0 || index >= font->glyph_count) { return(0); }
+    return(&font->glyphs[index]);
+}
+
+// kerning in pixels between two glyphs (indices into 'glyphs'), added to the first one's advance. the pairs of a
+// glyph are searched without branches that depend on the data.
+static inline float
+atlas_glyphkerning(const atlas_font* font, int32_t first, int32_t second)
+{
+    if(!font->kerning || (uint32_t)first >= (uint32_t)font->glyph_count) { return(0.0f); }
+
+    const atlas_kernpair* pair  = font->kern_pairs + font->kerning[first];
+    uint32_t              count = font->kerning[first + 1] - font->kerning[first];
+    if(count == 0) { return(0.0f); }
+
+    // the last pair whose second glyph is <= 'second'.
+    while(count > 1)
+    {
+	uint32_t half = count / 2;
+	pair   = (pair[half].second <= (uint32_t)second) ? (pair + half) : pair;
+	count -= half;
+    }
+    return((pair->second == (uint32_t)second) ? (pair->value * (1.0f / 64.0f)) : 0.0f);
+}
+// kerning between two codepoints, 0 when either wasn't baked.
+static inline float
+atlas_kerning(const atlas_font* font, uint32_t first, uint32_t second)
+{
+    const atlas_glyph* a = atlas_findglyph(font, first);
+    const atlas_glyph* b = atlas_findglyph(font, second);
+    if(!a || !b) { return(0.0f); }
+    return(atlas_glyphkerning(font, (int32_t)(a - font->glyphs), (int32_t)(b - font->glyphs)));
+}
+// the kerning after every codepoint of 'codepoints' (between it and the next one, the last one gets 0),
+// every glyph is looked up once.
+static inline void
+atlas_kernstring(const atlas_font* font, const uint32_t* codepoints, int32_t count, float* kerning)
+{
+    if(count <= 0) { return; }
+    if(!font->kerning)
+    {
+	memset(kerning, 0, (size_t)count * sizeof(float));
+	return;
+    }
+
+    const atlas_glyph* glyph = atlas_findglyph(font, codepoints[0]);
+    int32_t previous = glyph ? (int32_t)(glyph - font->glyphs) : -1;
+    for(int32_t c = 1; c < count; c++)
+    {
+	glyph = atlas_findglyph(font, codepoints[c]);
+	int32_t current = glyph ? (int32_t)(glyph - font->glyphs) : -1;
+
+	kerning[c - 1] = (current >= 0) ? atlas_glyphkerning(font, previous, current) : 0.0f;
+	previous = current;
+    }
+    kerning[count - 1] = 0.0f;
+}
+
+#endif
@@ -0,0 +1,822 @@
+// Distance
+//
+// Signed distance fields, so one small atlas can be drawn at any size.
+//
+// 'sdf_distance' works on the anti-aliased raster of a glyph: every pixel is seeded with how far
+// its coverage puts the edge from its centre, then the exact euclidean distance transform
+// (Felzenszwalb & Huttenlocher, separable, linear in the pixel count) spreads that to every pixel,
+// once for the outside and once for the inside.
+//
+// 'msdf_edges' and 'msdf_generate' work on the outline instead: the edges are coloured (corners
+// switch colour, so each channel only sees the edges meeting at a corner from one side) and every
+// channel stores the distance to its nearest edge. The median of the three keeps corners sharp
+// when magnified. Wherever the median and the raster disagree on inside/outside the raster wins.
+//
+// Distances are in pixels, positive inside. 'sdf_encode' maps +-spread to 255/0, the edge is 0.5.
+//
+
+#include <math.h>
+
+#define SDF_INFINITY 1e20f
+#define SDF_PI       3.14159265358979323846
+
+#define MSDF_RED     1
+#define MSDF_GREEN   2
+#define MSDF_YELLOW  3
+#define MSDF_BLUE    4
+#define MSDF_MAGENTA 5
+#define MSDF_CYAN    6
+#define MSDF_WHITE   7
+
+#define MSDF_CORNER_THRESHOLD 0.1411f // sin(3 radians), anything sharper is a corner.
+
+struct msdf_edge
+{
+    r32 x0, y0;
+    r32 x1, y1; // control point, quadratics only.
+    r32 x2, y2;
+    b32 quadratic;
+    u32 color;  // MSDF_
+    r32 min_x, min_y, max_x, max_y; // of the control points, the curve never leaves them.
+};
+// per thread, sized for the biggest glyph by the caller.
+struct sdf_scratch
+{
+    r32* outer;    // region width * height.
+    r32* inner;    // region width * height, the signed distance once 'sdf_distance' is done.
+    r32* line;     // max(width, height) + 1, one row or column.
+    r32* boundary; // max(width, height) + 1
+    s32* parabola; // max(width, height) + 1
+
+    msdf_edge* edges;
+    s32        edge_capacity; // points * 3 + contours * 6 is always enough.
+    r32        orientation;   // +1 when the outer contours run clockwise (truetype), -1 otherwise.
+};
+
+// squared distance to the nearest seed along one row or column, f -> d in place.
+internal void
+sdf_transform1d(r32* f, s32 count, s32 stride, sdf_scratch* scratch)
+{
+    r32* line     = scratch->line;
+    r32* boundary = scratch->boundary;
+    s32* parabola = scratch->parabola;
+
+    for(s32 q = 0; q < count; q++) { line[q] = f[q * stride]; }
+
+    // lower envelope of the parabolas rooted at every sample.
+    s32 k = 0;
+    parabola[0] = 0;
+    boundary[0] = -SDF_INFINITY;
+    boundary[1] =  SDF_INFINITY;
+    for(s32 q = 1; q < count; q++)
+    {
+	s32 r = parabola[k];
+	r32 s = ((line[q] + (r32)(q * q)) - (line[r] + (r32)(r * r))) / (r32)(2 * (q - r));
+	while(s <= boundary[k])
+	{
+	    k--;
+	    r = parabola[k];
+	    s = ((line[q] + (r32)(q * q)) - (line[r] + (r32)(r * r))) / (r32)(2 * (q - r));
+	}
+	k++;
+	parabola[k]     = q;
+	boundary[k]     = s;
+	boundary[k + 1] = SDF_INFINITY;
+    }
+
+    k = 0;
+    for(s32 q = 0; q < count; q++)
+    {
+	while(boundary[k + 1] < (r32)q) { k++; }
+	s32 r = parabola[k];
+	f[q * stride] = (r32)((q - r) * (q - r)) + line[r];
+    }
+}
+// columns then rows, O(width * height).
+internal void
+sdf_transform(r32* grid, s32 width, s32 height, sdf_scratch* scratch)
+{
+    for(s32 x = 0; x < width; x++)
+    {
+	sdf_transform1d(grid + x, height, width, scratch);
+    }
+    for(s32 y = 0; y < height; y++)
+    {
+	sdf_transform1d(grid + (y * width), width, 1, scratch);
+    }
+}
+// signed distance of every pixel of the region (x, y, width, height) of a coverage surface into
+// 'scratch->inner'. the region may hang over the surface, that part is empty.
+internal void
+sdf_distance(u8* coverage, s32 surface_width, s32 surface_height,
+	     s32 x, s32 y, s32 width, s32 height, sdf_scratch* scratch)
+{
+    r32* outer = scratch->outer;
+    r32* inner = scratch->inner;
+    for(s32 row = 0; row < height; row++)
+    {
+	for(s32 column = 0; column < width; column++)
+	{
+	    s32 sx = x + column;
+	    s32 sy = y + row;
+	    r32 a  = 0.0f;
+	    if(sx >= 0 && sy >= 0 && sx < surface_width && sy < surface_height)
+	    {
+		a = coverage[(sy * surface_width) + sx] / 255.0f;
+	    }
+
+	    // half covered is on the edge, the rest is how far the edge is from the centre.
+	    s32 pixel = (row * width) + column;
+	    if(a >= 1.0f)
+	    {
+		outer[pixel] = 0.0f;
+		inner[pixel] = SDF_INFINITY;
+	    }
+	    else if(a <= 0.0f)
+	    {
+		outer[pixel] = SDF_INFINITY;
+		inner[pixel] = 0.0f;
+	    }
+	    else
+	    {
+		r32 d_out = (a < 0.5f) ? (0.5f - a) : 0.0f;
+		r32 d_in  = (a > 0.5f) ? (a - 0.5f) : 0.0f;
+		outer[pixel] = d_out * d_out;
+		inner[pixel] = d_in  * d_in;
+	    }
+	}
+    }
+
+    sdf_transform(outer, width, height, scratch);
+    sdf_transform(inner, width, height, scratch);
+
+    s32 count = width * height;
+    for(s32 pixel = 0; pixel < count; pixel++)
+    {
+	inner[pixel] = sqrtf(inner[pixel]) - sqrtf(outer[pixel]);
+    }
+}
+internal u8
+sdf_encode(r32 distance, r32 spread)
+{
+    r32 value = (0.5f + (distance / (2.0f * spread))) * 255.0f;
+    value = (value < 0.0f) ? 0.0f : ((value > 255.0f) ? 255.0f : value);
+    return((u8)(value + 0.5f));
+}
+
+// msdf.
+internal void
+msdf_bounds(msdf_edge* edge)
+{
+    edge->min_x = fminf(edge->x0, edge->x2); edge->max_x = fmaxf(edge->x0, edge->x2);
+    edge->min_y = fminf(edge->y0, edge->y2); edge->max_y = fmaxf(edge->y0, edge->y2);
+    if(edge->quadratic)
+    {
+	edge->min_x = fminf(edge->min_x, edge->x1); edge->max_x = fmaxf(edge->max_x, edge->x1);
+	edge->min_y = fminf(edge->min_y, edge->y1); edge->max_y = fmaxf(edge->max_y, edge->y1);
+    }
+}
+internal void
+msdf_addedge(sdf_scratch* scratch, s32* edge_count, b32 quadratic,
+	     r32 x0, r32 y0, r32 x1, r32 y1, r32 x2, r32 y2)
+{
+    if(*edge_count >= scratch->edge_capacity) { return; }
+    if(x0 == x2 && y0 == y2 && (!quadratic || (x1 == x0 && y1 == y0))) { return; } // nothing to measure.
+
+    msdf_edge* edge = &scratch->edges[(*edge_count)++];
+    edge->x0 = x0; edge->y0 = y0;
+    edge->x1 = x1; edge->y1 = y1;
+    edge->x2 = x2; edge->y2 = y2;
+    edge->quadratic = quadratic;
+    edge->color     = MSDF_WHITE;
+    msdf_bounds(edge);
+}
+internal void
+msdf_point(msdf_edge* edge, r32 t, r32* x, r32* y)
+{
+    if(edge->quadratic)
+    {
+	r32 mt = 1.0f - t;
+	*x = (mt * mt * edge->x0) + (2.0f * mt * t * edge->x1) + (t * t * edge->x2);
+	*y = (mt * mt * edge->y0) + (2.0f * mt * t * edge->y1) + (t * t * edge->y2);
+    }
+    else
+    {
+	*x = edge->x0 + ((edge->x2 - edge->x0) * t);
+	*y = edge->y0 + ((edge->y2 - edge->y0) * t);
+    }
+}
+internal void
+msdf_direction(msdf_edge* edge, r32 t, r32* x, r32* y)
+{
+    *x = edge->x2 - edge->x0;
+    *y = edge->y2 - edge->y0;
+    if(edge->quadratic)
+    {
+	r32 dx = ((edge->x1 - edge->x0) * (1.0f - t)) + ((edge->x2 - edge->x1) * t);
+	r32 dy = ((edge->y1 - edge->y0) * (1.0f - t)) + ((edge->y2 - edge->y1) * t);
+	if(dx != 0.0f || dy != 0.0f) { *x = dx; *y = dy; } // control on an end point.
+    }
+}
+internal void
+msdf_normalize(r32* x, r32* y)
+{
+    r32 length = sqrtf((*x * *x) + (*y * *y));
+    if(length > 0.0f) { *x /= length; *y /= length; }
+}
+// the same edge in thirds (for contours too short to colour).
+internal void
+msdf_splitthirds(msdf_edge* edge, msdf_edge* parts)
+{
+    r32 ax, ay, bx, by;
+    msdf_point(edge, 1.0f/3.0f, &ax, &ay);
+    msdf_point(edge, 2.0f/3.0f, &bx, &by);
+    for(s32 p = 0; p < 3; p++) { parts[p] = *edge; }
+
+    parts[0].x2 = ax; parts[0].y2 = ay;
+    parts[1].x0 = ax; parts[1].y0 = ay; parts[1].x2 = bx; parts[1].y2 = by;
+    parts[2].x0 = bx; parts[2].y0 = by;
+    if(edge->quadratic)
+    {
+	parts[0].x1 = edge->x0 + ((edge->x1 - edge->x0) / 3.0f);
+	parts[0].y1 = edge->y0 + ((edge->y1 - edge->y0) / 3.0f);
+	parts[1].x1 = 0.5f * ((edge->x0 + ((edge->x1 - edge->x0) * (5.0f/9.0f))) + (edge->x1 + ((edge->x2 - edge->x1) * (4.0f/9.0f))));
+	parts[1].y1 = 0.5f * ((edge->y0 + ((edge->y1 - edge->y0) * (5.0f/9.0f))) + (edge->y1 + ((edge->y2 - edge->y1) * (4.0f/9.0f))));
+	parts[2].x1 = edge->x1 + ((edge->x2 - edge->x1) * (2.0f/3.0f));
+	parts[2].y1 = edge->y1 + ((edge->y2 - edge->y1) * (2.0f/3.0f));
+    }
+    for(s32 p = 0; p < 3; p++) { msdf_bounds(&parts[p]); }
+}
+// next of the two-channel colours, never 'banned' (a single channel) when given.
+internal u32
+msdf_switchcolor(u32 color, u32 banned)
+{
+    u32 combined = color & banned;
+    if(combined == MSDF_RED || combined == MSDF_GREEN || combined == MSDF_BLUE)
+    {
+	return(combined ^ MSDF_WHITE);
+    }
+    if(color == 0 || color == MSDF_WHITE) { return(MSDF_CYAN); }
+
+    u32 shifted = color << 1;
+    return((shifted | (shifted >> 3)) & MSDF_WHITE);
+}
+internal b32
+msdf_iscorner(msdf_edge* edges, s32 count, s32 e)
+{
+    r32 px, py, x, y;
+    msdf_direction(&edges[(e + count - 1) % count], 1.0f, &px, &py);
+    msdf_direction(&edges[e], 0.0f, &x, &y);
+    msdf_normalize(&px, &py);
+    msdf_normalize(&x, &y);
+    return(((px * x) + (py * y)) <= 0.0f || fabsf((px * y) - (py * x)) > MSDF_CORNER_THRESHOLD);
+}
+// colours the edges of one contour (edges[first] -> edges[*edge_count - 1]).
+internal void
+msdf_colorcontour(sdf_scratch* scratch, s32 first, s32* edge_count, u32* color)
+{
+    msdf_edge* edges = scratch->edges + first;
+    s32 count = *edge_count - first;
+    if(count <= 0) { return; }
+
+    s32 corner_count = 0;
+    s32 first_corner = 0;
+    for(s32 e = 0; e < count; e++)
+    {
+	if(msdf_iscorner(edges, count, e))
+	{
+	    if(corner_count == 0) { first_corner = e; }
+	    corner_count++;
+	}
+    }
+
+    if(corner_count == 0)
+    {
+	// smooth, every channel sees every edge.
+	*color = msdf_switchcolor(*color, 0);
+	for(s32 e = 0; e < count; e++) { edges[e].color = *color; }
+    }
+    else if(corner_count == 1)
+    {
+	// teardrop, three colours along the contour (white in the middle).
+	u32 colors[3];
+	*color    = msdf_switchcolor(*color, 0);
+	colors[0] = *color;
+	colors[1] = MSDF_WHITE;
+	*color    = msdf_switchcolor(*color, 0);
+	colors[2] = *color;
+
+	if(count >= 3)
+	{
+	    for(s32 e = 0; e < count; e++)
+	    {
+		s32 third = (s32)(3.0f + ((2.875f * e) / (count - 1)) - 1.4375f + 0.5f) - 3;
+		edges[(first_corner + e) % count].color = colors[1 + third];
+	    }
+	}
+	else if(first + (count * 3) <= scratch->edge_capacity)
+	{
+	    // too few edges for three colours, they're split.
+	    msdf_edge split[6];
+	    msdf_splitthirds(&edges[0], &split[3 * first_corner]);
+	    if(count == 2)
+	    {
+		msdf_splitthirds(&edges[1], &split[3 - (3 * first_corner)]);
+		split[0].color = split[1].color = colors[0];
+		split[2].color = split[3].color = colors[1];
+		split[4].color = split[5].color = colors[2];
+	    }
+	    else
+	    {
+		split[0].color = colors[0];
+		split[1].color = colors[1];
+		split[2].color = colors[2];
+	    }
+	    count *= 3;
+	    mem_copy(split, edges, count * sizeof(msdf_edge));
+	    *edge_count = first + count;
+	}
+    }
+    else
+    {
+	// a colour per spline (corner to corner), the last one may not match the first.
+	*color = msdf_switchcolor(*color, 0);
+	u32 initial = *color;
+
+	s32 spline = 0;
+	for(s32 e = 0; e < count; e++)
+	{
+	    s32 index = (first_corner + e) % count;
+	    if(e > 0 && (spline + 1) < corner_count && msdf_iscorner(edges, count, index))
+	    {
+		spline++;
+		*color = msdf_switchcolor(*color, (spline == (corner_count - 1)) ? initial : 0);
+	    }
+	    edges[index].color = *color;
+	}
+    }
+}
+// the outline as edges in surface pixels (same placement as 'raster_outline'), coloured.
+internal s32
+msdf_edges(sdf_scratch* scratch, ttf_outline* outline, r32 scale, r32 origin_x, r32 origin_y)
+{
+    s32 edge_count = 0;
+    u32 color      = 0;
+    r32 area       = 0.0f;
+
+    s32 start = 0;
+    for(s32 contour = 0; contour < outline->contour_count; contour++)
+    {
+	s32 end   = outline->contour_ends[contour];
+	s32 count = (end - start) + 1;
+	if(count < 2)
+	{
+	    start = end + 1;
+	    continue;
+	}
+	ttf_point* points = outline->points + start;
+	s32 first_edge = edge_count;
+
+	// same walk as 'raster_outline'.
+	r32 first_x, first_y;
+	s32 first = 0;
+	while(first < count && !points[first].on_curve) { first++; }
+	s32 next = first + 1;
+	if(first == count)
+	{
+	    first_x = 0.5f * (points[0].x + points[count - 1].x);
+	    first_y = 0.5f * (points[0].y + points[count - 1].y);
+	    next    = 0;
+	}
+	else
+	{
+	    first_x = points[first].x;
+	    first_y = points[first].y;
+	}
+
+	r32 x = origin_x + (first_x * scale);
+	r32 y = origin_y + (first_y * scale);
+	r32 start_x = x;
+	r32 start_y = y;
+
+	b32 have_control = false;
+	r32 control_x = 0.0f;
+	r32 control_y = 0.0f;
+	for(s32 i = 0; i < count; i++)
+	{
+	    ttf_point* point = &points[(next + i) % count];
+	    r32 px = origin_x + (point->x * scale);
+	    r32 py = origin_y + (point->y * scale);
+	    if(point->on_curve)
+	    {
+		msdf_addedge(scratch, &edge_count, have_control, x, y, control_x, control_y, px, py);
+		have_control = false;
+		x = px;
+		y = py;
+	    }
+	    else
+	    {
+		if(have_control)
+		{
+		    r32 mx = 0.5f * (control_x + px);
+		    r32 my = 0.5f * (control_y + py);
+		    msdf_addedge(scratch, &edge_count, true, x, y, control_x, control_y, mx, my);
+		    x = mx;
+		    y = my;
+		}
+		control_x    = px;
+		control_y    = py;
+		have_control = true;
+	    }
+	}
+	msdf_addedge(scratch, &edge_count, have_control, x, y, control_x, control_y, start_x, start_y);
+
+	// shoelace over the control polygon, enough for the winding direction.
+	for(s32 e = first_edge; e < edge_count; e++)
+	{
+	    msdf_edge* edge = &scratch->edges[e];
+	    if(edge->quadratic)
+	    {
+		area += (edge->x0 * edge->y1) - (edge->x1 * edge->y0);
+		area += (edge->x1 * edge->y2) - (edge->x2 * edge->y1);
+	    }
+	    else
+	    {
+		area += (edge->x0 * edge->y2) - (edge->x2 * edge->y0);
+	    }
+	}
+
+	msdf_colorcontour(scratch, first_edge, &edge_count, &color);
+	start = end + 1;
+    }
+
+    // clockwise (negative area, y up) keeps the inside on the right of every edge.
+    scratch->orientation = (area <= 0.0f) ? 1.0f : -1.0f;
+    return(edge_count);
+}
+
+internal s32
+msdf_solvequadratic(r64* x, r64 a, r64 b, r64 c)
+{
+    if(a == 0.0 || fabs(b) > 1e12 * fabs(a))
+    {
+	if(b == 0.0) { return(0); }
+	x[0] = -c / b;
+	return(1);
+    }
+    r64 discriminant = (b * b) - (4.0 * a * c);
+    if(discriminant > 0.0)
+    {
+	discriminant = sqrt(discriminant);
+	x[0] = (-b + discriminant) / (2.0 * a);
+	x[1] = (-b - discriminant) / (2.0 * a);
+	return(2);
+    }
+    if(discriminant == 0.0)
+    {
+	x[0] = -b / (2.0 * a);
+	return(1);
+    }
+    return(0);
+}
+// real roots of a*x^3 + b*x^2 + c*x + d.
+internal s32
+msdf_solvecubic(r64* x, r64 a, r64 b, r64 c, r64 d)
+{
+    if(a != 0.0 && fabs(b / a) < 1e6)
+    {
+	r64 bn = b / a;
+	r64 cn = c / a;
+	r64 dn = d / a;
+
+	r64 b2 = bn * bn;
+	r64 q  = (b2 - (3.0 * cn)) / 9.0;
+	r64 r  = ((bn * ((2.0 * b2) - (9.0 * cn))) + (27.0 * dn)) / 54.0;
+	r64 r2 = r * r;
+	r64 q3 = q * q * q;
+	bn /= 3.0;
+	if(r2 < q3)
+	{
+	    r64 t = r / sqrt(q3);
+	    t = (t < -1.0) ? -1.0 : ((t > 1.0) ? 1.0 : t);
+	    t = acos(t);
+	    q = -2.0 * sqrt(q);
+	    x[0] = (q * cos(t / 3.0)) - bn;
+	    x[1] = (q * cos((t + (2.0 * SDF_PI)) / 3.0)) - bn;
+	    x[2] = (q * cos((t - (2.0 * SDF_PI)) / 3.0)) - bn;
+	    return(3);
+	}
+	r64 u = ((r < 0.0) ? 1.0 : -1.0) * pow(fabs(r) + sqrt(r2 - q3), 1.0 / 3.0);
+	r64 v = (u == 0.0) ? 0.0 : (q / u);
+	x[0] = (u + v) - bn;
+	if(u == v || fabs(u - v) < 1e-12 * fabs(u + v))
+	{
+	    x[1] = (-0.5 * (u + v)) - bn;
+	    return(2);
+	}
+	return(1);
+    }
+    return(msdf_solvequadratic(x, b, c, d));
+}
+// signed distance from (px, py) to the edge, 'dot' breaks ties (the more perpendicular edge wins),
+// 'param' says where the nearest point is (< 0 and > 1 are past the ends).
+internal r32
+msdf_signeddistance(msdf_edge* edge, r32 px, r32 py, r32* dot, r32* param)
+{
+    if(!edge->quadratic)
+    {
+	r32 aqx = px - edge->x0;
+	r32 aqy = py - edge->y0;
+	r32 abx = edge->x2 - edge->x0;
+	r32 aby = edge->y2 - edge->y0;
+	*param = ((aqx * abx) + (aqy * aby)) / ((abx * abx) + (aby * aby));
+
+	r32 eqx = ((*param > 0.5f) ? edge->x2 : edge->x0) - px;
+	r32 eqy = ((*param > 0.5f) ? edge->y2 : edge->y0) - py;
+	r32 endpoint = sqrtf((eqx * eqx) + (eqy * eqy));
+	r32 length   = sqrtf((abx * abx) + (aby * aby));
+	if(*param > 0.0f && *param < 1.0f)
+	{
+	    r32 orthogonal = ((aby * aqx) - (abx * aqy)) / length;
+	    if(fabsf(orthogonal) < endpoint)
+	    {
+		*dot = 0.0f;
+		return(orthogonal);
+	    }
+	}
+	r32 cross = (aqx * aby) - (aqy * abx);
+	*dot = (endpoint > 0.0f) ? fabsf(((abx * eqx) + (aby * eqy)) / (length * endpoint)) : 0.0f;
+	return((cross < 0.0f) ? -endpoint : endpoint);
+    }
+
+    r32 qax = edge->x0 - px;
+    r32 qay = edge->y0 - py;
+    r32 abx = edge->x1 - edge->x0;
+    r32 aby = edge->y1 - edge->y0;
+    r32 brx = edge->x2 - edge->x1 - abx;
+    r32 bry = edge->y2 - edge->y1 - aby;
+
+    r64 roots[3];
+    s32 root_count = msdf_solvecubic(roots,
+				     (r64)((brx * brx) + (bry * bry)),
+				     3.0 * ((abx * brx) + (aby * bry)),
+				     (2.0 * ((abx * abx) + (aby * aby))) + ((qax * brx) + (qay * bry)),
+				     (r64)((qax * abx) + (qay * aby)));
+
+    // the two end points first.
+    r32 dx, dy;
+    msdf_direction(edge, 0.0f, &dx, &dy);
+    r32 distance = sqrtf((qax * qax) + (qay * qay));
+    r32 minimum  = (((dx * qay) - (dy * qax)) < 0.0f) ? -distance : distance;
+    *param = -((qax * dx) + (qay * dy)) / ((dx * dx) + (dy * dy));
+    {
+	r32 ex = edge->x2 - px;
+	r32 ey = edge->y2 - py;
+	msdf_direction(edge, 1.0f, &dx, &dy);
+	distance = sqrtf((ex * ex) + (ey * ey));
+	if(distance < fabsf(minimum))
+	{
+	    minimum = (((dx * ey) - (dy * ex)) < 0.0f) ? -distance : distance;
+	    *param  = (((px - edge->x1) * dx) + ((py - edge->y1) * dy)) / ((dx * dx) + (dy * dy));
+	}
+    }
+    for(s32 r = 0; r < root_count; r++)
+    {
+	r32 t = (r32)roots[r];
+	if(t > 0.0f && t < 1.0f)
+	{
+	    r32 qex = qax + (2.0f * t * abx) + (t * t * brx);
+	    r32 qey = qay + (2.0f * t * aby) + (t * t * bry);
+	    distance = sqrtf((qex * qex) + (qey * qey));
+	    if(distance <= fabsf(minimum))
+	    {
+		r32 tx = abx + (t * brx);
+		r32 ty = aby + (t * bry);
+		minimum = (((tx * qey) - (ty * qex)) < 0.0f) ? -distance : distance;
+		*param  = t;
+	    }
+	}
+    }
+
+    *dot = 0.0f;
+    if(*param < 0.0f || *param > 1.0f)
+    {
+	r32 t = (*param < 0.5f) ? 0.0f : 1.0f;
+	r32 qx, qy;
+	msdf_point(edge, t, &qx, &qy);
+	msdf_direction(edge, t, &dx, &dy);
+	qx -= px;
+	qy -= py;
+	r32 lengths = sqrtf((dx * dx) + (dy * dy)) * sqrtf((qx * qx) + (qy * qy));
+	*dot = (lengths > 0.0f) ? fabsf(((dx * qx) + (dy * qy)) / lengths) : 0.0f;
+    }
+    return(minimum);
+}
+// past an end point the distance to the tangent line is used instead, keeps corners sharp.
+internal r32
+msdf_pseudodistance(msdf_edge* edge, r32 distance, r32 px, r32 py, r32 param)
+{
+    if(param >= 0.0f && param <= 1.0f) { return(distance); }
+
+    r32 t = (param < 0.0f) ? 0.0f : 1.0f;
+    r32 dx, dy, qx, qy;
+    msdf_direction(edge, t, &dx, &dy);
+    msdf_normalize(&dx, &dy);
+    msdf_point(edge, t, &qx, &qy);
+    qx = px - qx;
+    qy = py - qy;
+
+    r32 along = (qx * dx) + (qy * dy);
+    if((param < 0.0f && along < 0.0f) || (param > 1.0f && along > 0.0f))
+    {
+	r32 pseudo = (qx * dy) - (qy * dx);
+	if(fabsf(pseudo) <= fabsf(distance)) { return(pseudo); }
+    }
+    return(distance);
+}
+internal r32
+msdf_median(r32 a, r32 b, r32 c)
+{
+    return(fmaxf(fminf(a, b), fminf(fmaxf(a, b), c)));
+}
+// true when the median 'xm', 't' of the way from 'am' to 'bm', is on the other side of the edge than
+// both and further from them than 'span' (per unit of 't') allows.
+internal b32
+msdf_inverted(r32 am, r32 bm, r32 xm, r32 t, r32 span)
+{
+    b32 inverted = (am > 0.5f && bm > 0.5f && xm <= 0.5f) || (am < 0.5f && bm < 0.5f && xm >= 0.5f);
+    return(inverted && !(xm >= am - (t * span) && xm <= am + (t * span) &&
+			 xm >= bm - ((1.0f - t) * span) && xm <= bm + ((1.0f - t) * span)));
+}
+// true when filtering between the pixels 'a' and 'b' would make up an edge: where two channels cross
+// the median jumps, if it lands on the other side of the edge than both ends it's an artifact.
+// only the pixel further from the edge is blamed.
+internal b32
+msdf_artifact(u8* a, u8* b, r32 span)
+{
+    r32 am = msdf_median(a[0], a[1], a[2]) / 255.0f;
+    r32 bm = msdf_median(b[0], b[1], b[2]) / 255.0f;
+    if(fabsf(am - 0.5f) < fabsf(bm - 0.5f)) { return(false); }
+
+    for(s32 i = 0; i < 3; i++)
+    {
+	s32 j  = (i + 1) % 3;
+	r32 da = (r32)(a[i] - a[j]);
+	r32 db = (r32)(b[i] - b[j]);
+	if(da == db) { continue; }
+
+	r32 t = da / (da - db);
+	if(t <= 0.001f || t >= 0.999f) { continue; }
+
+	r32 x[3];
+	for(s32 c = 0; c < 3; c++) { x[c] = (a[c] + ((b[c] - a[c]) * t)) / 255.0f; }
+	if(msdf_inverted(am, bm, msdf_median(x[0], x[1], x[2]), t, span)) { return(true); }
+    }
+    return(false);
+}
+// the same across a square, 'a' -> 'd' through the bilinear blend of all four ('b' and 'c' the others).
+internal b32
+msdf_diagonalartifact(u8* a, u8* b, u8* c, u8* d, r32 span)
+{
+    r32 am = msdf_median(a[0], a[1], a[2]) / 255.0f;
+    r32 dm = msdf_median(d[0], d[1], d[2]) / 255.0f;
+    if(fabsf(am - 0.5f) < fabsf(dm - 0.5f)) { return(false); }
+
+    // along the diagonal every channel is a + l*t + q*t^2.
+    r32 l[3], q[3];
+    for(s32 k = 0; k < 3; k++)
+    {
+	r32 abc = (r32)(a[k] - b[k] - c[k]);
+	l[k] = (r32)(-a[k]) - abc;
+	q[k] = (r32)d[k] + abc;
+    }
+    for(s32 i = 0; i < 3; i++)
+    {
+	s32 j   = (i + 1) % 3;
+	r32 dA  = (r32)(a[j] - a[i]);
+	r32 dBC = (r32)((b[j] - b[i]) + (c[j] - c[i]));
+	r32 dD  = (r32)(d[j] - d[i]);
+
+	r64 roots[2];
+	s32 root_count = msdf_solvequadratic(roots, dD - dBC + dA, dBC - dA - dA, dA);
+	for(s32 r = 0; r < root_count; r++)
+	{
+	    r32 t = (r32)roots[r];
+	    if(t <= 0.001f || t >= 0.999f) { continue; }
+
+	    r32 x[3];
+	    for(s32 k = 0; k < 3; k++) { x[k] = ((t * ((t * q[k]) + l[k])) + a[k]) / 255.0f; }
+	    if(msdf_inverted(am, dm, msdf_median(x[0], x[1], x[2]), t, span * 1.4142f)) { return(true); }
+	}
+    }
+    return(false);
+}
+// rgb = the three channels, a = 'distance' (the raster's, see 'sdf_distance'), 4 bytes per pixel.
+internal void
+msdf_generate(sdf_scratch* scratch, s32 edge_count, s32 x, s32 y, s32 width, s32 height,
+	      r32 spread, r32* distance, u8* target)
+{
+    for(s32 row = 0; row < height; row++)
+    {
+	for(s32 column = 0; column < width; column++)
+	{
+	    r32 px = x + column + 0.5f;
+	    r32 py = y + row    + 0.5f;
+
+	    r32 best[3]    = { SDF_INFINITY, SDF_INFINITY, SDF_INFINITY };
+	    r32 signs[3]   = {};
+	    r32 dots[3]    = { 1.0f, 1.0f, 1.0f };
+	    r32 params[3]  = {};
+	    s32 nearest[3] = { -1, -1, -1 };
+	    for(s32 e = 0; e < edge_count; e++)
+	    {
+		msdf_edge* edge = &scratch->edges[e];
+
+		// nothing on the edge can be nearer than its box.
+		r32 bx = (px < edge->min_x) ? (edge->min_x - px) : ((px > edge->max_x) ? (px - edge->max_x) : 0.0f);
+		r32 by = (py < edge->min_y) ? (edge->min_y - py) : ((py > edge->max_y) ? (py - edge->max_y) : 0.0f);
+		r32 bound = (bx * bx) + (by * by);
+		b32 needed = false;
+		for(s32 c = 0; c < 3; c++)
+		{
+		    if((edge->color & (1 << c)) && bound <= (best[c] * best[c])) { needed = true; }
+		}
+		if(!needed) { continue; }
+
+		r32 dot, param;
+		r32 d = msdf_signeddistance(edge, px, py, &dot, &param);
+		for(s32 c = 0; c < 3; c++)
+		{
+		    if(!(edge->color & (1 << c))) { continue; }
+		    if(fabsf(d) < best[c] || (fabsf(d) == best[c] && dot < dots[c]))
+		    {
+			best[c]    = fabsf(d);
+			signs[c]   = d;
+			dots[c]    = dot;
+			params[c]  = param;
+			nearest[c] = e;
+		    }
+		}
+	    }
+
+	    r32 channels[3];
+	    for(s32 c = 0; c < 3; c++)
+	    {
+		channels[c] = -SDF_INFINITY;
+		if(nearest[c] >= 0)
+		{
+		    msdf_edge* edge = &scratch->edges[nearest[c]];
+		    channels[c] = msdf_pseudodistance(edge, signs[c], px, py, params[c]) * scratch->orientation;
+		}
+	    }
+
+	    // the median has to agree with the raster about inside and outside.
+	    r32 sdf    = distance[(row * width) + column];
+	    r32 median = fmaxf(fminf(channels[0], channels[1]), fminf(fmaxf(channels[0], channels[1]), channels[2]));
+	    if(fabsf(sdf) > 0.5f && ((median > 0.0f) != (sdf > 0.0f)))
+	    {
+		channels[0] = channels[1] = channels[2] = sdf;
+	    }
+
+	    u8* pixel = target + (((row * width) + column) * 4);
+	    pixel[0] = sdf_encode(channels[0], spread);
+	    pixel[1] = sdf_encode(channels[1], spread);
+	    pixel[2] = sdf_encode(channels[2], spread);
+	    pixel[3] = sdf_encode(sdf,         spread);
+	}
+    }
+
+    // pixels that would make up an edge when filtered get their median in every channel.
+    // 'outer' is free again, it holds the marks.
+    r32* marks = scratch->outer;
+    r32  span  = 1.111f / (2.0f * spread); // how far the median may move in a pixel.
+    for(s32 row = 0; row < height; row++)
+    {
+	for(s32 column = 0; column < width; column++)
+	{
+	    u8* pixel = target + (((row * width) + column) * 4);
+	    b32 artifact = (column > 0            && msdf_artifact(pixel, pixel - 4,           span)) ||
+			   (column < (width - 1)  && msdf_artifact(pixel, pixel + 4,           span)) ||
+			   (row > 0               && msdf_artifact(pixel, pixel - (width * 4), span)) ||
+			   (row < (height - 1)    && msdf_artifact(pixel, pixel + (width * 4), span));
+	    for(s32 dy = -1; dy <= 1 && !artifact; dy += 2)
+	    {
+		for(s32 dx = -1; dx <= 1 && !artifact; dx += 2)
+		{
+		    if(column + dx < 0 || column + dx >= width || row + dy < 0 || row + dy >= height) { continue; }
+		    artifact = msdf_diagonalartifact(pixel, pixel + (dx * 4), pixel + (dy * width * 4),
+						     pixel + (((dy * width) + dx) * 4), span);
+		}
+	    }
+	    marks[(row * width) + column] = artifact ? 1.0f : 0.0f;
+	}
+    }
+    for(s32 pixel = 0; pixel < (width * height); pixel++)
+    {
+	if(marks[pixel] != 0.0f)
+	{
+	    u8* channels = target + (pixel * 4);
+	    channels[0] = channels[1] = channels[2] = (u8)msdf_median(channels[0], channels[1], channels[2]);
+	}
+    }
+}
@@ -0,0 +1,252 @@
+// Server
+//
+// With -w the baker keeps running and bakes requests as they come, for tools that re-bake all the time
+// (an editor's live preview). The platform layer listens (a unix socket on linux, a named pipe on
+// windows, '-' = standard input and output) and hands every connection to 'server_connection'.
+//
+// A request is a line, the same as a manifest line (see Batch). Every request is answered with a line:
+//
+//   fonts/Lato-Regular.ttf  12,24  out/Lato_{size}.font  20-7e    ->  ok 2 2 4.210
+//   fonts/Missing.ttf       12     out/Missing.font              ->  failed 0 1 0.015
+//   nonsense                                                     ->  invalid
+//   quit                                                         ->  bye (and the server stops)
+//
+// 'ok' / 'failed' are followed by the jobs baked, the jobs of the line and the milliseconds it took (the
+// files are written when it's answered). Empty lines and comments aren't answered. -p, -b, -f, -r, -l,
+// -q, -z, -x, -y, -e, -u, -c, -o and -dpi are the server's and apply to every request, the report (-o) is
+// rewritten after every request. It can't be '-' when the server is on standard input (the replies are
+// the standard output).
+//
+// What a process launch would do for every bake is done once: the truetype files stay mapped and parsed
+// between requests (opened again when the file changes), the worker threads, their arenas and the
+// output writer stay up. Connections are served at the same time, their bakes take turns (every bake
+// already has every thread).
+//
+
+#define SERVER_MAX_SOURCES 32  // truetype files kept open, the least recently used is closed first.
+#define SERVER_MAX_JOBS    32  // of a request.
+#define SERVER_MAX_LINE    2048
+
+struct server_source
+{
+    bake_source source;
+    s8          path[MAX_PATH];
+    u64         time; // last write, see 'platform_filetime'.
+    u64         used; // request it was last used by.
+};
+struct server_state
+{
+    std::mutex mutex; // one request at a time.
+
+    server_source sources[SERVER_MAX_SOURCES];
+    s32           source_count;
+    u64           requests;
+
+    bake_job jobs[SERVER_MAX_JOBS];
+};
+
+global server_state server;
+
+// reads what's there (at most 'size'), 0 or less = closed.
+typedef s32 server_readfunction(void* connection, s8* buffer, s32 size);
+typedef b32 server_writefunction(void* connection, const s8* data, s32 size);
+
+// 'path' parsed, from the last request when it hasn't changed since.
+internal bake_source*
+server_opensource(s8* path)
+{
+    u64 time = platform_filetime(path);
+    if(time == 0) { return(0); } // no such file.
+
+    server_source* entry = 0;
+    for(s32 s = 0; s < server.source_count && !entry; s++)
+    {
+	if(strcmp(server.sources[s].path, path) == 0) { entry = &server.sources[s]; }
+    }
+    if(entry && entry->time != time)
+    {
+	bake_closesource(&entry->source); // changed, parse it again.
+    }
+    if(!entry)
+    {
+	if(server.source_count < SERVER_MAX_SOURCES)
+	{
+	    entry = &server.sources[server.source_count++];
+	}
+	else
+	{
+	    entry = &server.sources[0];
+	    for(s32 s = 1; s < server.source_count; s++)
+	    {
+		if(server.sources[s].used < entry->used) { entry = &server.sources[s]; }
+	    }
+	    bake_closesource(&entry->source);
+	}
+	mem_copy(path, entry->path, MAX_PATH);
+    }
+    entry->used = server.requests;
+
+    if(!entry->source.file.data)
+    {
+	entry->time = time;
+	if(!bake_opensource(&entry->source, entry->path)) { return(0); }
+    }
+    return(&entry->source);
+}
+internal void
+server_closesources()
+{
+    for(s32 s = 0; s < server.source_count; s++)
+    {
+	bake_closesource(&server.sources[s].source);
+    }
+    server.source_count = 0;
+}
+// bakes one request line into 'reply' (a line, empty = no answer). false when it was 'quit'.
+internal b32
+server_request(s8* line, s32 length, s8* reply, s32 reply_capacity)
+{
+    std::unique_lock<std::mutex> lock(server.mutex);
+    server.requests++;
+    reply[0] = '\0';
+
+    s8  ttf[MAX_PATH];
+    s8  sizes[MAX_PATH];
+    s8  output[MAX_PATH];
+    s8  ranges[MAX_PATH];
+    s8* cursor = line;
+    s8* end    = line + length;
+    if(!bake_manifesttoken(&cursor, end, ttf)) { return(true); } // empty, or a comment.
+
+    if(strcmp(ttf, "quit") == 0)
+    {
+	snprintf(reply, reply_capacity, "bye\n");
+	return(false);
+    }
+
+    r64 start = bake_seconds();
+    s32 job_count = 0;
+    s32 commas    = 0;
+    b32 valid     = bake_manifesttoken(&cursor, end, sizes) && bake_manifesttoken(&cursor, end, output);
+    if(valid)
+    {
+	for(s8* c = sizes; *c; c++) { commas += (*c == ',') ? 1 : 0; }
+	if(!bake_manifesttoken(&cursor, end, ranges))
+	{
+	    mem_copy(bake_ranges, ranges, BAKE_MAX_RANGES);
+	}
+	valid = (commas < SERVER_MAX_JOBS) && (strlen(ranges) < BAKE_MAX_RANGES);
+    }
+    if(valid)
+    {
+	// jobs of a file that can't be opened don't run ('bake_batchjob'), they're answered as failed.
+	bake_source  missing = {};
+	bake_source* source  = server_opensource(ttf);
+	if(!source)
+	{
+	    platform_debugprint("'server_opensource' failed!\n");
+	    missing.path = ttf;
+	    source       = &missing;
+	}
+
+	memset(server.jobs, 0, sizeof(server.jobs));
+	valid = bake_linejobs(source, sizes, output, ranges, server.jobs, &job_count);
+	if(valid)
+	{
+	    bake_runjobs(server.jobs, job_count);
+	    output_wait();
+
+	    s32 baked = 0;
+	    for(s32 j = 0; j < job_count; j++)
+	    {
+		baked += (server.jobs[j].success && server.jobs[j].written) ? 1 : 0;
+	    }
+	    if(bake_report[0])
+	    {
+		bake_writereport(server.jobs, job_count, baked == job_count);
+	    }
+	    snprintf(reply, reply_capacity, "%s %d %d %.3f\n", (baked == job_count) ? "ok" : "failed",
+		     baked, job_count, (bake_seconds() - start) * 1000.0);
+	}
+    }
+    if(!valid)
+    {
+	platform_debugprint("server request is invalid!\n");
+	snprintf(reply, reply_capacity, "invalid\n");
+    }
+    return(true);
+}
+// answers the requests of one connection until it closes. false when it asked the server to quit.
+internal b32
+server_connection(void* connection, server_readfunction* read, server_writefunction* write)
+{
+    s8  line[SERVER_MAX_LINE];
+    s8  reply[64];
+    s32 used   = 0;
+    b32 quit   = false;
+    b32 closed = false;
+    b32 skip   = false; // the rest of a line that was too long.
+    while(!quit && !closed)
+    {
+	s32 size = read(connection, line + used, SERVER_MAX_LINE - used);
+	if(size <= 0)
+	{
+	    closed = true;
+	    if(used == 0 || skip) { break; }
+	    line[used++] = '\n'; // the last line, without one.
+	}
+	else
+	{
+	    used += size;
+	}
+
+	s32 first = 0;
+	for(s32 c = 0; c < used && !quit; c++)
+	{
+	    if(line[c] != '\n') { continue; }
+
+	    if(!skip)
+	    {
+		quit = !server_request(line + first, c - first, reply, sizeof(reply));
+		if(reply[0] && !write(connection, reply, (s32)strlen(reply))) { closed = true; }
+	    }
+	    skip  = false;
+	    first = c + 1;
+	}
+	memmove(line, line + first, used - first); // what's left of the next line.
+	used -= first;
+
+	if(used == SERVER_MAX_LINE)
+	{
+	    if(!skip)
+	    {
+		platform_debugprint("server request is too long!\n");
+		if(!write(connection, "invalid\n", 8)) { closed = true; }
+	    }
+	    skip = true;
+	    used = 0;
+	}
+    }
+    return(!quit);
+}
+// false when the report (-o -) would go to the standard output between the replies (-w -).
+internal b32
+server_startup(s8* address)
+{
+    if(strcmp(address, "-") == 0 && strcmp(bake_report, "-") == 0)
+    {
+	platform_debugprint("'server_startup' failed! (-o - and -w - both write the standard output)\n");
+	return(false);
+    }
+    server.source_count = 0;
+    server.requests     = 0;
+    output_startup();
+    return(true);
+}
+// after every connection is closed.
+internal void
+server_shutdown()
+{
+    output_shutdown();
+    server_closesources();
+}
@@ -0,0 +1,463 @@
+// SIMD
+//
+// The per-pixel loops of a bake, with a scalar, an SSE2 and an AVX2 version of each.
+// 'simd_startup' picks the best level the CPU supports (or a lower one, for comparison),
+// until then (and on anything that isn't x86) the scalar versions are used.
+//
+// Every level produces exactly the same bytes, only the speed differs.
+//
+
+#include <math.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2 // msvc compiles avx2 intrinsics without a flag.
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define SIMD_SCALAR 0
+#define SIMD_SSE2   1
+#define SIMD_AVX2   2
+#define SIMD_BEST   SIMD_AVX2
+
+// bounds of every non-zero byte, left untouched (min = width/height, max = 0) when there are none.
+typedef void simd_bounds_function(u8* pixels, s32 width, s32 height, s32 stride,
+				  s32* min_x, s32* max_x, s32* min_y, s32* max_y);
+// a -> a | a << 8 | a << 16 | a << 24
+typedef void simd_expand_function(u8* source, u32* target, s32 count);
+// |accumulation| clamped to 1 -> 0 -> 255
+typedef void simd_coverage_function(r32* accumulation, u8* target, s32 count);
+typedef void simd_copy_function(void* source, void* target, s32 size);
+// 2x2 box filter, two rows ('stride' apart) -> one, (a + b + c + d + 2) / 4 per byte. 'bytes' per pixel is 1 or 4.
+typedef void simd_halve_function(u8* source, s32 stride, u8* target, s32 count, s32 bytes);
+
+struct simd_kernels
+{
+    s32 level;
+    const s8* name;
+
+    simd_bounds_function*   bounds;
+    simd_expand_function*   expand;
+    simd_coverage_function* coverage;
+    simd_copy_function*     copy;
+    simd_halve_function*    halve;
+};
+
+// scalar.
+internal void
+simd_bounds_scalar(u8* pixels, s32 width, s32 height, s32 stride, s32* min_x, s32* max_x, s32* min_y, s32* max_y)
+{
+    for(s32 y = 0; y < height; y++)
+    {
+	u8* row = pixels + (y * stride);
+	for(s32 x = 0; x < width; x++)
+	{
+	    if(row[x])
+	    {
+		if(x < *min_x) *min_x = x;
+		if(x > *max_x) *max_x = x;
+		if(y < *min_y) *min_y = y;
+		if(y > *max_y) *max_y = y;
+	    }
+	}
+    }
+}
+internal void
+simd_expand_scalar(u8* source, u32* target, s32 count)
+{
+    for(s32 pixel = 0; pixel < count; pixel++)
+    {
+	u32 a = source[pixel];
+	target[pixel] = a | (a << 8) | (a << 16) | (a << 24);
+    }
+}
+internal void
+simd_coverage_scalar(r32* accumulation, u8* target, s32 count)
+{
+    for(s32 pixel = 0; pixel < count; pixel++)
+    {
+	r32 coverage = fabsf(accumulation[pixel]);
+	coverage = (coverage > 1.0f) ? 1.0f : coverage;
+	target[pixel] = (u8)((coverage * 255.0f) + 0.5f);
+    }
+}
+internal void
+simd_copy_scalar(void* source, void* target, s32 size)
+{
+    mem_copy(source, target, size);
+}
+internal void
+simd_halve_scalar(u8* source, s32 stride, u8* target, s32 count, s32 bytes)
+{
+    u8* next = source + stride;
+    for(s32 pixel = 0; pixel < count; pixel++)
+    {
+	for(s32 i = 0; i < bytes; i++)
+	{
+	    s32 a = (pixel * 2 * bytes) + i;
+	    s32 b = a + bytes;
+	    target[(pixel * bytes) + i] = (u8)((source[a] + source[b] + next[a] + next[b] + 2) >> 2);
+	}
+    }
+}
+
+internal s32
+simd_lowbit(u32 mask) // mask != 0
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return((s32)bit);
+#else
+    return(__builtin_ctz(mask));
+#endif
+}
+internal s32
+simd_highbit(u32 mask) // mask != 0
+{
+#if defined(_MSC_VER)
+    unsigned long bit;
+    _BitScanReverse(&bit, mask);
+    return((s32)bit);
+#else
+    return(31 - __builtin_clz(mask));
+#endif
+}
+
+#ifdef SIMD_X86
+// the first and last non-zero column of a row are all the bounds need, rows without any are skipped.
+internal void
+simd_boundsrow(s32 y, s32 first, s32 last, s32* min_x, s32* max_x, s32* min_y, s32* max_y)
+{
+    if(first < *min_x) *min_x = first;
+    if(last  > *max_x) *max_x = last;
+    if(y     < *min_y) *min_y = y;
+    if(y     > *max_y) *max_y = y;
+}
+
+// sse2.
+internal void
+simd_bounds_sse2(u8* pixels, s32 width, s32 height, s32 stride, s32* min_x, s32* max_x, s32* min_y, s32* max_y)
+{
+    __m128i zero = _mm_setzero_si128();
+    for(s32 y = 0; y < height; y++)
+    {
+	u8* row   = pixels + (y * stride);
+	s32 first = -1;
+	s32 last  = -1;
+
+	s32 x = 0;
+	for(; (x + 16) <= width; x += 16)
+	{
+	    u32 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i*)(row + x)), zero)) ^ 0xffff;
+	    if(mask)
+	    {
+		if(first < 0) { first = x + simd_lowbit(mask); }
+		last = x + simd_highbit(mask);
+	    }
+	}
+	for(; x < width; x++)
+	{
+	    if(row[x])
+	    {
+		if(first < 0) { first = x; }
+		last = x;
+	    }
+	}
+	if(first >= 0) { simd_boundsrow(y, first, last, min_x, max_x, min_y, max_y); }
+    }
+}
+internal void
+simd_expand_sse2(u8* source, u32* target, s32 count)
+{
+    s32 pixel = 0;
+    for(; (pixel + 16) <= count; pixel += 16)
+    {
+	__m128i a    = _mm_loadu_si128((__m128i*)(source + pixel));
+	__m128i aa_0 = _mm_unpacklo_epi8(a, a);
+	__m128i aa_1 = _mm_unpackhi_epi8(a, a);
+	_mm_storeu_si128((__m128i*)(target + pixel +  0), _mm_unpacklo_epi16(aa_0, aa_0));
+	_mm_storeu_si128((__m128i*)(target + pixel +  4), _mm_unpackhi_epi16(aa_0, aa_0));
+	_mm_storeu_si128((__m128i*)(target + pixel +  8), _mm_unpacklo_epi16(aa_1, aa_1));
+	_mm_storeu_si128((__m128i*)(target + pixel + 12), _mm_unpackhi_epi16(aa_1, aa_1));
+    }
+    simd_expand_scalar(source + pixel, target + pixel, count - pixel);
+}
+internal void
+simd_coverage_sse2(r32* accumulation, u8* target, s32 count)
+{
+    __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 one  = _mm_set1_ps(1.0f);
+    __m128 full = _mm_set1_ps(255.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+
+    s32 pixel = 0;
+    for(; (pixel + 16) <= count; pixel += 16)
+    {
+	// same operations as the scalar version (truncating convert), so the bytes match.
+	__m128i c[4];
+	for(s32 i = 0; i < 4; i++)
+	{
+	    __m128 coverage = _mm_andnot_ps(sign, _mm_loadu_ps(accumulation + pixel + (i * 4)));
+	    coverage = _mm_min_ps(coverage, one);
+	    c[i] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, full), half));
+	}
+	__m128i c_16 = _mm_packs_epi32(c[0], c[1]);
+	__m128i d_16 = _mm_packs_epi32(c[2], c[3]);
+	_mm_storeu_si128((__m128i*)(target + pixel), _mm_packus_epi16(c_16, d_16));
+    }
+    simd_coverage_scalar(accumulation + pixel, target + pixel, count - pixel);
+}
+internal void
+simd_copy_sse2(void* source, void* target, s32 size)
+{
+    u8* s = (u8*)source;
+    u8* t = (u8*)target;
+    if(size < 16)
+    {
+	for(s32 i = 0; i < size; i++) { t[i] = s[i]; }
+	return;
+    }
+    // the last block overlaps the one before it instead of a scalar tail.
+    s32 i = 0;
+    for(; (i + 16) <= size; i += 16)
+    {
+	_mm_storeu_si128((__m128i*)(t + i), _mm_loadu_si128((__m128i*)(s + i)));
+    }
+    if(i < size)
+    {
+	_mm_storeu_si128((__m128i*)(t + size - 16), _mm_loadu_si128((__m128i*)(s + size - 16)));
+    }
+}
+internal void
+simd_halve_sse2(u8* source, s32 stride, u8* target, s32 count, s32 bytes)
+{
+    __m128i low_bytes = _mm_set1_epi16(0x00ff);
+    __m128i round     = _mm_set1_epi16(2);
+    __m128i zero      = _mm_setzero_si128();
+    u8*     next      = source + stride;
+
+    s32 pixel = 0;
+    if(bytes == 1)
+    {
+	// 16 pixels from 32 of each row: even + odd bytes in 16-bit lanes.
+	for(; (pixel + 16) <= count; pixel += 16)
+	{
+	    __m128i sum[2];
+	    for(s32 i = 0; i < 2; i++)
+	    {
+		__m128i a = _mm_loadu_si128((__m128i*)(source + (pixel * 2) + (i * 16)));
+		__m128i b = _mm_loadu_si128((__m128i*)(next   + (pixel * 2) + (i * 16)));
+		__m128i a_16 = _mm_add_epi16(_mm_and_si128(a, low_bytes), _mm_srli_epi16(a, 8));
+		__m128i b_16 = _mm_add_epi16(_mm_and_si128(b, low_bytes), _mm_srli_epi16(b, 8));
+		sum[i] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(a_16, b_16), round), 2);
+	    }
+	    _mm_storeu_si128((__m128i*)(target + pixel), _mm_packus_epi16(sum[0], sum[1]));
+	}
+    }
+    else
+    {
+	// 4 pixels from 8 of each row: a pair of pixels per register, the halves added together.
+	for(; (pixel + 4) <= count; pixel += 4)
+	{
+	    __m128i sum[2];
+	    for(s32 i = 0; i < 2; i++)
+	    {
+		__m128i a = _mm_loadu_si128((__m128i*)(source + (pixel * 8) + (i * 16)));
+		__m128i b = _mm_loadu_si128((__m128i*)(next   + (pixel * 8) + (i * 16)));
+		__m128i low  = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		__m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		low  = _mm_add_epi16(low,  _mm_srli_si128(low,  8));
+		high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+		sum[i] = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(low, high), round), 2);
+	    }
+	    _mm_storeu_si128((__m128i*)(target + (pixel * 4)), _mm_packus_epi16(sum[0], sum[1]));
+	}
+    }
+    simd_halve_scalar(source + (pixel * 2 * bytes), stride, target + (pixel * bytes), count - pixel, bytes);
+}
+
+// avx2.
+SIMD_TARGET_AVX2 internal void
+simd_bounds_avx2(u8* pixels, s32 width, s32 height, s32 stride, s32* min_x, s32* max_x, s32* min_y, s32* max_y)
+{
+    __m256i zero = _mm256_setzero_si256();
+    for(s32 y = 0; y < height; y++)
+    {
+	u8* row   = pixels + (y * stride);
+	s32 first = -1;
+	s32 last  = -1;
+
+	s32 x = 0;
+	for(; (x + 32) <= width; x += 32)
+	{
+	    u32 mask = ~(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i*)(row + x)), zero));
+	    if(mask)
+	    {
+		if(first < 0) { first = x + simd_lowbit(mask); }
+		last = x + simd_highbit(mask);
+	    }
+	}
+	for(; x < width; x++)
+	{
+	    if(row[x])
+	    {
+		if(first < 0) { first = x; }
+		last = x;
+	    }
+	}
+	if(first >= 0) { simd_boundsrow(y, first, last, min_x, max_x, min_y, max_y); }
+    }
+}
+SIMD_TARGET_AVX2 internal void
+simd_expand_avx2(u8* source, u32* target, s32 count)
+{
+    __m256i spread = _mm256_set1_epi32(0x01010101);
+
+    s32 pixel = 0;
+    for(; (pixel + 16) <= count; pixel += 16)
+    {
+	__m128i a = _mm_loadu_si128((__m128i*)(source + pixel));
+	__m256i low  = _mm256_cvtepu8_epi32(a);
+	__m256i high = _mm256_cvtepu8_epi32(_mm_srli_si128(a, 8));
+	_mm256_storeu_si256((__m256i*)(target + pixel + 0), _mm256_mullo_epi32(low,  spread));
+	_mm256_storeu_si256((__m256i*)(target + pixel + 8), _mm256_mullo_epi32(high, spread));
+    }
+    simd_expand_scalar(source + pixel, target + pixel, count - pixel);
+}
+SIMD_TARGET_AVX2 internal void
+simd_coverage_avx2(r32* accumulation, u8* target, s32 count)
+{
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 one  = _mm256_set1_ps(1.0f);
+    __m256 full = _mm256_set1_ps(255.0f);
+    __m256 half = _mm256_set1_ps(0.5f);
+
+    s32 pixel = 0;
+    for(; (pixel + 32) <= count; pixel += 32)
+    {
+	__m256i c[4];
+	for(s32 i = 0; i < 4; i++)
+	{
+	    __m256 coverage = _mm256_andnot_ps(sign, _mm256_loadu_ps(accumulation + pixel + (i * 8)));
+	    coverage = _mm256_min_ps(coverage, one);
+	    c[i] = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(coverage, full), half));
+	}
+	// packs work per 128-bit lane, the permute puts the dwords back in order.
+	__m256i c_16 = _mm256_packs_epi32(c[0], c[1]);
+	__m256i d_16 = _mm256_packs_epi32(c[2], c[3]);
+	__m256i c_8  = _mm256_packus_epi16(c_16, d_16);
+	c_8 = _mm256_permutevar8x32_epi32(c_8, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+	_mm256_storeu_si256((__m256i*)(target + pixel), c_8);
+    }
+    simd_coverage_sse2(accumulation + pixel, target + pixel, count - pixel);
+}
+SIMD_TARGET_AVX2 internal void
+simd_copy_avx2(void* source, void* target, s32 size)
+{
+    u8* s = (u8*)source;
+    u8* t = (u8*)target;
+    if(size < 32)
+    {
+	simd_copy_sse2(source, target, size);
+	return;
+    }
+    s32 i = 0;
+    for(; (i + 32) <= size; i += 32)
+    {
+	_mm256_storeu_si256((__m256i*)(t + i), _mm256_loadu_si256((__m256i*)(s + i)));
+    }
+    if(i < size)
+    {
+	_mm256_storeu_si256((__m256i*)(t + size - 32), _mm256_loadu_si256((__m256i*)(s + size - 32)));
+    }
+}
+SIMD_TARGET_AVX2 internal void
+simd_halve_avx2(u8* source, s32 stride, u8* target, s32 count, s32 bytes)
+{
+    if(bytes != 1)
+    {
+	simd_halve_sse2(source, stride, target, count, bytes);
+	return;
+    }
+
+    __m256i low_bytes = _mm256_set1_epi16(0x00ff);
+    __m256i round     = _mm256_set1_epi16(2);
+    u8*     next      = source + stride;
+
+    s32 pixel = 0;
+    for(; (pixel + 32) <= count; pixel += 32)
+    {
+	__m256i sum[2];
+	for(s32 i = 0; i < 2; i++)
+	{
+	    __m256i a = _mm256_loadu_si256((__m256i*)(source + (pixel * 2) + (i * 32)));
+	    __m256i b = _mm256_loadu_si256((__m256i*)(next   + (pixel * 2) + (i * 32)));
+	    __m256i a_16 = _mm256_add_epi16(_mm256_and_si256(a, low_bytes), _mm256_srli_epi16(a, 8));
+	    __m256i b_16 = _mm256_add_epi16(_mm256_and_si256(b, low_bytes), _mm256_srli_epi16(b, 8));
+	    sum[i] = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(a_16, b_16), round), 2);
+	}
+	// packus works per 128-bit lane, the permute puts the quadwords back in order.
+	__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum[0], sum[1]), 0xd8);
+	_mm256_storeu_si256((__m256i*)(target + pixel), packed);
+    }
+    simd_halve_sse2(source + (pixel * 2), stride, target + pixel, count - pixel, bytes);
+}
+
+internal b32
+simd_hasavx2()
+{
+#if defined(_MSC_VER)
+    s32 info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) { return(false); }
+
+    __cpuid(info, 1);
+    b32 os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6); // osxsave, avx
+    __cpuidex(info, 7, 0);
+    return(os_saves_ymm && (info[1] & (1 << 5)));
+#else
+    __builtin_cpu_init();
+    return(__builtin_cpu_supports("avx2"));
+#endif
+}
+#endif
+
+global simd_kernels simd =
+{
+    SIMD_SCALAR, "scalar",
+    simd_bounds_scalar, simd_expand_scalar, simd_coverage_scalar, simd_copy_scalar, simd_halve_scalar,
+};
+
+// picks 'level' or the best level below it that the cpu supports, returns the level picked.
+internal s32
+simd_startup(s32 level)
+{
+    simd_kernels kernels =
+    {
+	SIMD_SCALAR, "scalar",
+	simd_bounds_scalar, simd_expand_scalar, simd_coverage_scalar, simd_copy_scalar, simd_halve_scalar,
+    };
+
+#ifdef SIMD_X86
+    // sse2 is part of x86-64 (and every x86 cpu this will ever see).
+    if(level >= SIMD_SSE2)
+    {
+	kernels = { SIMD_SSE2, "sse2", simd_bounds_sse2, simd_expand_sse2, simd_coverage_sse2, simd_copy_sse2, simd_halve_sse2 };
+    }
+    if(level >= SIMD_AVX2 && simd_hasavx2())
+    {
+	kernels = { SIMD_AVX2, "avx2", simd_bounds_avx2, simd_expand_avx2, simd_coverage_avx2, simd_copy_avx2, simd_halve_avx2 };
+    }
+#endif
+
+    simd = kernels;
+    return(simd.level);
+}
@@ -0,0 +1,1146 @@
+// TrueType
+//
+// A small, read-only TrueType backend. Only what the baker needs is decoded:
+//
+// 'head' - units per em, loca format.
+// 'maxp' - glyph count, worst case point and contour counts (scratch sizes).
+// 'hhea' - number of horizontal metrics, ascent/descent fallback.
+// 'hmtx' - advance width, left side bearing.
+// 'OS/2' - windows ascent/descent (these are what GDI reports as tmAscent/tmDescent).
+// 'cmap' - codepoint -> glyph index (formats 0, 4, 6 and 12).
+// 'loca' - glyph index -> 'glyf' offset.
+// 'glyf' - simple and compound outlines (quadratic b-splines).
+// 'name' - family and style names.
+// 'GPOS' - pair adjustments of the 'kern' feature (lookup type 2, and 9 wrapping it), x advance only.
+// 'kern' - format 0 pairs, when GPOS has no kerning (shapers ignore 'kern' then too).
+//
+// All values in the file are big-endian.
+//
+// The file is never written to (it's mapped read-only). The table directory is read once by
+// 'ttf_loadfont', every table is checked to lie within the file and everything after that reads
+// through the table it belongs to ('ttf_tableu16' and friends return 0 past the end of it), so a
+// malformed font bakes missing glyphs rather than reading out of bounds.
+//
+// The rasterizer accumulates signed area and cover per pixel (analytic coverage, no supersampling),
+// outlines are flattened into lines first. The accumulation is prefix summed into 8-bit coverage.
+//
+// Surfaces are bottom-up (row 0 is the bottom row), just like the bottom-up DIB GDI used to draw into.
+//
+
+#include <math.h>
+
+#define TTF_TAG(a, b, c, d) (((u32)(a) << 24) | ((u32)(b) << 16) | ((u32)(c) << 8) | (u32)(d))
+
+// 'ttf_font.tables'.
+#define TTF_TABLE_HEAD  0
+#define TTF_TABLE_MAXP  1
+#define TTF_TABLE_HHEA  2
+#define TTF_TABLE_HMTX  3
+#define TTF_TABLE_OS2   4
+#define TTF_TABLE_CMAP  5
+#define TTF_TABLE_LOCA  6
+#define TTF_TABLE_GLYF  7
+#define TTF_TABLE_NAME  8
+#define TTF_TABLE_KERN  9
+#define TTF_TABLE_GPOS  10
+#define TTF_TABLE_COUNT 11
+
+// name ids, see 'bake_fontname' (atlas_baked.cpp).
+#define TTF_NAME_FAMILY    1
+#define TTF_NAME_STYLE     2
+#define TTF_NAME_FULL      4
+
+#define TTF_ON_CURVE          0x01
+#define TTF_X_SHORT           0x02
+#define TTF_Y_SHORT           0x04
+#define TTF_REPEAT            0x08
+#define TTF_X_SAME_OR_POSITIVE 0x10
+#define TTF_Y_SAME_OR_POSITIVE 0x20
+
+#define TTF_ARG_1_AND_2_ARE_WORDS    0x0001
+#define TTF_ARGS_ARE_XY_VALUES       0x0002
+#define TTF_WE_HAVE_A_SCALE          0x0008
+#define TTF_MORE_COMPONENTS          0x0020
+#define TTF_WE_HAVE_AN_X_AND_Y_SCALE 0x0040
+#define TTF_WE_HAVE_A_TWO_BY_TWO     0x0080
+
+#define TTF_MAX_COMPOUND_DEPTH 8
+
+// GPOS value records, the fields that are there in this order.
+#define TTF_VALUE_X_PLACEMENT 0x0001
+#define TTF_VALUE_Y_PLACEMENT 0x0002
+#define TTF_VALUE_X_ADVANCE   0x0004
+
+#define TTF_LOOKUP_PAIR      2
+#define TTF_LOOKUP_EXTENSION 9
+
+struct ttf_table
+{
+    u32 offset; // from the start of the file.
+    u32 size;   // 0 = the font doesn't have it.
+};
+struct ttf_font
+{
+    u8* data; // read-only.
+    u32 size;
+
+    ttf_table tables[TTF_TABLE_COUNT];
+    ttf_table cmap; // the chosen encoding subtable, up to the end of 'cmap'.
+
+    s32 glyph_count;
+    s32 hmetrics_count;
+    s32 index_format;    // 0 = short (u16 * 2), 1 = long (u32).
+    s32 units_per_em;
+
+    s32 ascent;  // font units, above the baseline.
+    s32 descent; // font units, below the baseline (positive).
+
+    s32 max_points;   // worst case for a single (simple or compound) glyph.
+    s32 max_contours;
+
+    b32 symbol; // (3,0) symbol fonts map their characters into 0xf000 -> 0xf0ff.
+};
+struct ttf_point
+{
+    r32 x;
+    r32 y;
+    b32 on_curve;
+};
+struct ttf_outline
+{
+    ttf_point* points;
+    s32*       contour_ends; // index of the last point of each contour.
+    s32        point_count;
+    s32        contour_count;
+
+    s32 point_capacity;
+    s32 contour_capacity;
+
+    // bounding box (font units).
+    s32 x_min;
+    s32 y_min;
+    s32 x_max;
+    s32 y_max;
+};
+struct ttf_hmetrics
+{
+    s32 advance;
+    s32 left_bearing;
+};
+struct ttf_kernpair
+{
+    u16 first;  // glyph indices.
+    u16 second;
+    s16 value;  // font units, added to the advance of 'first'.
+    u16 table;  // the lookup (or 'kern' subtable) it's from. within one the first pair found wins, different ones add up.
+};
+
+// big-endian.
+internal u16 ttf_u16(u8* p) { return((u16)((p[0] << 8) | p[1])); }
+internal s16 ttf_s16(u8* p) { return((s16)((p[0] << 8) | p[1])); }
+internal u32 ttf_u32(u8* p) { return(((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3]); }
+
+// bounds-checked, 'offset' is from the start of 'table'.
+internal b32 ttf_inside(ttf_table table, u64 offset, u64 size) { return((offset + size) <= table.size); }
+internal u16 ttf_tableu16(ttf_font* font, ttf_table table, u64 offset) { return(ttf_inside(table, offset, 2) ? ttf_u16(font->data + table.offset + offset) : 0); }
+internal s16 ttf_tables16(ttf_font* font, ttf_table table, u64 offset) { return(ttf_inside(table, offset, 2) ? ttf_s16(font->data + table.offset + offset) : 0); }
+internal u32 ttf_tableu32(ttf_font* font, ttf_table table, u64 offset) { return(ttf_inside(table, offset, 4) ? ttf_u32(font->data + table.offset + offset) : 0); }
+
+// the part of 'table' from 'offset' on (empty past its end).
+internal ttf_table
+ttf_subtable(ttf_table table, u64 offset)
+{
+    ttf_table subtable = {};
+    if(offset < table.size)
+    {
+	subtable.offset = table.offset + (u32)offset;
+	subtable.size   = table.size   - (u32)offset;
+    }
+    return(subtable);
+}
+// reads the table directory once, tables that don't fit in the file are left out.
+internal b32
+ttf_indextables(ttf_font* font)
+{
+    const u32 tags[TTF_TABLE_COUNT] =
+    {
+	TTF_TAG('h','e','a','d'), TTF_TAG('m','a','x','p'), TTF_TAG('h','h','e','a'), TTF_TAG('h','m','t','x'),
+	TTF_TAG('O','S','/','2'), TTF_TAG('c','m','a','p'), TTF_TAG('l','o','c','a'), TTF_TAG('g','l','y','f'),
+	TTF_TAG('n','a','m','e'), TTF_TAG('k','e','r','n'), TTF_TAG('G','P','O','S'),
+    };
+
+    ttf_table file = { 0, font->size };
+    s32 table_count = ttf_tableu16(font, file, 4);
+    if(!ttf_inside(file, 12, (u64)table_count * 16)) { return(false); }
+
+    for(s32 record = 0; record < table_count; record++)
+    {
+	u32 tag    = ttf_tableu32(font, file, 12 + (record * 16));
+	u32 offset = ttf_tableu32(font, file, 12 + (record * 16) + 8);
+	u32 size   = ttf_tableu32(font, file, 12 + (record * 16) + 12);
+	if(size == 0 || !ttf_inside(file, offset, size)) { continue; }
+
+	for(s32 table = 0; table < TTF_TABLE_COUNT; table++)
+	{
+	    if(tags[table] == tag && font->tables[table].size == 0)
+	    {
+		font->tables[table].offset = offset;
+		font->tables[table].size   = size;
+	    }
+	}
+    }
+    return(true);
+}
+internal b32
+ttf_loadfont(ttf_font* font, void* data, u32 size)
+{
+    *font = {};
+    font->data = (u8*)data;
+    font->size = size;
+
+    if(size < 12) { return(false); }
+
+    u32 version = ttf_u32(font->data);
+    if(version != 0x00010000 && version != TTF_TAG('t','r','u','e'))
+    {
+	return(false); // 'OTTO' (CFF outlines) and collections are not supported.
+    }
+    if(!ttf_indextables(font)) { return(false); }
+
+    ttf_table head = font->tables[TTF_TABLE_HEAD];
+    ttf_table maxp = font->tables[TTF_TABLE_MAXP];
+    ttf_table hhea = font->tables[TTF_TABLE_HHEA];
+    ttf_table os2  = font->tables[TTF_TABLE_OS2];
+    ttf_table cmap = font->tables[TTF_TABLE_CMAP];
+    if(!font->tables[TTF_TABLE_LOCA].size || !font->tables[TTF_TABLE_GLYF].size || !font->tables[TTF_TABLE_HMTX].size) { return(false); }
+    if(head.size < 54 || maxp.size < 6 || hhea.size < 36 || cmap.size < 4)                                            { return(false); }
+
+    font->units_per_em   = ttf_tableu16(font, head, 18);
+    font->index_format   = ttf_tables16(font, head, 50);
+    font->glyph_count    = ttf_tableu16(font, maxp, 4);
+    font->hmetrics_count = ttf_tableu16(font, hhea, 34);
+
+    if(font->units_per_em == 0 || font->hmetrics_count == 0) { return(false); }
+    if(!ttf_inside(font->tables[TTF_TABLE_LOCA], 0, (u64)(font->glyph_count + 1) * (font->index_format ? 4 : 2))) { return(false); }
+    if(!ttf_inside(font->tables[TTF_TABLE_HMTX], 0, (u64)font->hmetrics_count * 4))                               { return(false); }
+
+    // maxp version 1.0 carries the worst case sizes, version 0.5 (cff) does not.
+    if(maxp.size >= 14)
+    {
+	s32 points             = ttf_tableu16(font, maxp, 6);
+	s32 contours           = ttf_tableu16(font, maxp, 8);
+	s32 compound_points    = ttf_tableu16(font, maxp, 10);
+	s32 compound_contours  = ttf_tableu16(font, maxp, 12);
+	font->max_points   = (points   > compound_points  ) ? points   : compound_points;
+	font->max_contours = (contours > compound_contours) ? contours : compound_contours;
+    }
+    if(font->max_points   < 256) { font->max_points   = 256; }
+    if(font->max_contours <  64) { font->max_contours =  64; }
+
+    // GDI reports usWinAscent/usWinDescent, hhea is the fallback.
+    if(os2.size >= 78)
+    {
+	font->ascent  = ttf_tableu16(font, os2, 74);
+	font->descent = ttf_tableu16(font, os2, 76);
+    }
+    else
+    {
+	font->ascent  =  ttf_tables16(font, hhea, 4);
+	font->descent = -ttf_tables16(font, hhea, 6);
+    }
+
+    // encoding: prefer full unicode (3,10)/(0,4+), then unicode bmp (3,1)/(0,*), then symbol (3,0).
+    s32 best = 0;
+    s32 encoding_count = ttf_tableu16(font, cmap, 2);
+    for(s32 encoding = 0; encoding < encoding_count; encoding++)
+    {
+	u32 record = 4 + (encoding * 8);
+	if(!ttf_inside(cmap, record, 8)) { break; }
+
+	u16       platform_id = ttf_tableu16(font, cmap, record);
+	u16       encoding_id = ttf_tableu16(font, cmap, record + 2);
+	ttf_table subtable    = ttf_subtable(cmap, ttf_tableu32(font, cmap, record + 4));
+	if(subtable.size < 4) { continue; }
+
+	s32 rank = 0;
+	if(platform_id == 3 && encoding_id == 10) { rank = 4; }
+	if(platform_id == 0 && encoding_id >= 4)  { rank = 4; }
+	if(platform_id == 3 && encoding_id == 1)  { rank = 3; }
+	if(platform_id == 0 && encoding_id <  4)  { rank = 3; }
+	if(platform_id == 3 && encoding_id == 0)  { rank = 2; }
+
+	if(rank > best)
+	{
+	    best         = rank;
+	    font->cmap   = subtable;
+	    font->symbol = (rank == 2);
+	}
+    }
+    return(font->cmap.size != 0);
+}
+internal s32
+ttf_glyphindex_(ttf_font* font, u32 codepoint)
+{
+    ttf_table table  = font->cmap;
+    u16       format = ttf_tableu16(font, table, 0);
+    u8*       data   = font->data + table.offset;
+
+    if(format == 0)
+    {
+	if(codepoint < 256 && ttf_inside(table, 6, 256)) { return(data[6 + codepoint]); }
+    }
+    else if(format == 4)
+    {
+	u32 segments    = ttf_tableu16(font, table, 6) / 2;
+	u32 end_codes   = 14;
+	u32 start_codes = end_codes + (segments * 2) + 2;
+	u32 deltas      = start_codes + (segments * 2);
+	u32 ranges      = deltas + (segments * 2);
+	if(!ttf_inside(table, ranges, segments * 2) || codepoint > 0xffff) { return(0); }
+
+	// binary search for the first segment whose end code is >= codepoint.
+	u32 low  = 0;
+	u32 high = segments;
+	while(low < high)
+	{
+	    u32 middle = (low + high) / 2;
+	    if(ttf_u16(data + end_codes + (middle * 2)) < codepoint) { low  = middle + 1; }
+	    else                                                     { high = middle;     }
+	}
+	if(low < segments)
+	{
+	    u32 start = ttf_u16(data + start_codes + (low * 2));
+	    if(codepoint >= start)
+	    {
+		u16 delta = ttf_u16(data + deltas + (low * 2));
+		u16 range = ttf_u16(data + ranges + (low * 2));
+		if(range == 0)
+		{
+		    return((u16)(codepoint + delta));
+		}
+		u16 index = ttf_tableu16(font, table, (u64)ranges + (low * 2) + range + ((codepoint - start) * 2));
+		return(index ? (u16)(index + delta) : 0);
+	    }
+	}
+    }
+    else if(format == 6)
+    {
+	u32 first = ttf_tableu16(font, table, 6);
+	u32 count = ttf_tableu16(font, table, 8);
+	if(codepoint >= first && codepoint < (first + count))
+	{
+	    return(ttf_tableu16(font, table, 10 + ((codepoint - first) * 2)));
+	}
+    }
+    else if(format == 12)
+    {
+	u32 groups = ttf_tableu32(font, table, 12);
+	if(!ttf_inside(table, 16, (u64)groups * 12)) { return(0); }
+
+	u32 low  = 0;
+	u32 high = groups;
+	while(low < high)
+	{
+	    u32 middle = low + ((high - low) / 2);
+	    u8* group  = data + 16 + ((u64)middle * 12);
+	    u32 start  = ttf_u32(group);
+	    u32 stop   = ttf_u32(group + 4);
+	    if(codepoint < start)     { high = middle;     }
+	    else if(codepoint > stop) { low  = middle + 1; }
+	    else
+	    {
+		u32 index = ttf_u32(group + 8) + (codepoint - start);
+		return((index < 0x10000) ? (s32)index : 0);
+	    }
+	}
+    }
+    return(0);
+}
+// 0 (the missing glyph) for codepoints the font doesn't map, or maps past its last glyph.
+internal s32
+ttf_glyphindex(ttf_font* font, u32 codepoint)
+{
+    if(font->symbol && codepoint < 256)
+    {
+	codepoint |= 0xf000;
+    }
+
+    s32 glyph = ttf_glyphindex_(font, codepoint);
+    return((glyph < font->glyph_count) ? glyph : 0);
+}
+internal ttf_hmetrics
+ttf_glyphhmetrics(ttf_font* font, s32 glyph)
+{
+    ttf_hmetrics metrics = {};
+    ttf_table    hmtx    = font->tables[TTF_TABLE_HMTX];
+    if(glyph < 0) { return(metrics); }
+
+    if(glyph < font->hmetrics_count)
+    {
+	metrics.advance      = ttf_tableu16(font, hmtx, (u64)glyph * 4);
+	metrics.left_bearing = ttf_tables16(font, hmtx, ((u64)glyph * 4) + 2);
+    }
+    else
+    {
+	// monospaced tail: the last advance repeats, bearings follow the long metrics.
+	metrics.advance      = ttf_tableu16(font, hmtx, (u64)(font->hmetrics_count - 1) * 4);
+	metrics.left_bearing = ttf_tables16(font, hmtx, ((u64)font->hmetrics_count * 4) + ((u64)(glyph - font->hmetrics_count) * 2));
+    }
+    return(metrics);
+}
+// kerning.
+internal void
+ttf_addkernpair(ttf_kernpair* pairs, s32 capacity, s32* count, u16 first, u16 second, s16 value, u16 table)
+{
+    if(value == 0) { return; }
+    if(*count < capacity)
+    {
+	pairs[*count] = { first, second, value, table };
+    }
+    (*count)++;
+}
+// index of 'glyph' in a coverage table, -1 when it isn't covered.
+internal s32
+ttf_coverageindex(ttf_font* font, ttf_table coverage, u16 glyph)
+{
+    u16 format = ttf_tableu16(font, coverage, 0);
+    u32 count  = ttf_tableu16(font, coverage, 2);
+    u32 size   = (format == 1) ? 2 : 6; // a glyph, or a range (start, end, first index).
+    if((format != 1 && format != 2) || !ttf_inside(coverage, 4, (u64)count * size)) { return(-1); }
+
+    // first entry that ends at or after 'glyph'.
+    u32 low  = 0;
+    u32 high = count;
+    while(low < high)
+    {
+	u32 middle = (low + high) / 2;
+	u16 end    = ttf_tableu16(font, coverage, 4 + (middle * size) + ((format == 1) ? 0 : 2));
+	if(end < glyph) { low  = middle + 1; }
+	else            { high = middle;     }
+    }
+    if(low == count) { return(-1); }
+
+    u16 start = ttf_tableu16(font, coverage, 4 + (low * size));
+    if(format == 1)
+    {
+	return((start == glyph) ? (s32)low : -1);
+    }
+    return((start <= glyph) ? (s32)ttf_tableu16(font, coverage, 4 + (low * size) + 4) + (glyph - start) : -1);
+}
+// class of 'glyph' in a class definition table, 0 for the glyphs it doesn't list.
+internal u16
+ttf_glyphclass(ttf_font* font, ttf_table classes, u16 glyph)
+{
+    u16 format = ttf_tableu16(font, classes, 0);
+    if(format == 1)
+    {
+	u16 start = ttf_tableu16(font, classes, 2);
+	u16 count = ttf_tableu16(font, classes, 4);
+	return((glyph >= start && glyph < (start + count)) ? ttf_tableu16(font, classes, 6 + ((glyph - start) * 2)) : 0);
+    }
+    else if(format == 2)
+    {
+	u32 count = ttf_tableu16(font, classes, 2);
+	if(!ttf_inside(classes, 4, (u64)count * 6)) { return(0); }
+
+	u32 low  = 0;
+	u32 high = count;
+	while(low < high)
+	{
+	    u32 middle = (low + high) / 2;
+	    if(ttf_tableu16(font, classes, 4 + (middle * 6) + 2) < glyph) { low  = middle + 1; }
+	    else                                                          { high = middle;     }
+	}
+	if(low < count && ttf_tableu16(font, classes, 4 + (low * 6)) <= glyph)
+	{
+	    return(ttf_tableu16(font, classes, 4 + (low * 6) + 4));
+	}
+    }
+    return(0);
+}
+internal u32
+ttf_valuesize(u16 value_format)
+{
+    u32 size = 0;
+    for(u32 bit = 0; bit < 8; bit++)
+    {
+	size += (value_format >> bit) & 1;
+    }
+    return(size * 2);
+}
+// one pair adjustment subtable (format 1, pairs of glyphs, or 2, pairs of classes).
+// 'scratch' is 3 * 'glyph_count' entries.
+internal void
+ttf_pairadjustment(ttf_font* font, ttf_table table, u8* wanted, u16* glyphs, s32 glyph_count, u16* scratch, u16 lookup,
+		   ttf_kernpair* pairs, s32 capacity, s32* count)
+{
+    u16       format        = ttf_tableu16(font, table, 0);
+    ttf_table coverage      = ttf_subtable(table, ttf_tableu16(font, table, 2));
+    u16       value_format1 = ttf_tableu16(font, table, 4);
+    u16       value_format2 = ttf_tableu16(font, table, 6);
+    if(!(value_format1 & TTF_VALUE_X_ADVANCE)) { return; }
+
+    u32 size1   = ttf_valuesize(value_format1);
+    u32 size2   = ttf_valuesize(value_format2);
+    u32 advance = ttf_valuesize(value_format1 & (TTF_VALUE_X_PLACEMENT | TTF_VALUE_Y_PLACEMENT)); // into the first record.
+
+    if(format == 1)
+    {
+	// a set of (second glyph, records) for every covered first glyph.
+	u32 set_count   = ttf_tableu16(font, table, 8);
+	u32 record_size = 2 + size1 + size2;
+	for(s32 f = 0; f < glyph_count; f++)
+	{
+	    s32 index = ttf_coverageindex(font, coverage, glyphs[f]);
+	    if(index < 0 || (u32)index >= set_count) { continue; }
+
+	    ttf_table set         = ttf_subtable(table, ttf_tableu16(font, table, 10 + (index * 2)));
+	    u32       value_count = ttf_tableu16(font, set, 0);
+	    if(!ttf_inside(set, 2, (u64)value_count * record_size)) { continue; }
+
+	    for(u32 v = 0; v < value_count; v++)
+	    {
+		u32 record = 2 + (v * record_size);
+		u16 second = ttf_tableu16(font, set, record);
+		if(second < font->glyph_count && wanted[second])
+		{
+		    ttf_addkernpair(pairs, capacity, count, glyphs[f], second, ttf_tables16(font, set, record + 2 + advance), lookup);
+		}
+	    }
+	}
+    }
+    else if(format == 2)
+    {
+	ttf_table classes1     = ttf_subtable(table, ttf_tableu16(font, table, 8));
+	ttf_table classes2     = ttf_subtable(table, ttf_tableu16(font, table, 10));
+	u32       class1_count = ttf_tableu16(font, table, 12);
+	u32       class2_count = ttf_tableu16(font, table, 14);
+	u32       record_size  = size1 + size2;
+	if(!ttf_inside(table, 16, (u64)class1_count * class2_count * record_size)) { return; }
+
+	// the second glyphs by class: the ones of class 0 (everything the table doesn't list, usually not
+	// kerned at all) apart from the rest, so a big glyph set costs nothing for it.
+	u16* classes  = scratch;
+	u16* listed   = scratch + glyph_count;
+	u16* unlisted = scratch + (glyph_count * 2);
+	s32 listed_count   = 0;
+	s32 unlisted_count = 0;
+	for(s32 g = 0; g < glyph_count; g++)
+	{
+	    classes[g] = ttf_glyphclass(font, classes2, glyphs[g]);
+	    if(classes[g] >= class2_count) { continue; }
+	    if(classes[g]) { listed  [listed_count++]   = (u16)g; }
+	    else           { unlisted[unlisted_count++] = (u16)g; }
+	}
+
+	for(s32 f = 0; f < glyph_count; f++)
+	{
+	    if(ttf_coverageindex(font, coverage, glyphs[f]) < 0) { continue; }
+
+	    u32 class1 = ttf_glyphclass(font, classes1, glyphs[f]);
+	    if(class1 >= class1_count) { continue; }
+
+	    u32 row = 16 + (class1 * class2_count * record_size) + advance;
+	    for(s32 l = 0; l < listed_count; l++)
+	    {
+		s32 s = listed[l];
+		ttf_addkernpair(pairs, capacity, count, glyphs[f], glyphs[s], ttf_tables16(font, table, row + (classes[s] * record_size)), lookup);
+	    }
+	    if(ttf_tables16(font, table, row))
+	    {
+		for(s32 u = 0; u < unlisted_count; u++)
+		{
+		    ttf_addkernpair(pairs, capacity, count, glyphs[f], glyphs[unlisted[u]], ttf_tables16(font, table, row), lookup);
+		}
+	    }
+	}
+    }
+}
+// every lookup of every 'kern' feature (of any script and language), in lookup order. false when there are none.
+internal b32
+ttf_gposkerning(ttf_font* font, u8* wanted, u16* glyphs, s32 glyph_count, u16* scratch, ttf_kernpair* pairs, s32 capacity, s32* count)
+{
+    ttf_table gpos = font->tables[TTF_TABLE_GPOS];
+    if(ttf_tableu16(font, gpos, 0) != 1) { return(false); }
+
+    ttf_table features = ttf_subtable(gpos, ttf_tableu16(font, gpos, 6));
+    ttf_table lookups  = ttf_subtable(gpos, ttf_tableu16(font, gpos, 8));
+
+    u8  kern_lookups[65536 / 8] = {};
+    b32 found = false;
+    u32 feature_count = ttf_tableu16(font, features, 0);
+    for(u32 f = 0; f < feature_count; f++)
+    {
+	u32 record = 2 + (f * 6);
+	if(!ttf_inside(features, record, 6)) { break; }
+	if(ttf_tableu32(font, features, record) != TTF_TAG('k','e','r','n')) { continue; }
+
+	ttf_table feature     = ttf_subtable(features, ttf_tableu16(font, features, record + 4));
+	u32       index_count = ttf_tableu16(font, feature, 2);
+	for(u32 i = 0; i < index_count && ttf_inside(feature, 4 + (i * 2), 2); i++)
+	{
+	    u16 lookup = ttf_tableu16(font, feature, 4 + (i * 2));
+	    kern_lookups[lookup / 8] |= (u8)(1 << (lookup % 8));
+	    found = true;
+	}
+    }
+
+    u32 lookup_count = ttf_tableu16(font, lookups, 0);
+    for(u32 l = 0; l < lookup_count; l++)
+    {
+	if(!(kern_lookups[l / 8] & (1 << (l % 8)))) { continue; }
+
+	ttf_table lookup         = ttf_subtable(lookups, ttf_tableu16(font, lookups, 2 + (l * 2)));
+	u16       type           = ttf_tableu16(font, lookup, 0);
+	u32       subtable_count = ttf_tableu16(font, lookup, 4);
+	for(u32 s = 0; s < subtable_count; s++)
+	{
+	    ttf_table subtable = ttf_subtable(lookup, ttf_tableu16(font, lookup, 6 + (s * 2)));
+	    if(type == TTF_LOOKUP_EXTENSION)
+	    {
+		if(ttf_tableu16(font, subtable, 2) != TTF_LOOKUP_PAIR) { continue; }
+		subtable = ttf_subtable(subtable, ttf_tableu32(font, subtable, 4));
+	    }
+	    else if(type != TTF_LOOKUP_PAIR)
+	    {
+		break;
+	    }
+	    ttf_pairadjustment(font, subtable, wanted, glyphs, glyph_count, scratch, (u16)l, pairs, capacity, count);
+	}
+    }
+    return(found);
+}
+// the 'kern' table, microsoft (version 0) or apple (version 1.0), horizontal format 0 subtables only.
+internal void
+ttf_kernkerning(ttf_font* font, u8* wanted, ttf_kernpair* pairs, s32 capacity, s32* count)
+{
+    ttf_table kern = font->tables[TTF_TABLE_KERN];
+
+    b32 apple          = (ttf_tableu32(font, kern, 0) == 0x00010000);
+    u32 subtable_count = apple ? ttf_tableu32(font, kern, 4) : ttf_tableu16(font, kern, 2);
+    u64 at             = apple ? 8 : 4;
+    if(!apple && ttf_tableu16(font, kern, 0) != 0) { return; }
+
+    for(u32 s = 0; s < subtable_count && s < 0xffff && ttf_inside(kern, at, 8); s++)
+    {
+	u32 length, header;
+	b32 usable;
+	if(apple)
+	{
+	    length = ttf_tableu32(font, kern, at);
+	    u16 coverage = ttf_tableu16(font, kern, at + 4);
+	    header = 8;
+	    usable = ((coverage & 0xff) == 0) && !(coverage & 0xe000); // vertical, cross-stream, variation.
+	}
+	else
+	{
+	    length = ttf_tableu16(font, kern, at + 2);
+	    u16 coverage = ttf_tableu16(font, kern, at + 4);
+	    header = 6;
+	    usable = ((coverage >> 8) == 0) && (coverage & 0x1) && !(coverage & 0x6); // horizontal, not minimum or cross-stream.
+	}
+	if(length < header) { break; }
+
+	if(usable)
+	{
+	    ttf_table subtable   = ttf_subtable(kern, at + header);
+	    u32       pair_count = ttf_tableu16(font, subtable, 0);
+	    for(u32 p = 0; p < pair_count && ttf_inside(subtable, 8 + (p * 6), 6); p++)
+	    {
+		u16 left  = ttf_tableu16(font, subtable, 8 + (p * 6));
+		u16 right = ttf_tableu16(font, subtable, 8 + (p * 6) + 2);
+		if(left < font->glyph_count && right < font->glyph_count && wanted[left] && wanted[right])
+		{
+		    ttf_addkernpair(pairs, capacity, count, left, right, ttf_tables16(font, subtable, 8 + (p * 6) + 4), (u16)s);
+		}
+	    }
+	}
+	at += length;
+    }
+}
+// the kerning between the 'glyph_count' 'glyphs' ('wanted' has a byte per glyph of the font, set for them).
+// returns how many pairs there are, only the first 'capacity' are written (call with 0 to count them).
+// 'scratch' is 3 * 'glyph_count' entries.
+internal s32
+ttf_kerning(ttf_font* font, u8* wanted, u16* glyphs, s32 glyph_count, u16* scratch, ttf_kernpair* pairs, s32 capacity)
+{
+    s32 count = 0;
+    if(!ttf_gposkerning(font, wanted, glyphs, glyph_count, scratch, pairs, capacity, &count))
+    {
+	ttf_kernkerning(font, wanted, pairs, capacity, &count);
+    }
+    return(count);
+}
+// returns the offset into 'glyf' and the size, size is 0 for empty glyphs (space).
+internal u32
+ttf_glyphlocation(ttf_font* font, s32 glyph, u32* size)
+{
+    *size = 0;
+    if(glyph < 0 || glyph >= font->glyph_count) { return(0); }
+
+    u32 start, end;
+    ttf_table loca = font->tables[TTF_TABLE_LOCA];
+    ttf_table glyf = font->tables[TTF_TABLE_GLYF];
+    if(font->index_format == 0)
+    {
+	start = ttf_tableu16(font, loca, glyph * 2) * 2;
+	end   = ttf_tableu16(font, loca, (glyph * 2) + 2) * 2;
+    }
+    else
+    {
+	start = ttf_tableu32(font, loca, glyph * 4);
+	end   = ttf_tableu32(font, loca, (glyph * 4) + 4);
+    }
+    if(end <= start || end > glyf.size) { return(0); }
+
+    *size = end - start;
+    return(glyf.offset + start);
+}
+internal b32
+ttf_glyphbox(ttf_font* font, s32 glyph, s32* x_min, s32* y_min, s32* x_max, s32* y_max)
+{
+    u32 size   = 0;
+    u32 offset = ttf_glyphlocation(font, glyph, &size);
+    if(size < 10) { return(false); }
+
+    u8* header = font->data + offset;
+    *x_min = ttf_s16(header + 2);
+    *y_min = ttf_s16(header + 4);
+    *x_max = ttf_s16(header + 6);
+    *y_max = ttf_s16(header + 8);
+    return(true);
+}
+internal b32
+ttf_simpleoutline(u8* header, u8* end, s32 contour_count, ttf_outline* outline)
+{
+    u8* contour_ends = header + 10;
+    if((contour_ends + (contour_count * 2) + 2) > end) { return(false); }
+
+    s32 point_count = ttf_u16(contour_ends + ((contour_count - 1) * 2)) + 1;
+    s32 base        = outline->point_count;
+    if((base + point_count) > outline->point_capacity ||
+       (outline->contour_count + contour_count) > outline->contour_capacity)
+    {
+	return(false);
+    }
+
+    s32 previous_end = -1;
+    for(s32 contour = 0; contour < contour_count; contour++)
+    {
+	s32 contour_end = ttf_u16(contour_ends + (contour * 2));
+	if(contour_end < previous_end || contour_end >= point_count) { return(false); }
+	outline->contour_ends[outline->contour_count++] = base + contour_end;
+	previous_end = contour_end;
+    }
+
+    u8* instructions = contour_ends + (contour_count * 2);
+    u8* p = instructions + 2 + ttf_u16(instructions); // skip hinting instructions.
+
+    // flags (stashed in on_curve, resolved below).
+    ttf_point* points = outline->points + base;
+    for(s32 point = 0; point < point_count;)
+    {
+	if(p >= end) { return(false); }
+	u8 flag   = *p++;
+	s32 count = 1;
+	if(flag & TTF_REPEAT)
+	{
+	    if(p >= end) { return(false); }
+	    count += *p++;
+	}
+	while(count-- && point < point_count)
+	{
+	    points[point++].on_curve = flag;
+	}
+    }
+    // x coordinates.
+    s32 x = 0;
+    for(s32 point = 0; point < point_count; point++)
+    {
+	u8 flag = (u8)points[point].on_curve;
+	if(flag & TTF_X_SHORT)
+	{
+	    if(p + 1 > end) { return(false); }
+	    x += (flag & TTF_X_SAME_OR_POSITIVE) ? *p : -(s32)*p;
+	    p += 1;
+	}
+	else if(!(flag & TTF_X_SAME_OR_POSITIVE))
+	{
+	    if(p + 2 > end) { return(false); }
+	    x += ttf_s16(p);
+	    p += 2;
+	}
+	points[point].x = (r32)x;
+    }
+    // y coordinates.
+    s32 y = 0;
+    for(s32 point = 0; point < point_count; point++)
+    {
+	u8 flag = (u8)points[point].on_curve;
+	if(flag & TTF_Y_SHORT)
+	{
+	    if(p + 1 > end) { return(false); }
+	    y += (flag & TTF_Y_SAME_OR_POSITIVE) ? *p : -(s32)*p;
+	    p += 1;
+	}
+	else if(!(flag & TTF_Y_SAME_OR_POSITIVE))
+	{
+	    if(p + 2 > end) { return(false); }
+	    y += ttf_s16(p);
+	    p += 2;
+	}
+	points[point].y        = (r32)y;
+	points[point].on_curve = (flag & TTF_ON_CURVE);
+    }
+
+    outline->point_count += point_count;
+    return(true);
+}
+internal b32
+ttf_glyphoutline_(ttf_font* font, s32 glyph, ttf_outline* outline, s32 depth)
+{
+    if(depth > TTF_MAX_COMPOUND_DEPTH) { return(false); }
+
+    s32 glyph_base = outline->point_count;
+
+    u32 size   = 0;
+    u32 offset = ttf_glyphlocation(font, glyph, &size);
+    if(size == 0)  { return(true); } // empty glyph.
+    if(size < 10)  { return(false); }
+
+    u8* header = font->data + offset;
+    u8* end    = header + size;
+
+    s32 contour_count = ttf_s16(header);
+    if(contour_count > 0)
+    {
+	return(ttf_simpleoutline(header, end, contour_count, outline));
+    }
+    else if(contour_count < 0)
+    {
+	// compound, every component is another glyph placed with a 2x2 transform and an offset.
+	u8* p = header + 10;
+	u16 flags = TTF_MORE_COMPONENTS;
+	while(flags & TTF_MORE_COMPONENTS)
+	{
+	    if(p + 4 > end) { return(false); }
+	    flags           = ttf_u16(p);
+	    s32 component   = ttf_u16(p + 2);
+	    p += 4;
+
+	    s32 arg1, arg2;
+	    if(flags & TTF_ARG_1_AND_2_ARE_WORDS)
+	    {
+		if(p + 4 > end) { return(false); }
+		arg1 = (flags & TTF_ARGS_ARE_XY_VALUES) ? ttf_s16(p) : ttf_u16(p);
+		arg2 = (flags & TTF_ARGS_ARE_XY_VALUES) ? ttf_s16(p + 2) : ttf_u16(p + 2);
+		p += 4;
+	    }
+	    else
+	    {
+		if(p + 2 > end) { return(false); }
+		arg1 = (flags & TTF_ARGS_ARE_XY_VALUES) ? (s8)p[0] : p[0];
+		arg2 = (flags & TTF_ARGS_ARE_XY_VALUES) ? (s8)p[1] : p[1];
+		p += 2;
+	    }
+
+	    // F2Dot14.
+	    r32 a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f;
+	    if(flags & TTF_WE_HAVE_A_SCALE)
+	    {
+		if(p + 2 > end) { return(false); }
+		a = d = ttf_s16(p) / 16384.0f;
+		p += 2;
+	    }
+	    else if(flags & TTF_WE_HAVE_AN_X_AND_Y_SCALE)
+	    {
+		if(p + 4 > end) { return(false); }
+		a = ttf_s16(p)     / 16384.0f;
+		d = ttf_s16(p + 2) / 16384.0f;
+		p += 4;
+	    }
+	    else if(flags & TTF_WE_HAVE_A_TWO_BY_TWO)
+	    {
+		if(p + 8 > end) { return(false); }
+		a = ttf_s16(p)     / 16384.0f;
+		b = ttf_s16(p + 2) / 16384.0f;
+		c = ttf_s16(p + 4) / 16384.0f;
+		d = ttf_s16(p + 6) / 16384.0f;
+		p += 8;
+	    }
+
+	    s32 base = outline->point_count;
+	    if(!ttf_glyphoutline_(font, component, outline, depth + 1)) { return(false); }
+
+	    for(s32 point = base; point < outline->point_count; point++)
+	    {
+		r32 x = outline->points[point].x;
+		r32 y = outline->points[point].y;
+		outline->points[point].x = (x * a) + (y * c);
+		outline->points[point].y = (x * b) + (y * d);
+	    }
+
+	    r32 dx, dy;
+	    if(flags & TTF_ARGS_ARE_XY_VALUES)
+	    {
+		dx = (r32)arg1;
+		dy = (r32)arg2;
+	    }
+	    else
+	    {
+		// point matching, arg1 is a point of the glyph so far, arg2 a point of the component.
+		s32 parent = glyph_base + arg1;
+		s32 child  = base + arg2;
+		if(parent >= base || child >= outline->point_count) { return(false); }
+		dx = outline->points[parent].x - outline->points[child].x;
+		dy = outline->points[parent].y - outline->points[child].y;
+	    }
+	    for(s32 point = base; point < outline->point_count; point++)
+	    {
+		outline->points[point].x += dx;
+		outline->points[point].y += dy;
+	    }
+	}
+    }
+    return(true);
+}
+internal b32
+ttf_glyphoutline(ttf_font* font, s32 glyph, ttf_outline* outline)
+{
+    outline->point_count   = 0;
+    outline->contour_count = 0;
+    outline->x_min = outline->y_min = outline->x_max = outline->y_max = 0;
+
+    ttf_glyphbox(font, glyph, &outline->x_min, &outline->y_min, &outline->x_max, &outline->y_max);
+
+    return(ttf_glyphoutline_(font, glyph, outline, 0));
+}
+
+// raster.
+struct raster_surface
+{
+    s32 width;
+    s32 height;
+    u8* pixels;        // 8-bit coverage, bottom-up.
+    r32* accumulation; // (width * height) + 1, signed area/cover.
+};
+internal void
+raster_line(raster_surface* surface, r32 x0, r32 y0, r32 x1, r32 y1)
+{
+    if(y0 == y1) { return; }
+
+    r32 direction = 1.0f;
+    if(y0 > y1)
+    {
+	r32 t;
+	t = x0; x0 = x1; x1 = t;
+	t = y0; y0 = y1; y1 = t;
+	direction = -1.0f;
+    }
+
+    r32 dxdy = (x1 - x0) / (y1 - y0);
+    r32 x    = x0;
+    if(y0 < 0.0f)
+    {
+	x -= y0 * dxdy;
+    }
+
+    s32 row_start = (y0 < 0.0f) ? 0 : (s32)y0;
+    s32 row_end   = (s32)ceilf(y1);
+    if(row_end > surface->height) { row_end = surface->height; }
+
+    r32* accumulation = surface->accumulation;
+    for(s32 row = row_start; row < row_end; row++)
+    {
+	r32* line = accumulation + (row * surface->width);
+
+	r32 dy     = (((row + 1) < y1) ? (row + 1) : y1) - ((row > y0) ? row : y0);
+	r32 x_next = x + (dxdy * dy);
+	r32 d      = dy * direction;
+
+	r32 left  = (x < x_next) ? x : x_next;
+	r32 right = (x < x_next) ? x_next : x;
+
+	r32 left_floor = floorf(left);
+	s32 left_index = (s32)left_floor;
+	r32 right_ceil = ceilf(right);
+	s32 right_index = (s32)right_ceil;
+
+	if(right_index <= left_index + 1)
+	{
+	    // the segment stays inside a single pixel on this row.
+	    r32 middle = (0.5f * (x + x_next)) - left_floor;
+	    line[left_index]     += d - (d * middle);
+	    line[left_index + 1] += d * middle;
+	}
+	else
+	{
+	    r32 s = 1.0f / (right - left);
+	    r32 left_fraction  = left - left_floor;
+	    r32 area_first     = 0.5f * s * (1.0f - left_fraction) * (1.0f - left_fraction);
+	    r32 right_fraction = right - right_ceil + 1.0f;
+	    r32 area_last      = 0.5f * s * right_fraction * right_fraction;
+
+	    line[left_index] += d * area_first;
+	    if(right_index == left_index + 2)
+	    {
+		line[left_index + 1] += d * (1.0f - area_first - area_last);
+	    }
+	    else
+	    {
+		r32 area_second = s * (1.5f - left_fraction);
+		line[left_index + 1] += d * (area_second - area_first);
+		for(s32 column = left_index + 2; column < right_index - 1; column++)
+		{
+		    line[column] += d * s;
+		}
+		r32 area_penultimate = area_second + ((right_index - left_index - 3) * s);
+		line[right_index - 1] += d * (1.0f - area_penultimate - area_last);
+	    }
+	    line[right_index] += d * area_last;
+	}
+	x = x_next;
+    }
+}
+internal void
+raster_quadratic(raster_surface* surface, r32 x0, r32 y0, r32 x1, r32 y1, r32 x2, r32 y2)
+{
+    // subdivide until the flattening error is well below a pixel.
+    r32 dx = x0 - (2.0f * x1) + x2;
+    r32 dy = y0 - (2.0f * y1) + y2;
+    r32 deviation = (dx * dx) + (dy * dy);
+    if(deviation < 0.333f)
+    {
+	raster_line(surface, x0, y0, x2, y2);
+	return;
+    }
+
+    s32 segments = 1 + (s32)floorf(sqrtf(sqrtf(3.0f * deviation)));
+    r32 step = 1.0f / segments;
+
+    r32 px = x0;
+    r32 py = y0;
+    for(s32 segment = 1; segment <= segments; segment++)
+    {
+	r32 t  = segment * step;
+	r32 mt = 1.0f - t;
+	r32 x  = (mt * mt * x0) + (2.0f * mt * t * x1) + (t * t * x2);
+	r32 y  = (mt * mt * y0) + (2.0f * mt * t * y1) + (t * t * y2);
+	raster_line(surface, px, py, x, y);
+	px = x;
+	py = y;
+    }
+}
+// places the outline with its origin at (origin_x, origin_y) in pixels, scale maps font units to pixels.
+internal void
+raster_outline(raster_surface* surface, ttf_outline* outline, r32 scale, r32 origin_x, r32 origin_y)
+{
+    s32 pixel_count = surface->width * surface->height;
+    for(s32 pixel = 0; pixel <= pixel_count; pixel++)
+    {
+	surface->accumulation[pixel] = 0.0f;
+    }
+
+    // keep every x inside the row (the accumulation of 'x + 1' may spill into the padding).
+    r32 x_limit = (r32)(surface->width - 1);
+
+    s32 start = 0;
+    for(s32 contour = 0; contour < outline->contour_count; contour++)
+    {
+	s32 end   = outline->contour_ends[contour];
+	s32 count = (end - start) + 1;
+	if(count < 2)
+	{
+	    start = end + 1;
+	    continue;
+	}
+
+	ttf_point* points = outline->points + start;
+
+	// find a starting on-curve point, or synthesize one between two off-curve points.
+	r32 first_x, first_y;
+	s32 first = 0;
+	while(first < count && !points[first].on_curve) { first++; }
+	s32 next = first + 1; // walking 'count' points from here ends back on the start point.
+	if(first == count)
+	{
+	    first_x = 0.5f * (points[0].x + points[count - 1].x);
+	    first_y = 0.5f * (points[0].y + points[count - 1].y);
+	    next    = 0;
+	}
+	else
+	{
+	    first_x = points[first].x;
+	    first_y = points[first].y;
+	}
+
+	r32 x = origin_x + (first_x * scale);
+	r32 y = origin_y + (first_y * scale);
+	x = (x < 0.0f) ? 0.0f : ((x > x_limit) ? x_limit : x);
+
+	r32 start_x = x;
+	r32 start_y = y;
+
+	b32 have_control = false;
+	r32 control_x = 0.0f;
+	r32 control_y = 0.0f;
+
+	for(s32 i = 0; i < count; i++)
+	{
+	    ttf_point* point = &points[(next + i) % count];
+	    r32 px = origin_x + (point->x * scale);
+	    r32 py = origin_y + (point->y * scale);
+	    px = (px < 0.0f) ? 0.0f : ((px > x_limit) ? x_limit : px);
+
+	    if(point->on_curve)
+	    {
+		if(have_control)
+		{
+		    raster_quadratic(surface, x, y, control_x, control_y, px, py);
+		    have_control = false;
+		}
+		else
+		{
+		    raster_line(surface, x, y, px, py);
+		}
+		x = px;
+		y = py;
+	    }
+	    else
+	    {
+		if(have_control)
+		{
+		    // implied on-curve point between two off-curve points.
+		    r32 mx = 0.5f * (control_x + px);
+		    r32 my = 0.5f * (control_y + py);
+		    raster_quadratic(surface, x, y, control_x, control_y, mx, my);
+		    x = mx;
+		    y = my;
+		}
+		control_x    = px;
+		control_y    = py;
+		have_control = true;
+	    }
+	}
+	if(have_control)
+	{
+	    raster_quadratic(surface, x, y, control_x, control_y, start_x, start_y);
+	}
+	else if(x != start_x || y != start_y)
+	{
+	    raster_line(surface, x, y, start_x, start_y);
+	}
+
+	start = end + 1;
+    }
+
+    // prefix sum, |winding| clamped to 1 approximates non-zero fill.
+    // the sum stays serial (the order of the adds decides the bytes), the conversion doesn't.
+    r32 accumulator = 0.0f;
+    for(s32 pixel = 0; pixel < pixel_count; pixel++)
+    {
+	accumulator += surface->accumulation[pixel];
+	surface->accumulation[pixel] = accumulator;
+    }
+    simd.coverage(surface->accumulation, surface->pixels, pixel_count);
+}
@@ -1,27 +1,5 @@
-// Tedious Typography
+// Atlas Baked (windows)
 //
-// Font sizes can be specified in points (pt), 1 pt = 1/72 inch (0.35 mm).
-//
-// The font size (height) is broken up into the ascent and descent.
-// Ascent is the space above the baseline.
-// Descent is the space below the baseline.
-//
-// Font size = Ascent + Descent
-// e.g A 72pt font may have an ascent of 56pt and descent of 16pt, thus 72pt = (56pt + 16pt)
-//
-// Font sizes can also be specified in logical units,
-// 1 logical unit = 72pt (1 inch, 2.54 cm).
-// 1 logical unit = DPI (px) (historically 96 px, but can be set on a user by user basis)
-// e.g DPI setting of 100% (96 px), DPI setting of 125% (120 px), DPI setting of 150% (144 px)
-//
-// Font sizes can also be specified in device independent pixels (DIPs), 1 DIP = 1/96 logical unit.
-// Therefore,
-// 1 inch = 72 pt = 1 logical unit = 96 px (DPI, 100%)  = 1 DIP
-// 1 inch = 72 pt = 1 logical unit = 144 px (DPI, 150%) = 1.5 DIP
-//
-// to get the font size in pixels given points:
-// pixels = (points/72)*96*(DPI/100)
-// 
 // Windows peculiarities
 // Something to note about Windows 'SetProcessDpiAwareness()'.
 // If a program does not set its DPI awareness, then Windows scales the window (among other things) when the users DPI setting is not set to 100%.
@@ -50,491 +28,174 @@ global s32 window_height = 720;
 
 global b32 cmd_mode;
 
-global s8   open_file[MAX_PATH] = { };
-global s8   save_file[MAX_PATH] = { };
-global s8 bitmap_file[MAX_PATH] = { };
-
-global s8 fontheight_field[3] = { };
-
-global u32 DPI;
-
-#pragma pack(push, 1)
-// bitmap.
-struct bitmap_header
-{
-    u16   signature; // must be 'BM' (0x4d42)
-    u32   file_size;
-    u16  reserved_0; // must be 0
-    u16  reserved_1; // must be 0
-    u32 byte_offset; // offset into the file the actual pixel array begins (must be 122)
-
-    u32 header_size; // sizeof(BITMAPINFOHEADER)
-    s32       width;  
-    s32      height; // positive (bottom-up DIB)
-    
-    u16 planes;              // must be 1
-    u16 bits_per_pixel;      // must be 32    
-    u32 compression;         // must be BI_BITFIELDS
-    u32 image_size;          // must be 0
-    s32 x_pixels_per_meter;  // must be 0 (no preference)
-    s32 y_pixels_per_meter;  // must be 0 (no preference)
-    u32        used_colours; // must be 0
-    u32 significant_colours; // must be 0
-};
-// ttf.
-#define TTF_SWAPWORD(x) MAKEWORD(HIBYTE(x), LOBYTE(x))
-#define TTF_SWAPLONG(x) MAKELONG(TTF_SWAPWORD(HIWORD(x)), TTF_SWAPWORD(LOWORD(x)))
-struct ttf_offsettable_header
-{
-    u16 major_version;
-    u16 minor_version;
-    u16 num_of_tables;
-    u16 uSearchRange;
-    u16 uEntrySelector;
-    u16 uRangeShift;
-};
-struct ttf_directorytable_header
-{
-    s8 table_name[4]; 
-    u32 checksum; 
-    u32 offset; 
-    u32 length; 
-};
-struct ttf_nametable_header
-{
-    u16 format_selector; // must be 0
-    u16 namerecords_count; 
-    u16 storage_offset;
-};
-struct ttf_name_header
-{
-    u16 platform_id;
-    u16 encoding_id;
-    u16 language_id;
-    u16 name_id;
-    u16 string_length;
-    u16 string_offset;
-};
-// font.
-#define GLYPH_COUNT   233
-#define GLYPH_ROWS    16
-#define GLYPH_COLUMNS 16
-struct glyph_header
-{
-    s8  character;
-    s32 offset;
-    
-    s32     spacing;
-    s32 pre_spacing;
-    
-    s32  width;
-    s32 height;
+#include "atlas_baked.cpp"
 
-    r32 u0;
-    r32 u1;
-    r32 v0;
-    r32 v1;
-};
-struct font_header
+// platform.
+internal void*
+platform_allocate(u64 size)
 {
-    s32   size;
-    s32  width;
-    s32 height;
-    s32 glyph_count;
-
-    s32 glyph_height;
-    s32 glyph_width;
-
-    s32 line_spacing;
-
-    s32 glyph_offset;
-    s32  byte_offset;
-    
-    glyph_header glyphs[GLYPH_COUNT];
-};
-#pragma pack(pop)
-
-// bitmap.
+    return(VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+}
 internal void
-bitmap_saveas(s8* bitmap_file, s32 bitmap_width, s32 bitmap_height, s8* bitmap_data)
+platform_deallocate(void* memory)
 {
-    s32 bitmap_size = bitmap_width * bitmap_height * 4;
-
-    bitmap_header header = {};
-    header.signature      = 0x4D42; 
-    header.file_size      = sizeof(bitmap_header) + bitmap_size;
-    header.byte_offset    = sizeof(bitmap_header); 
-    header.header_size    = sizeof(BITMAPINFOHEADER); 
-    header.width          = bitmap_width;  
-    header.height         = bitmap_height; 
-    header.planes         = 1;            
-    header.bits_per_pixel = 32;      
-    header.compression    = BI_RGB;
-    header.image_size     = bitmap_size;
-
-    s8* save = (s8*)VirtualAlloc(0, header.file_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-
-    mem_copy(&header, save, header.header_size);
-    mem_copy(bitmap_data, save + header.byte_offset, bitmap_size);
-
-    io_writefile(bitmap_file, header.file_size, save);
-
-    VirtualFree(save, 0, MEM_RELEASE);
+    if(memory)
+    {
+	VirtualFree(memory, 0, MEM_RELEASE);
+    }
 }
-// ttf.
-internal b32
-ttf_fontfamily(s8* font_file, s8* font_family)
+internal platform_file
+platform_readfile(s8* path)
 {
-    io_file font = io_readfile(font_file);
-    if(font.source)
-    {
-	ttf_offsettable_header* offset_table = (ttf_offsettable_header*)font.source;
-	offset_table->num_of_tables = TTF_SWAPWORD(offset_table->num_of_tables);
-
-	b32 table_found = false;
+    platform_file file = {};
 
-	ttf_directorytable_header* directory_table =
-	(ttf_directorytable_header*)((s8*)font.source + sizeof(ttf_offsettable_header));
-	for(s32 table = 0; table < offset_table->num_of_tables; table++)
-	{
-	    if(directory_table->table_name[0] == 'n' &&
-	       directory_table->table_name[1] == 'a' &&
-	       directory_table->table_name[2] == 'm' &&
-	       directory_table->table_name[3] == 'e')
-	    {
-		table_found = true;
-		directory_table->length = TTF_SWAPLONG(directory_table->length);
-		directory_table->offset = TTF_SWAPLONG(directory_table->offset);
-		break;
-	    }
-	    directory_table++;
-	}
-
-	if(table_found)
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(handle != INVALID_HANDLE_VALUE)
+    {
+	LARGE_INTEGER size = {};
+	if(GetFileSizeEx(handle, &size) && size.QuadPart > 0 && size.QuadPart < 0xffffffff)
 	{
-	    ttf_nametable_header* name_table = (ttf_nametable_header*)((s8*)font.source + directory_table->offset);
-
-	    name_table->namerecords_count = TTF_SWAPWORD(name_table->namerecords_count);
-	    name_table->storage_offset    = TTF_SWAPWORD(name_table->storage_offset);
-
-	    ttf_name_header* name_header = (ttf_name_header*)((s8*)name_table + sizeof(ttf_nametable_header));
-	    for(s32 record = 0; record < name_table->namerecords_count; record++)
+	    file.data = platform_allocate(size.QuadPart);
+	    if(file.data)
 	    {
-		name_header->name_id = TTF_SWAPWORD(name_header->name_id);
-		if(name_header->name_id == 1) // font family
+		DWORD bytes_read = 0;
+		if(ReadFile(handle, file.data, (DWORD)size.QuadPart, &bytes_read, 0) && bytes_read == size.QuadPart)
 		{
-		    name_header->string_length = TTF_SWAPWORD(name_header->string_length);
-		    name_header->string_offset = TTF_SWAPWORD(name_header->string_offset);
-
-		    // note, we can not to a simple 'mem_copy' as we require a null terminated string.
-		    //       it would appear the spaces between letters are '\0'
-
-		    s8* start = (s8*)font.source + directory_table->offset + name_table->storage_offset + 
-		    name_header->string_offset + 1;
-		    for(s32 c = 0; c < name_header->string_length - 1; c++)
-		    {
-			if(start[c] != '\0')
-			{
-			    *font_family++ = start[c];
-			}
-		    }
-		    
-		    io_freefile(font);
-		    return(true);
+		    file.size = (u32)size.QuadPart;
+		}
+		else
+		{
+		    platform_deallocate(file.data);
+		    file.data = 0;
 		}
-		name_header++;
 	    }
 	}
-	
+	CloseHandle(handle);
     }
-    return(false);
+    return(file);
 }
-// bake.
 internal void
-bake_writeglyph(void* source, u32 source_size_x, u32 source_size_y, u32 source_width,
-		void* target, u32 target_width)
+platform_freefile(platform_file file)
 {
-    for(u32 sy = 0; sy < source_size_y; sy++)
-    {
-	mem_copy(source, target, (source_size_x * 4));
-	target = (u32*)target + target_width;
-	source = (u32*)source + source_width;
-    }
+    platform_deallocate(file.data);
 }
-internal u32*
-bake_loadglyph(HDC device_context, void* bytes,
-	       s32 font_height, // in pixels.
-	       s32* offset,
-	       s32* glyph_width,
-	       s32* glyph_height)
+internal platform_file
+platform_mapfile(s8* path)
 {
-    ASSERT(bytes);
-
-    // text extent?
-    s32  subsection_width  = font_height * 2;
-    s32  subsection_height = font_height * 2;
-    u32* subsection        = (u32*)VirtualAlloc(0, (subsection_width * subsection_height * 4), MEM_COMMIT, PAGE_READWRITE);
-
-    // copy and calculate bounds.
-    s32 max_column = 0;
-    s32 min_column = subsection_width;
-    s32 max_row    = 0;
-    s32 min_row    = subsection_height;
-
-    u32* dib_memory = (u32*)bytes;
-    u32* ptr = subsection;
-    for(s32 y = 0; y < subsection_height; y++)  
+    platform_file file = {};
+
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(handle != INVALID_HANDLE_VALUE)
     {
-	u32* px = dib_memory;
-	for(s32 x = 0; x < subsection_width; x++) 
+	LARGE_INTEGER size = {};
+	if(GetFileSizeEx(handle, &size) && size.QuadPart > 0 && size.QuadPart < 0xffffffff)
 	{
-	    u8 a = *px++ & 0xff; 
-	    if(a)
+	    HANDLE mapping = CreateFileMappingA(handle, 0, PAGE_READONLY, 0, 0, 0);
+	    if(mapping)
 	    {
-		if(x < min_column) min_column = x;
-		if(x > max_column) max_column = x;
-		if(y < min_row)    min_row    = y;
-		if(y > max_row)    max_row    = y;
+		file.data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if(file.data)
+		{
+		    file.size = (u32)size.QuadPart;
+		}
+		CloseHandle(mapping); // the view keeps the mapping.
 	    }
-	    *ptr++ = a | (a << 8) | (a << 16) | (a << 24);
 	}
-	dib_memory += (font_height * 2);
+	CloseHandle(handle);
     }
-	    
-    *glyph_width  = (max_column != 0) ? ((max_column - min_column) + 1) : 0;
-    *glyph_height = (max_row    != 0) ? ((max_row    - min_row   ) + 1) : 0;
-
-    // this is a save guard, shouldn't actually happen in practice! change to 'ASSERT'
-    *glyph_width  = (*glyph_width  > font_height) ? font_height : *glyph_width;
-    *glyph_height = (*glyph_height > font_height) ? font_height : *glyph_height;
-
-    // smallest possible glyph.
-    u32* glyph = (u32*)VirtualAlloc(0, *glyph_width * *glyph_height * 4, MEM_COMMIT, PAGE_READWRITE);
-    if(glyph)
+    return(file);
+}
+internal void
+platform_unmapfile(platform_file file)
+{
+    if(file.data)
     {
-	u32* subsection_ptr = subsection;
-	subsection_ptr += (min_row * subsection_width) + min_column;
-
-	bake_writeglyph(subsection_ptr, *glyph_width, *glyph_height, subsection_width, glyph, *glyph_width);
-	
-	VirtualFree(subsection, 0, MEM_RELEASE);
+	UnmapViewOfFile(file.data);
     }
-    // free happens later.
-
-    TEXTMETRICA metrics = {};
-    GetTextMetricsA(device_context, &metrics);
-    *offset = max_row - (subsection_height - metrics.tmAscent);
-
-    return((u32*)glyph); 
 }
 internal b32
-bake_loadfont(font_header* atlas, r32 points, s32 pixels, s8* font_file, u32** glyphs)
+platform_writefile(s8* path, u64 size, void* data)
 {
     b32 success = false;
 
-    AddFontResourceExA(font_file, FR_PRIVATE, 0);
-
-    s8 font_family[256] = {};
-    ttf_fontfamily(font_file, font_family);
-
-    HFONT font_handle = CreateFontA(-MulDiv(points/2.0, GetDeviceCaps(GetDC(0), LOGPIXELSY), 72), 0, 0, 0,
-				    FW_NORMAL,   // weight
-				    FALSE,       // italic
-				    FALSE,       // underline
-				    FALSE,       // strikeout
-				    DEFAULT_CHARSET, 
-				    OUT_DEFAULT_PRECIS,
-				    CLIP_DEFAULT_PRECIS, 
-				    ANTIALIASED_QUALITY,
-				    DEFAULT_PITCH | FF_DONTCARE,
-				    font_family);
-    
-
-    if(font_handle)
+    HANDLE handle = CreateFileA(path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if(handle != INVALID_HANDLE_VALUE)
     {
-	HDC device_context = CreateCompatibleDC(GetDC(0));
-	if(device_context)
-	{
-	    SetMapMode(device_context, MM_TEXT);
-	    
-	    BITMAPINFO bitmap_info              = {};
-	    bitmap_info.bmiHeader.biSize        =  sizeof(bitmap_info.bmiHeader);
-	    bitmap_info.bmiHeader.biWidth       =  pixels * 2;
-	    bitmap_info.bmiHeader.biHeight      =  pixels * 2; // (+) bottom-up, (-) top-down
-	    bitmap_info.bmiHeader.biPlanes      =  1;
-	    bitmap_info.bmiHeader.biBitCount    =  32;
-	    bitmap_info.bmiHeader.biCompression =  BI_RGB;
-
-	    s32 max_offset = 0;
-	    s32 c = 0;
-	    for(s32 g = 32; g < 256; g++) // '!'(32) -> ''(255) 
-	    {
-		void*   bytes = 0;
-		HBITMAP bitmap_handle = CreateDIBSection(device_context, &bitmap_info, DIB_RGB_COLORS, &bytes, 0, 0);
-		if(bitmap_handle)
-		{
-		    // standard.
-		    SelectObject (device_context, bitmap_handle);
-		    SelectObject (device_context, font_handle);
-		    SetBkColor   (device_context, RGB(  0,   0,   0));
-		    SetTextColor (device_context, RGB(255, 255, 255));
-		    TextOutA(device_context, 0, 0, (LPCSTR)&g, 1); // character output.
-
-		    // ?
-		    // SIZE size;
-		    // GetTextExtentPoint32A(device_context, &character, 1, &size);
-    
-		    glyphs[c] = bake_loadglyph(device_context, bytes, pixels,
-					       &atlas->glyphs[c].offset,
-					       &atlas->glyphs[c].width,
-					       &atlas->glyphs[c].height);
-		    
-		    if(atlas->glyphs[c].offset > max_offset) { max_offset = atlas->glyphs[c].offset; }
-
-		    ABC character_metrics = {};
-		    GetCharABCWidthsA(device_context, (u32)g, (u32)g, &character_metrics);
-		    atlas->glyphs[c].character   = g;
-		    atlas->glyphs[c].    spacing = character_metrics.abcC;
-		    atlas->glyphs[c].pre_spacing = character_metrics.abcA;
-
-		    DeleteObject(bitmap_handle);
-		}
-		else
-		{
-		    OutputDebugStringA("'CreateDIBSection' failed!\n");
-		}
-		c++;
-	    }
-	    for(u32 i = 0; i < GLYPH_COUNT; i++)
-	    {
-		atlas->glyphs[i].offset = max_offset - atlas->glyphs[i].offset;
-	    }
-
-	    TEXTMETRIC metrics = {};
-	    GetTextMetrics(device_context, &metrics);
-	    atlas->line_spacing = metrics.tmInternalLeading;
-
-	    success = true;
-	}
-	else
-	{
-	    OutputDebugStringA("'CreateCompatibleDC' failed!\n");
-	}
-	DeleteObject(font_handle);
-    }
-    else
-    {
-	OutputDebugStringA("'CreateFontA' failed!\n");
+	DWORD bytes_written = 0;
+	success = WriteFile(handle, data, (DWORD)size, &bytes_written, 0) && (bytes_written == size);
+	CloseHandle(handle);
     }
-
-    RemoveFontResourceExA(font_file, FR_PRIVATE, 0);
-
     return(success);
-};
-internal void
-bake_clearglyphs(u32** glyphs)
-{
-    for(u32 glyph = 0; glyph < GLYPH_COUNT; glyph++)
-    {
-	VirtualFree(glyphs[glyph], 0, MEM_RELEASE);
-    }
 }
 internal b32
-bake_font()
+platform_writebuffers(s8* path, platform_buffer* buffers, s32 count, b32 flush)
 {
     b32 success = false;
 
-    r32 points = strtof(fontheight_field,0); 
-    s32 pixels = (points/72)*96*(DPI/100);          
-    
-    u32* glyphs[GLYPH_COUNT] = {};
-	 
-    font_header* atlas = (font_header*)VirtualAlloc(0, sizeof(font_header) + (((pixels*GLYPH_COLUMNS)*(pixels*GLYPH_ROWS))*4), MEM_COMMIT, PAGE_READWRITE);
-    atlas->glyph_width  = pixels;
-    atlas->glyph_height = pixels;
-    atlas->width        = atlas->glyph_width  * GLYPH_COLUMNS;
-    atlas->height       = atlas->glyph_height * GLYPH_ROWS;
-    atlas->size         = sizeof(font_header) + (atlas->width * atlas->height * 4);
-    atlas->glyph_count  = GLYPH_COUNT;
-    atlas->glyph_offset = 9 * sizeof(u32);
-    atlas->byte_offset  = sizeof(font_header);
-
-    // does the ttf file exist?
-    if(PathFileExistsA(open_file))
+    HANDLE handle = CreateFileA(path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if(handle != INVALID_HANDLE_VALUE)
     {
-	if(bake_loadfont(atlas, points/2.0, pixels/2, open_file, glyphs))
+	// one write per buffer ('WriteFileGather' wants page sized, unbuffered writes), at most 1 GiB at once.
+	success = true;
+	for(s32 b = 0; b < count && success; b++)
 	{
-	    s8* glyph_data = (s8*)atlas + atlas->byte_offset;
-	    for(s32 g = GLYPH_COUNT - 1; g > -1; g--)
+	    u8* data = (u8*)buffers[b].data;
+	    u64 size = buffers[b].size;
+	    while(size > 0 && success)
 	    {
-		u32 target_row    = g / GLYPH_COLUMNS;
-		u32 target_column = g % GLYPH_COLUMNS;
-
-		// the row height is equal to atlas->glyph_height.
-		
-		// bytes contained in a single row =
-		// atlas->glyph_height * atlas->width * 4
-
-		// bytes contained in a single glyph  row =
-		// atlas->glyph_width * 4
-
-		// glyph beginning row =
-		// (target_row * 'bytes contained in a single row') + (target_column * 'bytes contained in a single glyph row')
-
-		// bytes contianed in a single glyph =
-		// atlas->glyph_width * atlas->glyph_height * 4
-
-		// bytes contianed in entire glyph atlas =
-		// 'bytes contianed in a single glyph' * GLYPH_ROWS * GLYPH_COLUMNS
-
-		// points to the first row of bytes where the glyph_header should be placed. (bottom-up)
-		s8* target =
-		(glyph_data + (atlas->width * atlas->height * 4) - (atlas->width * atlas->glyph_height * 4))
-		+
-		(atlas->glyph_width * 4 * target_column)
-		-
-		(atlas->width * atlas->glyph_height * 4 * target_row);
-
-		s8* source = (s8*)(glyphs[g]);
-		
-		bake_writeglyph(source, atlas->glyphs[g].width, atlas->glyphs[g].height, atlas->glyphs[g].width, target, atlas->width);
-
-		// uv.
-		atlas->glyphs[g].u0 = (target_column * atlas->glyph_width)/(r32)atlas->width;
-		atlas->glyphs[g].v0 = ((((GLYPH_ROWS - 1) - target_row) * atlas->glyph_height) + atlas->glyphs[g].height)/(r32)atlas->height;
-		atlas->glyphs[g].u1 = ((target_column * atlas->glyph_width) + atlas->glyphs[g].width)/(r32)atlas->width;
-		atlas->glyphs[g].v1 = (((GLYPH_ROWS - 1) - target_row) * atlas->glyph_height)/(r32)atlas->height;
+		DWORD part          = (DWORD)((size < (1 << 30)) ? size : (1 << 30));
+		DWORD bytes_written = 0;
+		success = WriteFile(handle, data, part, &bytes_written, 0) && (bytes_written == part);
+		data += part;
+		size -= part;
 	    }
-	
-	    bake_clearglyphs(glyphs);
-
-	    // write font (.font)
-	    io_writefile(save_file, atlas->size, atlas);
-	    // write bitmap (.bmp)
-	    bitmap_saveas(bitmap_file, atlas->width, atlas->height, (s8*)atlas + atlas->byte_offset);
-
-	    //VirtualFree(tree.head, 0, MEM_RELEASE);
-	    VirtualFree(atlas, 0, MEM_RELEASE);
-
-	    success = true;
 	}
-	else
+	if(success && flush)
 	{
-	    OutputDebugStringA("'windows_loadfont' failed!\n");
+	    success = FlushFileBuffers(handle);
 	}
+	success = CloseHandle(handle) && success;
     }
-    else
+    return(success);
+}
+internal b32
+platform_fileexists(s8* path)
+{
+    return(PathFileExistsA(path));
+}
+internal u64
+platform_filetime(s8* path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+    if(!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes) || (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
     {
-	OutputDebugStringA("'windows_loadfont' failed!\n");
-
-	// error: specified truetype file does not exist.
+	return(0);
     }
-    
-    return(success);
+    u64 time = ((u64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+    return(time ? time : 1);
+}
+internal b32
+platform_makedirectory(s8* path)
+{
+    return(CreateDirectoryA(path, 0) || GetLastError() == ERROR_ALREADY_EXISTS);
+}
+internal void
+platform_debugprint(const s8* message)
+{
+    OutputDebugStringA(message);
+}
+internal b32
+platform_print(const s8* text, u64 size)
+{
+    HANDLE output_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    if(!output_handle || output_handle == INVALID_HANDLE_VALUE) { return(false); }
+
+    DWORD bytes_written = 0;
+    return(WriteFile(output_handle, text, (DWORD)size, &bytes_written, 0) && (bytes_written == size));
 }
 
 internal b32
-bake_parsecommandline(s8* cmd, s32 size, s8* ttf_file, s8* font_file, s8* font_height)
+bake_parsecommandline(s8* cmd, s32 size, s8* ttf_file, s8* font_file, s8* font_height, s32* thread_count, s32* padding, s32* bleed, s32* spread, s32* levels, s32* quality, s32* chunk, s32* max_texture, b32* flush, b32* embed, u32* format, s8* manifest, s8* ranges, s8* cache, s8* report, s8* server)
 {
     b32 success = true;
 
@@ -544,8 +205,11 @@ bake_parsecommandline(s8* cmd, s32 size, s8* ttf_file, s8* font_file, s8* font_h
     b32    ttf_given = false;
     b32   font_given = false;
     b32 height_given = false;
+    b32 manifest_given = false;
+    b32   server_given = false;
     
-    while(!(ttf_given && font_given && height_given))
+    // optional arguments (-j, -p, -b, -f, -m, -u, -r, -c, -l, -z, -x, -o, -w) may come after the required three, so read to the end.
+    while(s < size)
     {
 	b32 found_arg = false;
 	
@@ -558,7 +222,7 @@ bake_parsecommandline(s8* cmd, s32 size, s8* ttf_file, s8* font_file, s8* font_h
 	    }
 	    if(!(s < size))
 	    {
-		return(false); // ?
+		break;
 	    }
 	    s++;
 	}
@@ -607,27 +271,350 @@ bake_parsecommandline(s8* cmd, s32 size, s8* ttf_file, s8* font_file, s8* font_h
 		// *d = '\0'; // trick? 
 		// *font_height = string_to_integer(&cmd[s + 5]); best solution!
 		
-		if(height_size > 3)
+		if(height_size >= (BAKE_MAX_SIZES * 4))
 		{
 		    success = false; // too big.
 		}
-		mem_copy(&cmd[s + 3], font_height, height_size);
+		else
+		{
+		    mem_copy(&cmd[s + 3], font_height, height_size);
+		}
 		
 		height_given = true;
 
 		s += height_size + 3;
 	    }
+	    else if(cmd[s+1] == 'j' || cmd[s+1] == 'p' || cmd[s+1] == 'b' || cmd[s+1] == 'r' || cmd[s+1] == 'l' || cmd[s+1] == 'q' || cmd[s+1] == 'z' || cmd[s+1] == 'x' || cmd[s+1] == 'y' || cmd[s+1] == 'e') // is it thread count, padding, bleed, spread, mip levels, bc4 quality, chunk size, max texture size, flush or embed?
+	    {
+		s8* d = &cmd[s + 3];
+		s32 number_size = 0;
+		while(*d != '"')
+		{
+		    d++;
+		    number_size++;
+		}
+
+		s8 number[8] = {};
+		if(number_size > 7)
+		{
+		    success = false; // too big.
+		}
+		else
+		{
+		    mem_copy(&cmd[s + 3], number, number_size);
+
+		    s32 value = (s32)strtol(number, 0, 10);
+		    if(cmd[s+1] == 'j') { *thread_count = value; }
+		    if(cmd[s+1] == 'p') { *padding      = value; }
+		    if(cmd[s+1] == 'b') { *bleed        = value; }
+		    if(cmd[s+1] == 'r') { *spread       = value; }
+		    if(cmd[s+1] == 'l') { *levels       = value; }
+		    if(cmd[s+1] == 'q') { *quality      = value; }
+		    if(cmd[s+1] == 'z') { *chunk        = value; }
+		    if(cmd[s+1] == 'x') { *max_texture  = value; }
+		    if(cmd[s+1] == 'y') { *flush        = (value != 0); }
+		    if(cmd[s+1] == 'e') { *embed        = (value != 0); }
+		}
+
+		s += number_size + 3;
+	    }
+	    else if(cmd[s+1] == 'f') // is it the pixel format?
+	    {
+		s8* d = &cmd[s + 3];
+		s32 format_size = 0;
+		while(*d != '"')
+		{
+		    d++;
+		    format_size++;
+		}
+
+		if(format_size == 2 && strncmp(&cmd[s + 3], "r8", 2) == 0)
+		{
+		    *format = FONT_FORMAT_R8;
+		}
+		else if(format_size == 6 && strncmp(&cmd[s + 3], "rgba32", 6) == 0)
+		{
+		    *format = FONT_FORMAT_RGBA32;
+		}
+		else if(format_size == 3 && strncmp(&cmd[s + 3], "sdf", 3) == 0)
+		{
+		    *format = FONT_FORMAT_SDF;
+		}
+		else if(format_size == 4 && strncmp(&cmd[s + 3], "msdf", 4) == 0)
+		{
+		    *format = FONT_FORMAT_MSDF;
+		}
+		else if(format_size == 3 && strncmp(&cmd[s + 3], "bc4", 3) == 0)
+		{
+		    *format = FONT_FORMAT_BC4;
+		}
+		else
+		{
+		    success = false; // unknown format.
+		}
+
+		s += format_size + 3;
+	    }
+	    else if(cmd[s+1] == 'm') // is it a manifest (batch)?
+	    {
+		s8* d = &cmd[s + 3];
+		s32 manifest_size = 0;
+		while(*d != '"')
+		{
+		    d++;
+		    manifest_size++;
+		}
+		mem_copy(&cmd[s + 3], manifest, manifest_size);
+		manifest_given = true;
+
+		s += manifest_size + 3;
+	    }
+	    else if(cmd[s+1] == 'u') // are there unicode ranges?
+	    {
+		s8* d = &cmd[s + 3];
+		s32 ranges_size = 0;
+		while(*d != '"')
+		{
+		    d++;
+		    ranges_size++;
+		}
+		if(ranges_size < BAKE_MAX_RANGES)
+		{
+		    mem_copy(&cmd[s + 3], ranges, ranges_size);
+		}
+		else
+		{
+		    success = false; // too long.
+		}
+
+		s += ranges_size + 3;
+	    }
+	    else if(cmd[s+1] == 'c') // is there a cache directory?
+	    {
+		s8* d = &cmd[s + 3];
+		s32 cache_size = 0;
+		while(*d != '"')
+		{
+		    d++;
+		    cache_size++;
+		}
+		if(cache_size < MAX_PATH)
+		{
+		    mem_copy(&cmd[s + 3], cache, cache_size);
+		}
+		else
+		{
+		    success = false; // too long.
+		}
+
+		s += cache_size + 3;
+	    }
+	    else if(cmd[s+1] == 'o') // is there a report?
+	    {
+		s8* d = &cmd[s + 3];
+		s32 report_size = 0;
+		while(*d != '"')
+		{
+		    d++;
+		    report_size++;
+		}
+		if(report_size < MAX_PATH)
+		{
+		    mem_copy(&cmd[s + 3], report, report_size);
+		}
+		else
+		{
+		    success = false; // too long.
+		}
+
+		s += report_size + 3;
+	    }
+	    else if(cmd[s+1] == 'w') // is it a server (named pipe, or - for the standard input)?
+	    {
+		s8* d = &cmd[s + 3];
+		s32 server_size = 0;
+		while(*d != '"')
+		{
+		    d++;
+		    server_size++;
+		}
+		if(server_size < MAX_PATH)
+		{
+		    mem_copy(&cmd[s + 3], server, server_size);
+		    server_given = true;
+		}
+		else
+		{
+		    success = false; // too long.
+		}
+
+		s += server_size + 3;
+	    }
 
 	    found_arg = false;
 	}
 
-	if(!(s < size))
+	s++;
+    }
+    
+    return(success && (manifest_given || server_given || (ttf_given && font_given && height_given)));
+}
+
+// Serve
+//
+// -w"-" serves the standard input, anything else is the name of a named pipe ("\\.\pipe\atlas_baked").
+// Every connection gets a pipe instance and a thread, a 'quit' from any of them sets 'quit' and everything
+// waiting on the pipes gives up (the pipes are overlapped so a wait can be cut short).
+//
+
+#define WINDOWS_MAX_CLIENTS 64
+
+struct windows_connection
+{
+    HANDLE input;
+    HANDLE output;
+    HANDLE event; // overlapped pipe, 0 = the standard handles.
+};
+struct windows_client
+{
+    std::thread        thread;
+    windows_connection connection;
+    b32                active;
+};
+struct windows_server
+{
+    std::mutex     mutex; // 'clients'.
+    windows_client clients[WINDOWS_MAX_CLIENTS];
+    HANDLE         quit;  // manual reset event.
+};
+
+global windows_server windows_listen;
+
+// waits for the overlapped operation, false when it failed or the server is quitting.
+internal b32
+windows_wait(windows_connection* connection, OVERLAPPED* overlapped, DWORD* bytes)
+{
+    HANDLE events[2] = { connection->event, windows_listen.quit };
+    if(WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+    {
+	CancelIoEx(connection->input, overlapped);
+	GetOverlappedResult(connection->input, overlapped, bytes, TRUE);
+	return(false);
+    }
+    return(GetOverlappedResult(connection->input, overlapped, bytes, FALSE));
+}
+internal s32
+windows_read(void* data, s8* buffer, s32 size)
+{
+    windows_connection* connection = (windows_connection*)data;
+
+    DWORD bytes_read = 0;
+    if(!connection->event)
+    {
+	return(ReadFile(connection->input, buffer, size, &bytes_read, 0) ? (s32)bytes_read : -1);
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = connection->event;
+    if(!ReadFile(connection->input, buffer, size, 0, &overlapped) && GetLastError() != ERROR_IO_PENDING) { return(-1); }
+    return(windows_wait(connection, &overlapped, &bytes_read) ? (s32)bytes_read : -1);
+}
+internal b32
+windows_write(void* data, const s8* text, s32 size)
+{
+    windows_connection* connection = (windows_connection*)data;
+
+    DWORD bytes_written = 0;
+    if(!connection->event)
+    {
+	return(WriteFile(connection->output, text, size, &bytes_written, 0) && (bytes_written == (DWORD)size));
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = connection->event;
+    if(!WriteFile(connection->output, text, size, 0, &overlapped) && GetLastError() != ERROR_IO_PENDING) { return(false); }
+    return(GetOverlappedResult(connection->output, &overlapped, &bytes_written, TRUE) && (bytes_written == (DWORD)size));
+}
+internal void
+windows_serveclient(s32 c)
+{
+    windows_client* client = &windows_listen.clients[c];
+    if(!server_connection(&client->connection, windows_read, windows_write))
+    {
+	SetEvent(windows_listen.quit); // quit, 'ConnectNamedPipe' and every read give up.
+    }
+
+    std::unique_lock<std::mutex> lock(windows_listen.mutex);
+    DisconnectNamedPipe(client->connection.input);
+    CloseHandle(client->connection.input);
+    CloseHandle(client->connection.event);
+    client->active = false;
+}
+internal b32
+windows_serve(s8* address)
+{
+    if(!server_startup(address)) { return(false); }
+
+    b32 success = true;
+    if(strcmp(address, "-") == 0)
+    {
+	windows_connection connection = { GetStdHandle(STD_INPUT_HANDLE), GetStdHandle(STD_OUTPUT_HANDLE), 0 };
+	server_connection(&connection, windows_read, windows_write);
+    }
+    else
+    {
+	windows_listen.quit = CreateEventA(0, TRUE, FALSE, 0);
+	while(success)
 	{
-	    success = false;
-	    break;
+	    windows_connection connection = {};
+	    connection.event = CreateEventA(0, TRUE, FALSE, 0);
+	    connection.input = CreateNamedPipeA(address, PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+						PIPE_UNLIMITED_INSTANCES, 4096, 4096, 0, 0);
+	    connection.output = connection.input;
+	    if(connection.input == INVALID_HANDLE_VALUE || !connection.event)
+	    {
+		platform_debugprint("'CreateNamedPipeA' failed!\n");
+		if(connection.event) { CloseHandle(connection.event); }
+		success = false;
+		break;
+	    }
+
+	    // waits for a client (or 'quit').
+	    OVERLAPPED overlapped = {};
+	    overlapped.hEvent = connection.event;
+	    DWORD unused      = 0;
+	    b32   connected   = ConnectNamedPipe(connection.input, &overlapped);
+	    if(!connected && GetLastError() == ERROR_IO_PENDING) { connected = windows_wait(&connection, &overlapped, &unused); }
+	    else if(!connected)                                  { connected = (GetLastError() == ERROR_PIPE_CONNECTED); }
+
+	    std::unique_lock<std::mutex> lock(windows_listen.mutex);
+	    s32 c = 0;
+	    while(c < WINDOWS_MAX_CLIENTS && windows_listen.clients[c].active) { c++; }
+	    if(!connected || c == WINDOWS_MAX_CLIENTS || WaitForSingleObject(windows_listen.quit, 0) == WAIT_OBJECT_0)
+	    {
+		if(c == WINDOWS_MAX_CLIENTS) { platform_debugprint("'windows_serve' failed! (too many clients)\n"); }
+		CloseHandle(connection.input);
+		CloseHandle(connection.event);
+		if(WaitForSingleObject(windows_listen.quit, 0) == WAIT_OBJECT_0) { break; }
+		continue;
+	    }
+	    windows_client* client = &windows_listen.clients[c];
+	    if(client->thread.joinable()) { client->thread.join(); }
+	    client->connection = connection;
+	    client->active     = true;
+	    client->thread     = std::thread(windows_serveclient, c);
 	}
+
+	// the other clients stop reading, a bake that's running is finished and answered first.
+	SetEvent(windows_listen.quit);
+	for(s32 c = 0; c < WINDOWS_MAX_CLIENTS; c++)
+	{
+	    if(windows_listen.clients[c].thread.joinable()) { windows_listen.clients[c].thread.join(); }
+	}
+	CloseHandle(windows_listen.quit);
     }
-    
+
+    server_shutdown();
     return(success);
 }
 
@@ -767,18 +754,10 @@ LRESULT WINAPI windows_procedure_message(HWND window, UINT message, WPARAM wpara
 	{
 	    GetWindowTextA(window_truetype_field, open_file, MAX_PATH);
 	    GetWindowTextA(window_save_field, save_file, MAX_PATH);
-	    GetWindowTextA(window_fontheight_field, fontheight_field, 3);
+	    GetWindowTextA(window_fontheight_field, fontheight_field, sizeof(fontheight_field));
 
 	    // bitmap.
-	    mem_copy(save_file, bitmap_file, MAX_PATH);
-	    s32 len = (s32)strlen(bitmap_file);
-	    if(len > 4)
-	    {
-		bitmap_file[len - 1] = '\0';
-		bitmap_file[len - 2] = 'p';
-		bitmap_file[len - 3] = 'm';
-		bitmap_file[len - 4] = 'b';
-	    }
+	    bitmap_path(save_file, bitmap_file);
 	    
 	    if(bake_font())
 	    {
@@ -836,6 +815,9 @@ WinMain (HINSTANCE          instance,
 
 	if(RegisterClassA(&window_class))
 	{
+	    simd_startup(SIMD_BEST);
+	    work_startup(bake_threads);
+
 	    RECT window_rect = {
 		(GetSystemMetrics(SM_CXSCREEN) - window_width )/2,
 		(GetSystemMetrics(SM_CYSCREEN) - window_height)/2,
@@ -879,6 +861,9 @@ WinMain (HINSTANCE          instance,
 	    {
 		OutputDebugStringA("'CreateWindowA' failed!\n");
 	    }
+	    work_shutdown();
+	    bake_releasememory();
+
 	    UnregisterClassA(window_class.lpszClassName, instance);
 	}
 	else
@@ -901,12 +886,37 @@ WinMain (HINSTANCE          instance,
 
 	s32 size = lstrlen(commandline);
 
-	if(bake_parsecommandline(commandline, size, open_file, save_file, fontheight_field))
+	if(bake_parsecommandline(commandline, size, open_file, save_file, fontheight_field, &bake_threads, &bake_padding, &bake_bleed, &bake_spread, &bake_levels, &bake_quality, &bake_chunk, &bake_maxtexture, &bake_flush, &bake_embed, &bake_format, manifest_file, bake_ranges, bake_cache, bake_report, server_address))
 	{
-	    bake_font();
+	    b32 success = false;
+	    simd_startup(SIMD_BEST);
+	    work_startup(bake_threads);
+	    if(server_address[0])
+	    {
+		success = windows_serve(server_address);
+	    }
+	    else if(manifest_file[0])
+	    {
+		s32 baked = 0;
+		s32 jobs  = 0;
+		success = bake_manifest(manifest_file, &baked, &jobs);
+	    }
+	    else
+	    {
+		bitmap_path(save_file, bitmap_file);
+		success = bake_font();
+	    }
+	    work_shutdown();
+	    bake_releasememory();
 
-	    const s8* message = "success!";
-	    s32 message_size = sizeof("succes!");
+	    // the report went to standard output, keep it json only. a server answered every request on its own.
+	    if(strcmp(bake_report, "-") == 0 || server_address[0])
+	    {
+		return(success ? 0 : 1);
+	    }
+
+	    const s8* message = success ? "success!" : "failed!";
+	    s32 message_size = (s32)strlen(message);
 
 	    DWORD bytes_written = 0;
 	    if(WriteFile(output_handle, message, message_size, &bytes_written, 0))
@@ -917,11 +927,21 @@ WinMain (HINSTANCE          instance,
 	    {
 		// ???
 	    }
+
+	    s8 memory_message[128] = {};
+	    s32 memory_message_size = snprintf(memory_message, sizeof(memory_message),
+					       "\npeak memory: %llu KiB (%llu KiB reserved, %u os allocations)\n",
+					       (unsigned long long)(bake_lastmemory.peak / 1024),
+					       (unsigned long long)(bake_lastmemory.reserved / 1024),
+					       bake_lastmemory.allocations);
+	    WriteFile(output_handle, memory_message, memory_message_size, &bytes_written, 0);
+
+	    if(!success) { return(1); }
 	}
 	else
 	{
-	    const s8* message = "error: did you provide all three arguments?\n   -ttf (truetype font file)\n   -s (save location)\n   -h (font height)\n";
-	    s32 message_size = sizeof("error: did you provide all three arguments?\n   -ttf (truetype font file)\n   -s (save location)\n   -h (font height)\n");
+	    const s8* message = "error: did you provide all three arguments?\n   -ttf (truetype font file)\n   -s (save location)\n   -h (font height, 12+24+48 = one atlas of every size)\n   -j (threads, optional)\n   -p (padding, optional)\n   -b (bleed, optional)\n   -f (r8, rgba32, sdf, msdf or bc4, optional)\n   -m (manifest, instead of -ttf -s -h)\n   -u (unicode ranges, optional)\n   -r (sdf/msdf spread in pixels, optional)\n   -c (cache directory, optional)\n   -l (mip levels, optional)\n   -q (bc4 quality 0 -> 2, optional)\n   -z (compressed chunks in KiB, optional)\n   -x (max texture size in pixels, optional)\n   -y (1 = flush the outputs to the disk, optional)\n   -e (1 = also write the atlas as a c++ header, .h, optional)\n   -o (json report, - = standard output, optional)\n   -w (serve bake requests on a named pipe, - = standard input, instead of -ttf -s -h)\n";
+	    s32 message_size = sizeof("error: did you provide all three arguments?\n   -ttf (truetype font file)\n   -s (save location)\n   -h (font height, 12+24+48 = one atlas of every size)\n   -j (threads, optional)\n   -p (padding, optional)\n   -b (bleed, optional)\n   -f (r8, rgba32, sdf, msdf or bc4, optional)\n   -m (manifest, instead of -ttf -s -h)\n   -u (unicode ranges, optional)\n   -r (sdf/msdf spread in pixels, optional)\n   -c (cache directory, optional)\n   -l (mip levels, optional)\n   -q (bc4 quality 0 -> 2, optional)\n   -z (compressed chunks in KiB, optional)\n   -x (max texture size in pixels, optional)\n   -y (1 = flush the outputs to the disk, optional)\n   -e (1 = also write the atlas as a c++ header, .h, optional)\n   -o (json report, - = standard output, optional)\n   -w (serve bake requests on a named pipe, - = standard input, instead of -ttf -s -h)\n") - 1;
 
 	    DWORD bytes_written = 0;
 	    if(WriteFile(output_handle, message, message_size, &bytes_written, 0))
@@ -932,6 +952,7 @@ WinMain (HINSTANCE          instance,
 	    {
 		// ???
 	    }
+	    return(1);
 	}
     }
 
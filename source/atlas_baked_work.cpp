@@ -0,0 +1,211 @@
+// Work
+//
+// A small work-stealing pool.
+//
+// Jobs are plain indices (0 -> job_count), every thread owns a queue that is a single [next, end) range
+// packed into one 64-bit atomic. The owner takes jobs from the front, an idle thread steals the back half
+// of someone else's range. Both sides only ever 'compare_exchange' the whole range, so there are no locks
+// on the hot path.
+//
+// The calling thread is thread 0 and always takes part, 'work_run' returns once every job has finished.
+// With a thread count of 1 nothing is spawned and jobs run in order on the calling thread.
+// A 'work_run' from inside a job also runs in order on that thread (jobs can be split further, not spread).
+//
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#define WORK_MAX_THREADS 64
+
+typedef void work_function(void* data, s32 thread, s32 job);
+
+struct work_queue
+{
+    std::atomic<u64> range; // low 32 bits = next, high 32 bits = end.
+    u8 padding[64 - sizeof(std::atomic<u64>)]; // one queue per cache line.
+};
+struct work_pool
+{
+    s32 thread_count; // including the calling thread.
+    std::thread threads[WORK_MAX_THREADS];
+    work_queue  queues[WORK_MAX_THREADS];
+
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    u32 generation;
+    s32 active;
+    b32 quit;
+
+    work_function* function;
+    void*          data;
+};
+
+global work_pool work;
+
+thread_local s32 work_thread;  // index of the calling thread.
+thread_local b32 work_injob;   // inside a job, 'work_run' stays on this thread.
+
+internal u64 work_range(u32 next, u32 end) { return(((u64)end << 32) | next); }
+
+internal s32
+work_pop(work_queue* queue)
+{
+    u64 range = queue->range.load(std::memory_order_acquire);
+    for(;;)
+    {
+	u32 next = (u32)range;
+	u32 end  = (u32)(range >> 32);
+	if(next >= end) { return(-1); }
+
+	if(queue->range.compare_exchange_weak(range, work_range(next + 1, end), std::memory_order_acq_rel))
+	{
+	    return((s32)next);
+	}
+    }
+}
+// moves the back half of the victim's range into 'queue' (which must be empty), returns the first stolen job.
+internal s32
+work_steal(work_queue* victim, work_queue* queue)
+{
+    u64 range = victim->range.load(std::memory_order_acquire);
+    for(;;)
+    {
+	u32 next = (u32)range;
+	u32 end  = (u32)(range >> 32);
+	if(next >= end) { return(-1); }
+
+	u32 take  = ((end - next) + 1) / 2;
+	u32 split = end - take;
+	if(victim->range.compare_exchange_weak(range, work_range(next, split), std::memory_order_acq_rel))
+	{
+	    queue->range.store(work_range(split + 1, end), std::memory_order_release);
+	    return((s32)split);
+	}
+    }
+}
+internal void
+work_drain(s32 thread)
+{
+    work_queue* queue = &work.queues[thread];
+    for(;;)
+    {
+	s32 job = work_pop(queue);
+	if(job < 0)
+	{
+	    for(s32 v = 1; v < work.thread_count && job < 0; v++)
+	    {
+		job = work_steal(&work.queues[(thread + v) % work.thread_count], queue);
+	    }
+	    if(job < 0) { return; } // jobs never spawn jobs, every queue is empty.
+	}
+	work_injob = true;
+	work.function(work.data, thread, job);
+	work_injob = false;
+    }
+}
+internal void
+work_worker(s32 thread)
+{
+    work_thread = thread;
+
+    u32 generation = 0;
+    for(;;)
+    {
+	{
+	    std::unique_lock<std::mutex> lock(work.mutex);
+	    work.wake.wait(lock, [&]{ return(work.quit || work.generation != generation); });
+	    if(work.quit) { return; }
+	    generation = work.generation;
+	}
+
+	work_drain(thread);
+
+	{
+	    std::unique_lock<std::mutex> lock(work.mutex);
+	    if(--work.active == 0) { work.done.notify_one(); }
+	}
+    }
+}
+// 0 = one thread per core.
+internal void
+work_startup(s32 thread_count)
+{
+    if(thread_count <= 0)
+    {
+	thread_count = (s32)std::thread::hardware_concurrency();
+    }
+    if(thread_count < 1)                { thread_count = 1; }
+    if(thread_count > WORK_MAX_THREADS) { thread_count = WORK_MAX_THREADS; }
+
+    work.thread_count = thread_count;
+    work.generation   = 0;
+    work.quit         = false;
+    for(s32 thread = 1; thread < thread_count; thread++)
+    {
+	work.threads[thread] = std::thread(work_worker, thread);
+    }
+}
+internal void
+work_shutdown()
+{
+    {
+	std::unique_lock<std::mutex> lock(work.mutex);
+	work.quit = true;
+    }
+    work.wake.notify_all();
+
+    for(s32 thread = 1; thread < work.thread_count; thread++)
+    {
+	work.threads[thread].join();
+    }
+    work.thread_count = 0;
+}
+// the threads a 'work_run' from the calling thread hands jobs to, [first, first + count).
+internal s32
+work_span(s32* first)
+{
+    if(work.thread_count <= 1 || work_injob)
+    {
+	*first = work_thread;
+	return(1);
+    }
+    *first = 0;
+    return(work.thread_count);
+}
+internal void
+work_run(s32 job_count, work_function* function, void* data)
+{
+    if(work.thread_count <= 1 || work_injob)
+    {
+	for(s32 job = 0; job < job_count; job++)
+	{
+	    function(data, work_thread, job);
+	}
+	return;
+    }
+
+    {
+	std::unique_lock<std::mutex> lock(work.mutex);
+
+	// even split up front, stealing evens out whatever the glyphs don't.
+	for(s32 thread = 0; thread < work.thread_count; thread++)
+	{
+	    u32 next = (u32)(((s64)job_count *  thread     ) / work.thread_count);
+	    u32 end  = (u32)(((s64)job_count * (thread + 1)) / work.thread_count);
+	    work.queues[thread].range.store(work_range(next, end), std::memory_order_relaxed);
+	}
+	work.function = function;
+	work.data     = data;
+	work.active   = work.thread_count - 1;
+	work.generation++;
+    }
+    work.wake.notify_all();
+
+    work_drain(0);
+
+    std::unique_lock<std::mutex> lock(work.mutex);
+    work.done.wait(lock, []{ return(work.active == 0); });
+}
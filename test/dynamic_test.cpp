@@ -0,0 +1,438 @@
+// Dynamic cache test
+//
+// Fills the runtime glyph cache (atlas_baked_dynamic.cpp) with Lato from benchmark/fonts and checks:
+//
+//   fill      glyphs of mixed widths share shelves: ten glyphs at 96pt fit a 128x128 texture in one frame, and
+//             capitals fill it mostly (their padded spans) before the first glyph has to be evicted.
+//   lru       glyphs are evicted least recently used first, glyphs used again move to the back.
+//   frame     glyphs used this frame are never evicted, a full frame gets 0 for the rest.
+//   churn     a thousand frames of random codepoints, the shelves' free spans and the glyphs always add
+//             up to the texture and no two glyphs overlap.
+//   threads   on 'TEST_THREADS' threads, r8 and sdf: churn until glyphs are evicted, every glyph has the
+//             pixels and metrics of the same glyph in a bake (one with 'bake_font', one from a manifest with
+//             'bake_manifest') and every glyph placed is in a dirty rect. The r8 texture is written to the
+//             output directory as dynamic_test.bmp to look at.
+//
+// build (linux):
+// g++ -O2 -I<path to Handmade> test/dynamic_test.cpp -o "build/dynamic_test" -lm -pthread
+//
+// usage (from the repository):
+// dynamic_test [fonts directory] [output directory]
+//
+
+#define ATLAS_BAKED_NO_MAIN
+#define ATLAS_BAKED_DYNAMIC
+#include "../source/atlas_baked_linux.cpp"
+#include "../source/atlas_baked_reader.h"
+
+#define TEST_SIZE      128   // texture, pixels on either side.
+#define TEST_POINTS    96.0f
+#define TEST_GLYPHS    256   // glyph entries, more than ever fit.
+#define TEST_OCCUPANCY 0.6f  // of the texture, taken by glyph spans once the first glyph is evicted.
+#define TEST_THREADS   4
+
+global s32 test_failures;
+
+internal b32
+test_check(b32 condition, const s8* test, const s8* what)
+{
+    if(!condition)
+    {
+	printf("%-6s failed: %s\n", test, what);
+	test_failures++;
+    }
+    return(condition);
+}
+internal b32
+test_cached(dynamic_cache* cache, u32 codepoint)
+{
+    return(dynamic_find(cache, codepoint) != 0);
+}
+// the texture taken by the glyphs' spans (their shelf's height each), 0 -> 1.
+internal r32
+test_occupancy(dynamic_cache* cache)
+{
+    u64 taken = 0;
+    for(s32 g = 0; g < cache->glyph_capacity; g++)
+    {
+	dynamic_glyph* glyph = &cache->glyphs[g];
+	if(glyph->codepoint != DYNAMIC_EMPTY && glyph->shelf != DYNAMIC_NONE)
+	{
+	    taken += (u64)glyph->span * cache->shelves[glyph->shelf].height;
+	}
+    }
+    return((r32)taken / (cache->atlas.width * cache->atlas.height));
+}
+// every shelf's free spans are sorted, merged and, with its glyphs' spans, exactly its width. no two glyphs overlap.
+internal b32
+test_consistent(dynamic_cache* cache)
+{
+    s32 shelf_used [TEST_SIZE / DYNAMIC_CLASS] = {};
+    s32 shelf_taken[TEST_SIZE / DYNAMIC_CLASS] = {};
+    for(s32 g = 0; g < cache->glyph_capacity; g++)
+    {
+	dynamic_glyph* glyph = &cache->glyphs[g];
+	if(glyph->codepoint == DYNAMIC_EMPTY || glyph->shelf == DYNAMIC_NONE) { continue; }
+	if(glyph->shelf >= cache->shelf_count || glyph->x < 0 || (glyph->x + glyph->span) > cache->atlas.width) { return(false); }
+
+	shelf_used [glyph->shelf]++;
+	shelf_taken[glyph->shelf] += glyph->span;
+	for(s32 other = g + 1; other < cache->glyph_capacity; other++)
+	{
+	    dynamic_glyph* next = &cache->glyphs[other];
+	    if(next->codepoint == DYNAMIC_EMPTY || next->shelf != glyph->shelf) { continue; }
+	    if(next->x < (glyph->x + glyph->span) && glyph->x < (next->x + next->span)) { return(false); }
+	}
+    }
+    for(s32 s = 0; s < cache->shelf_count; s++)
+    {
+	dynamic_shelf* shelf = &cache->shelves[s];
+	s32 free_width = 0;
+	for(s32 span = 0; span < shelf->span_count; span++)
+	{
+	    dynamic_span* current = &shelf->spans[span];
+	    if(current->width <= 0 || current->x < 0 || (current->x + current->width) > cache->atlas.width) { return(false); }
+	    if(span > 0 && (shelf->spans[span - 1].x + shelf->spans[span - 1].width) >= current->x)    { return(false); }
+	    free_width += current->width;
+	}
+	if(shelf->used != shelf_used[s] || (free_width + shelf_taken[s]) != cache->atlas.width) { return(false); }
+    }
+    return(true);
+}
+internal void
+test_fill(ttf_font* font)
+{
+    dynamic_cache cache;
+    if(!test_check(dynamic_create(&cache, font, TEST_POINTS, FONT_FORMAT_R8, 4, TEST_SIZE, TEST_SIZE, TEST_GLYPHS), "fill", "'dynamic_create'")) { return; }
+
+    // mixed widths and heights, one frame.
+    u32            codepoints[10] = { 'A', 'g', 'W', 'i', '0', 'm', '.', 'Q', 'y', '%' };
+    dynamic_glyph* glyphs[10];
+    test_check(dynamic_ensure(&cache, codepoints, 10, glyphs) == 10, "fill", "ten glyphs didn't fit one frame");
+    test_check(test_consistent(&cache), "fill", "shelves are inconsistent");
+    dynamic_nextframe(&cache);
+
+    // then a capital a frame until the first eviction.
+    r32 occupancy = 0.0f;
+    s32 count     = 10;
+    for(u32 codepoint = 'B'; codepoint <= 'Z' && occupancy == 0.0f; codepoint++)
+    {
+	if(test_cached(&cache, codepoint)) { continue; }
+
+	r32 before = test_occupancy(&cache);
+	dynamic_glyph* glyph = 0;
+	dynamic_ensure(&cache, &codepoint, 1, &glyph);
+	dynamic_nextframe(&cache);
+	test_check(glyph != 0, "fill", "a glyph didn't fit with older glyphs to evict");
+
+	for(s32 c = 0; c < 10; c++)
+	{
+	    if(!test_cached(&cache, codepoints[c])) { occupancy = before; }
+	}
+	count += (occupancy == 0.0f) ? 1 : 0;
+    }
+    test_check(test_consistent(&cache), "fill", "shelves are inconsistent");
+    test_check(occupancy >= TEST_OCCUPANCY, "fill", "the texture was mostly empty when the first glyph was evicted");
+    printf("fill   %d glyphs, %.0f%% of the texture taken at the first eviction\n", count, occupancy * 100.0f);
+    dynamic_destroy(&cache);
+}
+internal void
+test_lru(ttf_font* font)
+{
+    dynamic_cache cache;
+    if(!test_check(dynamic_create(&cache, font, TEST_POINTS, FONT_FORMAT_R8, 4, TEST_SIZE, TEST_SIZE, TEST_GLYPHS), "lru", "'dynamic_create'")) { return; }
+
+    // a frame each, in order: that's the lru order too.
+    u32 order[TEST_GLYPHS];
+    s32 order_count = 0;
+    for(u32 codepoint = 'a'; codepoint <= 'l'; codepoint++)
+    {
+	dynamic_glyph* glyph = 0;
+	dynamic_ensure(&cache, &codepoint, 1, &glyph);
+	dynamic_nextframe(&cache);
+	if(glyph) { order[order_count++] = codepoint; }
+    }
+    test_check(order_count == 12, "lru", "twelve lowercase glyphs didn't fit");
+
+    // the three oldest are used again, they go to the back.
+    dynamic_glyph* touched[3];
+    test_check(dynamic_ensure(&cache, order, 3, touched) == 3, "lru", "cached glyphs weren't found");
+    dynamic_nextframe(&cache);
+    u32 used[3] = { order[0], order[1], order[2] };
+    memmove(order, order + 3, (order_count - 3) * sizeof(u32));
+    mem_copy(used, order + order_count - 3, sizeof(used));
+
+    // new glyphs push the oldest out: what's evicted is always the front of 'order'.
+    s32 evicted = 0;
+    for(u32 codepoint = 'A'; codepoint <= 'Z'; codepoint++)
+    {
+	dynamic_glyph* glyph = 0;
+	dynamic_ensure(&cache, &codepoint, 1, &glyph);
+	dynamic_nextframe(&cache);
+	if(glyph) { order[order_count++] = codepoint; }
+
+	b32 present = false;
+	b32 prefix  = true;
+	evicted     = 0;
+	for(s32 o = 0; o < order_count; o++)
+	{
+	    b32 cached = test_cached(&cache, order[o]);
+	    if(cached)  { present = true; }
+	    else        { evicted++; prefix = prefix && !present; }
+	}
+	if(!test_check(prefix, "lru", "a glyph was evicted before an older one")) { break; }
+    }
+    test_check(evicted > 3, "lru", "nothing was evicted");
+    test_check(test_consistent(&cache), "lru", "shelves are inconsistent");
+    printf("lru    %d glyphs in order, %d evicted oldest first\n", order_count, evicted);
+    dynamic_destroy(&cache);
+}
+internal void
+test_frame(ttf_font* font)
+{
+    dynamic_cache cache;
+    if(!test_check(dynamic_create(&cache, font, TEST_POINTS, FONT_FORMAT_R8, 4, TEST_SIZE, TEST_SIZE, TEST_GLYPHS), "frame", "'dynamic_create'")) { return; }
+
+    // more than fit, all in one frame.
+    u32            codepoints[94];
+    dynamic_glyph* glyphs[94];
+    for(s32 c = 0; c < 94; c++)
+    {
+	codepoints[c] = '!' + c;
+    }
+    s32 found = dynamic_ensure(&cache, codepoints, 94, glyphs);
+
+    s32 kept = 0;
+    for(s32 c = 0; c < 94; c++)
+    {
+	if(glyphs[c] && glyphs[c]->codepoint == codepoints[c] && glyphs[c]->frame == cache.frame) { kept++; }
+    }
+    test_check(found > 10 && found < 94, "frame", "a full texture took every glyph, or hardly any");
+    test_check(kept == found, "frame", "a glyph of this frame was evicted");
+    test_check(test_consistent(&cache), "frame", "shelves are inconsistent");
+    printf("frame  %d of 94 glyphs in one frame, none evicted\n", found);
+    dynamic_destroy(&cache);
+}
+internal void
+test_churn(ttf_font* font)
+{
+    dynamic_cache cache;
+    if(!test_check(dynamic_create(&cache, font, TEST_POINTS / 2, FONT_FORMAT_R8, 4, TEST_SIZE, TEST_SIZE, 64), "churn", "'dynamic_create'")) { return; }
+
+    u32 random = 1;
+    b32 consistent = true;
+    for(s32 frame = 0; frame < 1000 && consistent; frame++)
+    {
+	u32            codepoints[8];
+	dynamic_glyph* glyphs[8];
+	for(s32 c = 0; c < 8; c++)
+	{
+	    random = (random * 1664525u) + 1013904223u;
+	    codepoints[c] = 0x20 + ((random >> 8) % (0x250 - 0x20));
+	}
+	dynamic_ensure(&cache, codepoints, 8, glyphs);
+	dynamic_nextframe(&cache);
+	consistent = test_consistent(&cache);
+    }
+    test_check(consistent, "churn", "shelves are inconsistent");
+    printf("churn  1000 frames, %d shelves, %.0f%% of the texture taken\n", cache.shelf_count, test_occupancy(&cache) * 100.0f);
+    dynamic_destroy(&cache);
+}
+// 'glyph' against the same codepoint baked into 'reference', the size, spacing and every pixel.
+internal b32
+test_samepixels(dynamic_cache* cache, dynamic_glyph* glyph, atlas_font* reference)
+{
+    const atlas_glyph* baked = atlas_findglyph(reference, glyph->codepoint);
+    glyph_header*      mine  = &glyph->header;
+    if(!baked || baked->width != mine->width || baked->height != mine->height ||
+       baked->spacing != mine->spacing || baked->pre_spacing != mine->pre_spacing)
+    {
+	return(false);
+    }
+
+    s32 bytes = bake_bytesperpixel(cache->atlas.format);
+    s32 x     = (s32)((mine->u0 * cache->atlas.width)  + 0.5f);
+    s32 y     = (s32)((mine->v1 * cache->atlas.height) + 0.5f);
+    s32 bx    = (s32)((baked->u0 * reference->width)  + 0.5f);
+    s32 by    = (s32)((baked->v1 * reference->height) + 0.5f);
+    for(s32 row = 0; row < mine->height; row++)
+    {
+	u8*       pixels = cache->pixels + ((((y + row) * cache->atlas.width) + x) * bytes);
+	const u8* expect = reference->pixels + ((((by + row) * reference->width) + bx) * bytes);
+	if(memcmp(pixels, expect, mine->width * bytes) != 0) { return(false); }
+    }
+    return(true);
+}
+// 'glyph' is inside one of the 'rects'.
+internal b32
+test_dirty(dynamic_cache* cache, dynamic_glyph* glyph, dynamic_rect* rects, s32 rect_count)
+{
+    dynamic_shelf* shelf = &cache->shelves[glyph->shelf];
+    for(s32 r = 0; r < rect_count; r++)
+    {
+	dynamic_rect* rect = &rects[r];
+	if(rect->y <= shelf->y && (shelf->y + shelf->height) <= (rect->y + rect->height) &&
+	   rect->x <= glyph->x && (glyph->x + glyph->span) <= (rect->x + rect->width))
+	{
+	    return(true);
+	}
+    }
+    return(false);
+}
+// churns a cache of 'format' at 'points' on every thread, checking it against 'reference' every frame.
+internal void
+test_churnpixels(ttf_font* font, const s8* test, u32 format, r32 points, s8* reference_file, s8* bitmap_file)
+{
+    atlas_font reference;
+    if(!test_check(atlas_open(&reference, reference_file), test, "the reference bake couldn't be opened")) { return; }
+
+    dynamic_cache cache;
+    if(!test_check(dynamic_create(&cache, font, points, format, bake_spread, TEST_SIZE, TEST_SIZE, TEST_GLYPHS), test, "'dynamic_create'"))
+    {
+	atlas_close(&reference);
+	return;
+    }
+
+    u32 random   = 7;
+    s32 placed   = 0;
+    s32 evicted  = 0;
+    b32 same     = true;
+    b32 dirty    = true;
+    b32 consistent = true;
+    for(s32 frame = 0; frame < 200 && same && dirty && consistent; frame++)
+    {
+	// a batch big enough to be spread over the threads, ascii so the bake has every glyph.
+	u32            codepoints[24];
+	dynamic_glyph* glyphs[24];
+	b32            fresh[24];
+	for(s32 c = 0; c < 24; c++)
+	{
+	    random = (random * 1664525u) + 1013904223u;
+	    codepoints[c] = '!' + ((random >> 8) % ('~' - '!' + 1));
+	}
+	s32 before = 0;
+	for(s32 g = 0; g < cache.glyph_capacity; g++) { before += (cache.glyphs[g].codepoint != DYNAMIC_EMPTY) ? 1 : 0; }
+	for(s32 c = 0; c < 24; c++) { fresh[c] = !test_cached(&cache, codepoints[c]); }
+
+	dynamic_ensure(&cache, codepoints, 24, glyphs);
+
+	dynamic_rect rects[TEST_SIZE / DYNAMIC_CLASS];
+	s32 rect_count = dynamic_dirtyrects(&cache, rects, TEST_SIZE / DYNAMIC_CLASS);
+	s32 added      = 0;
+	for(s32 c = 0; c < 24; c++)
+	{
+	    if(!glyphs[c]) { continue; }
+
+	    same = same && test_samepixels(&cache, glyphs[c], &reference);
+	    if(fresh[c] && glyphs[c]->shelf != DYNAMIC_NONE)
+	    {
+		dirty = dirty && test_dirty(&cache, glyphs[c], rects, rect_count);
+		fresh[c] = false; // a codepoint can be in the batch twice.
+		added++;
+	    }
+	}
+	s32 after = 0;
+	for(s32 g = 0; g < cache.glyph_capacity; g++) { after += (cache.glyphs[g].codepoint != DYNAMIC_EMPTY) ? 1 : 0; }
+
+	placed    += added;
+	evicted   += before + added - after;
+	consistent = test_consistent(&cache);
+	dynamic_nextframe(&cache);
+    }
+    test_check(same, test, "a glyph isn't the bake's");
+    test_check(dirty, test, "a placed glyph isn't in a dirty rect");
+    test_check(consistent, test, "shelves are inconsistent");
+    test_check(evicted > 0, test, "nothing was evicted");
+    printf("%-6s %d threads, %d glyphs placed, %d evicted, checked against the bake\n", test, work.thread_count, placed, evicted);
+
+    // the texture, to look at.
+    if(bitmap_file)
+    {
+	b32 written = false;
+	output_startup();
+	output_request* request = output_begin();
+	if(bitmap_saveas(request, bitmap_file, cache.atlas.width, cache.atlas.height, bake_bytesperpixel(format) * 8, (s8*)cache.pixels, 1, 0))
+	{
+	    request->written = &written;
+	    output_submit(request);
+	    output_wait();
+	}
+	else
+	{
+	    output_cancel(request);
+	}
+	output_shutdown();
+	test_check(written, test, "the texture couldn't be written");
+    }
+    dynamic_destroy(&cache);
+    atlas_close(&reference);
+}
+// the reference bakes the command line's way, then the caches on 'TEST_THREADS' threads.
+internal void
+test_threads(ttf_font* font, s8* ttf_file, s8* output_dir)
+{
+    bake_threads = TEST_THREADS;
+    work_shutdown();
+    work_startup(bake_threads);
+
+    s8 r8_file [MAX_PATH];
+    s8 sdf_file[MAX_PATH];
+    s8 bitmap  [MAX_PATH];
+    snprintf(r8_file,  MAX_PATH, "%s/dynamic_test_r8.font",  output_dir);
+    snprintf(sdf_file, MAX_PATH, "%s/dynamic_test_sdf.font", output_dir);
+    snprintf(bitmap,   MAX_PATH, "%s/dynamic_test.bmp",      output_dir);
+
+    // r8 at 'TEST_POINTS' like -ttf -s -h.
+    snprintf(open_file, MAX_PATH, "%s", ttf_file);
+    snprintf(save_file, MAX_PATH, "%s", r8_file);
+    bitmap_path(save_file, bitmap_file);
+    snprintf(fontheight_field, sizeof(fontheight_field), "%.0f", TEST_POINTS);
+    bake_format = FONT_FORMAT_R8;
+    b32 baked_r8 = bake_font();
+
+    // sdf at half of it from a manifest like -m.
+    s8  manifest[MAX_PATH * 3];
+    s32 manifest_size = snprintf(manifest, sizeof(manifest), "\"%s\" %.0f \"%s\"\n", ttf_file, TEST_POINTS / 2, sdf_file);
+    snprintf(manifest_file, MAX_PATH, "%s/dynamic_test.txt", output_dir);
+    s32 baked = 0;
+    s32 jobs  = 0;
+    bake_format = FONT_FORMAT_SDF;
+    b32 baked_sdf = platform_writefile(manifest_file, manifest_size, manifest) && bake_manifest(manifest_file, &baked, &jobs);
+    bake_format = FONT_FORMAT_R8;
+    bake_releasememory();
+
+    if(test_check(baked_r8,  "r8",  "'bake_font'"))     { test_churnpixels(font, "r8",  FONT_FORMAT_R8,  TEST_POINTS,     r8_file,  bitmap); }
+    if(test_check(baked_sdf, "sdf", "'bake_manifest'")) { test_churnpixels(font, "sdf", FONT_FORMAT_SDF, TEST_POINTS / 2, sdf_file, 0);      }
+}
+
+s32
+main(s32 argument_count, s8** arguments)
+{
+    s8* fonts      = (argument_count > 1) ? arguments[1] : (s8*)"benchmark/fonts";
+    s8* output_dir = (argument_count > 2) ? arguments[2] : (s8*)"build";
+
+    simd_startup(SIMD_BEST);
+    work_startup(1);
+    platform_makedirectory(output_dir);
+
+    s8 path[MAX_PATH];
+    snprintf(path, MAX_PATH, "%s/Lato-Regular.ttf", fonts);
+    bake_source source = {};
+    if(!bake_opensource(&source, path))
+    {
+	fputs("Lato-Regular.ttf is missing or malformed!\n", stderr);
+	return(1);
+    }
+
+    test_fill (&source.font);
+    test_lru  (&source.font);
+    test_frame(&source.font);
+    test_churn(&source.font);
+    test_threads(&source.font, path, output_dir);
+
+    bake_closesource(&source);
+    work_shutdown();
+
+    if(test_failures) { fprintf(stderr, "%d failed!\n", test_failures); }
+    return(test_failures ? 1 : 0);
+}